@@ -1,4 +1,5 @@
 #include <jni.h>
+#include <android/log.h>
 #include <unistd.h>
 #include <__memory/unique_ptr.h>
 
@@ -189,6 +190,10 @@ void aeolus_synth_noteoff( int chan, int key, int vel)
         {
             aeolus_synth_noteoff( data[0] &0x0F, data[1], data[2]);
         }
+        if(((data[0] & 0xF0) >> 4) ==  kMIDIChanCmd_PitchWheel && numBytes>=3 && synth != nullptr)
+        {
+            synth->pitchBend( data[0] &0x0F, data[1] | (data[2] << 7));
+        }
     }
 
 }
@@ -388,4 +393,311 @@ Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_setActiveStopsForDiv
                                                                                       jlong stop_states_for_division) {
     synth->setStopActivationBitmask(division_index,stop_states_for_division);
 
-}
\ No newline at end of file
+}
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_getCallbackStatistics(JNIEnv *env,
+                                                                                  jclass clazz) {
+    const int n_fields=5;
+    jlong values[n_fields+Aeolussynthesizer::AeolusCallbackStats::histogramBuckets]={};
+    if(synth!= nullptr)
+    {
+        Aeolussynthesizer::AeolusCallbackStats::Snapshot stats=synth->getCallbackStatistics();
+        values[0]=(jlong) stats.callbacks;
+        values[1]=(jlong) stats.framesRendered;
+        values[2]=(jlong) stats.deadlineMisses;
+        values[3]=(jlong) stats.worstNanoseconds;
+        values[4]=(jlong) stats.totalNanoseconds;
+        for(int i=0; i<Aeolussynthesizer::AeolusCallbackStats::histogramBuckets; i++)
+        {
+            values[n_fields+i]=(jlong) stats.histogram[i];
+        }
+    }
+    jsize length=n_fields+Aeolussynthesizer::AeolusCallbackStats::histogramBuckets;
+    jlongArray result=env->NewLongArray(length);
+    env->SetLongArrayRegion(result,0,length,values);
+    return result;
+}
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_resetCallbackStatistics(JNIEnv *env,
+                                                                                    jclass clazz) {
+    if(synth!= nullptr)
+    {
+        synth->resetCallbackStatistics();
+    }
+}
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_setRenderProfiling(JNIEnv *env,
+                                                                               jclass clazz,
+                                                                               jboolean enabled) {
+    synth->setRenderProfiling(enabled);
+}
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_getRenderProfileSummary(JNIEnv *env,
+                                                                                    jclass clazz) {
+    return env->NewStringUTF(synth->getRenderProfileSummary().c_str());
+}
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_setParallelRendering(JNIEnv *env,
+                                                                                 jclass clazz,
+                                                                                 jboolean enabled) {
+    synth->setParallelRendering(enabled);
+}
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_isParallelRendering(JNIEnv *env,
+                                                                                jclass clazz) {
+    return synth->isParallelRendering();
+}
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_setRenderAhead(JNIEnv *env,
+                                                                           jclass clazz,
+                                                                           jint periods) {
+    synth->setRenderAhead(periods);
+}
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_getRenderAhead(JNIEnv *env,
+                                                                           jclass clazz) {
+    return synth->getRenderAhead();
+}
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_getRenderAheadLatencyFrames(JNIEnv *env,
+                                                                                        jclass clazz) {
+    return synth->getRenderAheadLatencyFrames();
+}
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_getRenderAheadUnderruns(JNIEnv *env,
+                                                                                    jclass clazz) {
+    return (jlong) synth->getRenderAheadUnderruns();
+}
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_setDivisionCulling(JNIEnv *env,
+                                                                               jclass clazz,
+                                                                               jboolean enabled) {
+    synth->setDivisionCulling(enabled);
+}
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_isDivisionCulling(JNIEnv *env,
+                                                                              jclass clazz) {
+    return synth->isDivisionCulling();
+}
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_getDivisionActivitySummary(JNIEnv *env,
+                                                                                       jclass clazz) {
+    return env->NewStringUTF(synth->getDivisionActivitySummary().c_str());
+}
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_setStopWarmUp(JNIEnv *env,
+                                                                          jclass clazz,
+                                                                          jboolean enabled) {
+    synth->setStopWarmUp(enabled);
+}
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_isStopWarmUp(JNIEnv *env,
+                                                                         jclass clazz) {
+    return synth->isStopWarmUp();
+}
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_setWavetableLocking(JNIEnv *env,
+                                                                                jclass clazz,
+                                                                                jboolean locking) {
+    synth->setWavetableLocking(locking);
+}
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_getStopWarmUpSummary(JNIEnv *env,
+                                                                                 jclass clazz) {
+    return env->NewStringUTF(synth->getStopWarmUpSummary().c_str());
+}
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_setRegistrationChangesPerPeriod(JNIEnv *env,
+                                                                                            jclass clazz,
+                                                                                            jint changes) {
+    synth->setRegistrationChangesPerPeriod(changes);
+}
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_getRegistrationChangesPerPeriod(JNIEnv *env,
+                                                                                            jclass clazz) {
+    return synth->getRegistrationChangesPerPeriod();
+}
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_setIncrementalKeyUpdate(JNIEnv *env,
+                                                                                    jclass clazz,
+                                                                                    jboolean enabled) {
+    synth->setIncrementalKeyUpdate(enabled);
+}
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_isIncrementalKeyUpdate(JNIEnv *env,
+                                                                                   jclass clazz) {
+    return synth->isIncrementalKeyUpdate();
+}
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_setBudgetGovernor(JNIEnv *env,
+                                                                              jclass clazz,
+                                                                              jboolean enabled) {
+    synth->setBudgetGovernor(enabled);
+}
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_isBudgetGovernor(JNIEnv *env,
+                                                                             jclass clazz) {
+    return synth->isBudgetGovernor();
+}
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_getQualityTier(JNIEnv *env,
+                                                                           jclass clazz) {
+    return synth->getQualityTier();
+}
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_getBudgetGovernorSummary(JNIEnv *env,
+                                                                                     jclass clazz) {
+    return env->NewStringUTF(synth->getBudgetGovernorSummary().c_str());
+}
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_setPolyphonyCeiling(JNIEnv *env,
+                                                                                jclass clazz,
+                                                                                jint pipes) {
+    synth->setPolyphonyCeiling(pipes);
+}
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_getPolyphonyCeiling(JNIEnv *env,
+                                                                                jclass clazz) {
+    return synth->getPolyphonyCeiling();
+}
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_getPipeSteals(JNIEnv *env,
+                                                                          jclass clazz) {
+    return (jlong) synth->getPipeSteals();
+}
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_setIdleDetection(JNIEnv *env,
+                                                                             jclass clazz,
+                                                                             jboolean enabled) {
+    synth->setIdleDetection(enabled);
+}
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_isIdleDetection(JNIEnv *env,
+                                                                            jclass clazz) {
+    return synth->isIdleDetection();
+}
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_getIdleSummary(JNIEnv *env,
+                                                                           jclass clazz) {
+    return env->NewStringUTF(synth->getIdleSummary().c_str());
+}
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_setConvolutionReverb(JNIEnv *env,
+                                                                                 jclass clazz,
+                                                                                 jstring name) {
+    const char *chars = env->GetStringUTFChars(name, nullptr);
+    std::string impulse = chars;
+    env->ReleaseStringUTFChars(name, chars);
+    return synth->setConvolutionReverb(impulse);
+}
+extern "C"
+JNIEXPORT jobjectArray JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_getImpulseResponses(JNIEnv *env,
+                                                                                jclass clazz) {
+    std::vector<std::string> names = synth->getImpulseResponses();
+    jobjectArray result = env->NewObjectArray((jsize) names.size(), env->FindClass("java/lang/String"), nullptr);
+    for (size_t i = 0; i < names.size(); i++) {
+        jstring name = env->NewStringUTF(names[i].c_str());
+        env->SetObjectArrayElement(result, (jsize) i, name);
+        env->DeleteLocalRef(name);
+    }
+    return result;
+}
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_setConvolutionReverbWet(JNIEnv *env,
+                                                                                    jclass clazz,
+                                                                                    jfloat wet) {
+    synth->setConvolutionReverbWet(wet);
+}
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_getConvolutionReverbSummary(JNIEnv *env,
+                                                                                        jclass clazz) {
+    return env->NewStringUTF(synth->getConvolutionReverbSummary().c_str());
+}
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_getSampledRankSummary(JNIEnv *env,
+                                                                                  jclass clazz) {
+    return env->NewStringUTF(synth->getSampledRankSummary().c_str());
+}
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_setFineTune(JNIEnv *env,
+                                                                        jclass clazz,
+                                                                        jfloat cents) {
+    synth->setFineTune(cents);
+}
+extern "C"
+JNIEXPORT jfloat JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_getFineTune(JNIEnv *env,
+                                                                        jclass clazz) {
+    return synth->getFineTune();
+}
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_setPitchBend(JNIEnv *env,
+                                                                         jclass clazz,
+                                                                         jint channel,
+                                                                         jint value) {
+    synth->pitchBend(channel, value);
+}
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_setPitchBendRange(JNIEnv *env,
+                                                                              jclass clazz,
+                                                                              jfloat cents) {
+    synth->setPitchBendRange(cents);
+}
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_isPitchOffsetLimited(JNIEnv *env,
+                                                                                 jclass clazz) {
+    return synth->isPitchOffsetLimited();
+}
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_setPitchBendChannel(JNIEnv *env,
+                                                                                jclass clazz,
+                                                                                jint channel) {
+    synth->setPitchBendChannel(channel);
+}
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_mathis_aeolusnative_AeolusSynth_AeolussynthManager_getPitchBendChannel(JNIEnv *env,
+                                                                                jclass clazz) {
+    return synth->getPitchBendChannel();
+}
@@ -0,0 +1,288 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include "AeolusEventList.h"
+
+namespace Aeolussynthesizer {
+
+    namespace {
+
+        // Note on or off, or pitch bend, whose two data bytes are in key and velocity
+        struct MidiNote {
+            uint64_t tick;
+            int status;
+            int key;
+            int velocity;
+        };
+
+        struct TempoChange {
+            uint64_t tick;
+            uint32_t microsecondsPerQuarter;
+        };
+
+        uint32_t readBigEndian(const std::vector<uint8_t> &data, size_t position, int bytes) {
+            uint32_t value = 0;
+            for (int i = 0; i < bytes; i++) value = (value << 8) | data[position + i];
+            return value;
+        }
+
+        bool readVariableLength(const std::vector<uint8_t> &data, size_t &position, size_t end, uint32_t &value) {
+            value = 0;
+            for (int i = 0; i < 4; i++) {
+                if (position >= end) return false;
+                uint8_t byte = data[position++];
+                value = (value << 7) | (byte & 0x7F);
+                if ((byte & 0x80) == 0) return true;
+            }
+            return false;
+        }
+
+        bool parseTrack(const std::vector<uint8_t> &data, size_t position, size_t end,
+                        std::vector<MidiNote> &notes, std::vector<TempoChange> &tempi) {
+            uint64_t tick = 0;
+            int runningStatus = 0;
+            while (position < end) {
+                uint32_t delta;
+                if (!readVariableLength(data, position, end, delta)) return false;
+                tick += delta;
+                if (position >= end) return false;
+
+                int status = data[position];
+                if (status & 0x80) {
+                    position++;
+                } else if (runningStatus != 0) {
+                    status = runningStatus;
+                } else {
+                    return false;
+                }
+
+                if (status == 0xFF) {
+                    if (position >= end) return false;
+                    int type = data[position++];
+                    uint32_t length;
+                    if (!readVariableLength(data, position, end, length) || position + length > end) return false;
+                    if (type == 0x51 && length == 3) {
+                        tempi.push_back({tick, readBigEndian(data, position, 3)});
+                    }
+                    position += length;
+                    if (type == 0x2F) break;
+                    continue;
+                }
+                if (status == 0xF0 || status == 0xF7) {
+                    uint32_t length;
+                    if (!readVariableLength(data, position, end, length) || position + length > end) return false;
+                    position += length;
+                    continue;
+                }
+
+                runningStatus = status;
+                int dataBytes = ((status & 0xE0) == 0xC0) ? 1 : 2;
+                if (position + dataBytes > end) return false;
+                int kind = status & 0xF0;
+                if (kind == 0x80 || kind == 0x90 || kind == 0xE0) {
+                    notes.push_back({tick, status, data[position], data[position + 1]});
+                }
+                position += dataBytes;
+            }
+            return true;
+        }
+
+        bool parseOnOff(const std::string &word, bool &on) {
+            if (word == "on") {
+                on = true;
+                return true;
+            }
+            if (word == "off") {
+                on = false;
+                return true;
+            }
+            return false;
+        }
+    }
+
+    void AeolusEventList::add(const AeolusEvent &event) {
+        _events.push_back(event);
+        sort();
+    }
+
+    double AeolusEventList::duration() const {
+        return _events.empty() ? 0.0 : _events.back().time;
+    }
+
+    void AeolusEventList::sort() {
+        std::stable_sort(_events.begin(), _events.end(),
+                         [](const AeolusEvent &x, const AeolusEvent &y) { return x.time < y.time; });
+    }
+
+    bool AeolusEventList::loadScript(const std::string &path, std::string &error) {
+        std::ifstream file(path);
+        if (!file) {
+            error = "Cannot open " + path;
+            return false;
+        }
+
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(file, line)) {
+            lineNumber++;
+            size_t comment = line.find('#');
+            if (comment != std::string::npos) line.resize(comment);
+
+            std::istringstream words(line);
+            AeolusEvent event;
+            std::string command;
+            if (!(words >> event.time)) {
+                if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+                error = path + ":" + std::to_string(lineNumber) + ": expected a time";
+                return false;
+            }
+            words >> command;
+
+            bool ok;
+            bool on = false;
+            std::string onOff;
+            if (command == "noteon") {
+                event.type = AeolusEvent::NOTE_ON;
+                event.c = 100;
+                ok = (bool) (words >> event.a >> event.b);
+                if (ok) words >> event.c;
+            } else if (command == "noteoff") {
+                event.type = AeolusEvent::NOTE_OFF;
+                ok = (bool) (words >> event.a >> event.b);
+            } else if (command == "stop") {
+                ok = (words >> onOff >> event.a >> event.b) && parseOnOff(onOff, on);
+                event.type = on ? AeolusEvent::STOP_ON : AeolusEvent::STOP_OFF;
+            } else if (command == "tremulant") {
+                ok = (words >> onOff >> event.a) && parseOnOff(onOff, on);
+                event.type = on ? AeolusEvent::TREMULANT_ON : AeolusEvent::TREMULANT_OFF;
+            } else if (command == "gain") {
+                event.type = AeolusEvent::DIVISION_GAIN;
+                ok = (bool) (words >> event.a >> event.value);
+            } else if (command == "volume") {
+                event.type = AeolusEvent::VOLUME;
+                ok = (bool) (words >> event.value);
+            } else if (command == "retune") {
+                event.type = AeolusEvent::RETUNE;
+                ok = (bool) (words >> event.a >> event.value);
+            } else if (command == "finetune") {
+                event.type = AeolusEvent::FINE_TUNE;
+                ok = (bool) (words >> event.value);
+            } else if (command == "pitchbend") {
+                event.type = AeolusEvent::PITCH_BEND;
+                ok = (bool) (words >> event.a >> event.b);
+            } else if (command == "rank") {
+                ok = (words >> onOff >> event.a >> event.b) && parseOnOff(onOff, on);
+                event.type = on ? AeolusEvent::RANK_ON : AeolusEvent::RANK_OFF;
+            } else {
+                error = path + ":" + std::to_string(lineNumber) + ": unknown command '" + command + "'";
+                return false;
+            }
+            if (!ok) {
+                error = path + ":" + std::to_string(lineNumber) + ": invalid arguments for " + command;
+                return false;
+            }
+            _events.push_back(event);
+        }
+        sort();
+        return true;
+    }
+
+    bool AeolusEventList::loadMidiFile(const std::string &path, std::string &error) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            error = "Cannot open " + path;
+            return false;
+        }
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        if (data.size() < 14 || std::string(data.begin(), data.begin() + 4) != "MThd") {
+            error = path + ": not a Standard MIDI File";
+            return false;
+        }
+        uint32_t headerLength = readBigEndian(data, 4, 4);
+        int format = (int) readBigEndian(data, 8, 2);
+        int ntracks = (int) readBigEndian(data, 10, 2);
+        uint32_t division = readBigEndian(data, 12, 2);
+        if (format > 1) {
+            error = path + ": format " + std::to_string(format) + " midi files are not supported";
+            return false;
+        }
+
+        std::vector<MidiNote> notes;
+        std::vector<TempoChange> tempi;
+        size_t position = 8 + headerLength;
+        for (int track = 0; track < ntracks && position + 8 <= data.size(); track++) {
+            uint32_t length = readBigEndian(data, position + 4, 4);
+            size_t start = position + 8;
+            size_t end = std::min(start + length, data.size());
+            if (std::string(data.begin() + position, data.begin() + position + 4) == "MTrk" &&
+                !parseTrack(data, start, end, notes, tempi)) {
+                error = path + ": corrupt track " + std::to_string(track);
+                return false;
+            }
+            position = start + length;
+        }
+
+        // Conversion from ticks to seconds, following the tempo map (default 120 bpm)
+        std::stable_sort(tempi.begin(), tempi.end(),
+                         [](const TempoChange &x, const TempoChange &y) { return x.tick < y.tick; });
+        auto secondsAt = [&](uint64_t tick) {
+            if (division & 0x8000) {
+                int framesPerSecond = -(int8_t) (division >> 8);
+                int ticksPerFrame = (int) (division & 0xFF);
+                return (double) tick / (framesPerSecond * ticksPerFrame);
+            }
+            double seconds = 0;
+            uint64_t lastTick = 0;
+            double secondsPerTick = 0.5 / division;
+            for (const TempoChange &t: tempi) {
+                if (t.tick >= tick) break;
+                seconds += (double) (t.tick - lastTick) * secondsPerTick;
+                lastTick = t.tick;
+                secondsPerTick = t.microsecondsPerQuarter * 1e-6 / division;
+            }
+            return seconds + (double) (tick - lastTick) * secondsPerTick;
+        };
+
+        std::stable_sort(notes.begin(), notes.end(),
+                         [](const MidiNote &x, const MidiNote &y) { return x.tick < y.tick; });
+        for (const MidiNote &note: notes) {
+            AeolusEvent event;
+            event.time = secondsAt(note.tick);
+            event.a = note.status & 0x0F;
+            if ((note.status & 0xF0) == 0xE0) {
+                // Least significant 7 bits first
+                event.type = AeolusEvent::PITCH_BEND;
+                event.b = note.key | note.velocity << 7;
+                _events.push_back(event);
+                continue;
+            }
+            bool on = (note.status & 0xF0) == 0x90 && note.velocity > 0;
+            event.type = on ? AeolusEvent::NOTE_ON : AeolusEvent::NOTE_OFF;
+            event.b = note.key;
+            event.c = note.velocity;
+            _events.push_back(event);
+        }
+        sort();
+        return true;
+    }
+
+}
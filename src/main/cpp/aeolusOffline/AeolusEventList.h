@@ -0,0 +1,117 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIDI_SYNTH_AEOLUSEVENTLIST_H
+#define MIDI_SYNTH_AEOLUSEVENTLIST_H
+
+#include <string>
+#include <vector>
+
+namespace Aeolussynthesizer {
+
+    /**
+     * @brief A timed command for the synthesizer, as used for offline rendering
+     */
+    struct AeolusEvent {
+        enum Type {
+            NOTE_ON,      ///< a = midi channel, b = key, c = velocity
+            NOTE_OFF,     ///< a = midi channel, b = key, c = velocity
+            STOP_ON,      ///< a = division, b = stop within division
+            STOP_OFF,     ///< a = division, b = stop within division
+            TREMULANT_ON, ///< a = division
+            TREMULANT_OFF,///< a = division
+            DIVISION_GAIN,///< a = division, value = linear gain
+            VOLUME,       ///< value = master gain
+            RETUNE,       ///< a = temperament index, value = base frequency in Hz
+            FINE_TUNE,    ///< value = pitch offset in cents
+            PITCH_BEND,   ///< a = midi channel, b = 14 bit pitch bend value
+            RANK_ON,      ///< a = division, b = rank within division, see AeolusSynthesizer::activateRank
+            RANK_OFF      ///< a = division, b = rank within division
+        };
+
+        /** Time of the event in seconds from the start of rendering */
+        double time = 0;
+        Type type = NOTE_ON;
+        int a = 0;
+        int b = 0;
+        int c = 0;
+        float value = 0;
+    };
+
+    /**
+     * @brief Time-ordered list of synthesizer events, read from an event script or a Standard MIDI File
+     *
+     * Event scripts are text files with one event per line, in the form "time command arguments", where
+     * time is in seconds. Empty lines and text after # are ignored. The commands are:
+     * <pre>
+     *   noteon    channel key [velocity]
+     *   noteoff   channel key
+     *   stop      on|off division stop
+     *   tremulant on|off division
+     *   gain      division linear_gain
+     *   volume    linear_gain
+     *   retune    temperament base_frequency
+     *   finetune  cents
+     *   pitchbend channel value
+     *   rank      on|off division rank
+     * </pre>
+     * Divisions, stops, ranks and temperaments are indices as used by AeolusSynthesizer. Events at the same time
+     * are applied in the order of the file. Pitch bends apply only on the synthesizer's pitch bend channel, see
+     * AeolusSynthesizer::setPitchBendChannel.<br />
+     * From Standard MIDI Files (format 0 and 1), note on, note off and pitch bend events are taken, with timing
+     * according to the tempo map of the file.
+     */
+    class AeolusEventList {
+    public:
+        /**
+         * Append the events from an event script
+         * @param path Path to the script
+         * @param error Description of the problem if reading fails
+         * @return True on success
+         */
+        bool loadScript(const std::string &path, std::string &error);
+
+        /**
+         * Append the events from a Standard MIDI File
+         * @param path Path to the midi file
+         * @param error Description of the problem if reading fails
+         * @return True on success
+         */
+        bool loadMidiFile(const std::string &path, std::string &error);
+
+        /**
+         * Add a single event
+         * @param event The event to add
+         */
+        void add(const AeolusEvent &event);
+
+        /**
+         * The events, sorted by time. Events with the same time keep the order in which they were added.
+         */
+        const std::vector<AeolusEvent> &events() const { return _events; }
+
+        /** Time of the last event, in seconds, or 0 if there are no events */
+        double duration() const;
+
+    private:
+        void sort();
+
+        std::vector<AeolusEvent> _events;
+    };
+}
+
+#endif //MIDI_SYNTH_AEOLUSEVENTLIST_H
@@ -0,0 +1,176 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <chrono>
+#include <thread>
+#include "AeolusOfflineRenderer.h"
+
+namespace Aeolussynthesizer {
+
+    namespace {
+        using Clock = std::chrono::steady_clock;
+
+        double secondsSince(Clock::time_point start) {
+            return std::chrono::duration<double>(Clock::now() - start).count();
+        }
+
+        // Poll a condition until it holds or the timeout elapses
+        template<typename Condition>
+        bool waitFor(Condition condition, double timeoutSeconds) {
+            auto start = Clock::now();
+            while (!condition()) {
+                if (secondsSince(start) > timeoutSeconds) return false;
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+            return true;
+        }
+    }
+
+    AeolusOfflineRenderer::AeolusOfflineRenderer(AeolusSynthesizer *synth, int samplingRate)
+            : _synth(synth),
+              _samplingRate(samplingRate),
+              _channels(max_output_channels)
+    {
+        _buffer.resize((size_t) PERIOD * _channels);
+        // The output must not depend on the scheduling of the convolution reverb and streaming threads
+        _synth->setConvolutionTailInBackground(false);
+        _synth->setSampledRankStreamingInBackground(false);
+    }
+
+    bool AeolusOfflineRenderer::waitUntilReady(double timeoutSeconds) {
+        return waitFor([this] { return !_synth->isInitializing(); }, timeoutSeconds);
+    }
+
+    void AeolusOfflineRenderer::waitForStop(int division, int stop, bool activated) {
+        waitFor([=] { return _synth->getStopActivated(division, stop) == activated; }, 5.0);
+    }
+
+    void AeolusOfflineRenderer::apply(const AeolusEvent &event) {
+        switch (event.type) {
+            case AeolusEvent::NOTE_ON:
+                _synth->noteon(event.a, event.b, event.c);
+                break;
+            case AeolusEvent::NOTE_OFF:
+                _synth->noteoff(event.a, event.b, event.c);
+                break;
+            case AeolusEvent::STOP_ON:
+                _synth->activateStop(event.a, event.b);
+                waitForStop(event.a, event.b, true);
+                break;
+            case AeolusEvent::STOP_OFF:
+                _synth->deactivateStop(event.a, event.b);
+                waitForStop(event.a, event.b, false);
+                break;
+            case AeolusEvent::TREMULANT_ON:
+                _synth->activateTremulantForDivision(event.a);
+                waitFor([&] { return _synth->tremulantIsActivated(event.a); }, 5.0);
+                break;
+            case AeolusEvent::TREMULANT_OFF:
+                _synth->deactivateTremulantForDivision(event.a);
+                waitFor([&] { return !_synth->tremulantIsActivated(event.a); }, 5.0);
+                break;
+            case AeolusEvent::DIVISION_GAIN:
+                _synth->setVolumeForDivision(event.a, event.value);
+                break;
+            case AeolusEvent::VOLUME:
+                _synth->setVolume(event.value);
+                break;
+            case AeolusEvent::RETUNE:
+                _synth->retune(event.a, event.value);
+                // The model flags the retuning once it has received the request, and the slave
+                // clears the flag once the wavetables are recalculated
+                waitFor([this] { return _synth->is_retuning(); }, 1.0);
+                waitFor([this] { return !_synth->is_retuning(); }, 600.0);
+                break;
+            case AeolusEvent::FINE_TUNE:
+                _synth->setFineTune(event.value);
+                break;
+            case AeolusEvent::PITCH_BEND:
+                _synth->pitchBend(event.a, event.b);
+                break;
+            case AeolusEvent::RANK_ON:
+                _synth->activateRank(event.a, event.b);
+                break;
+            case AeolusEvent::RANK_OFF:
+                _synth->stopRank(event.a, event.b);
+                break;
+        }
+    }
+
+    void AeolusOfflineRenderer::clearRegistration() {
+        AeolusEvent event;
+        for (int d = 0; d < _synth->get_n_divisions(); d++) {
+            event.a = d;
+            for (int s = 0; s < _synth->get_n_stops_for_division(d); s++) {
+                if (_synth->getStopActivated(d, s)) {
+                    event.type = AeolusEvent::STOP_OFF;
+                    event.b = s;
+                    apply(event);
+                }
+            }
+            if (_synth->tremulantIsActivated(d)) {
+                event.type = AeolusEvent::TREMULANT_OFF;
+                apply(event);
+            }
+        }
+        setCouplers(false);
+    }
+
+    void AeolusOfflineRenderer::setCouplers(bool on) {
+        for (int d = 0; d < _synth->get_n_divisions(); d++) {
+            for (int c = 0; c < _synth->get_n_couplers_for_division(d); c++) {
+                if (_synth->getCouplerActivated(d, c) == on) continue;
+                if (on) _synth->activateCoupler(d, c); else _synth->deactivateCoupler(d, c);
+                waitFor([=] { return _synth->getCouplerActivated(d, c) == on; }, 5.0);
+            }
+        }
+    }
+
+    void AeolusOfflineRenderer::renderFrames(uint64_t frames, WavFileWriter *output, Result &result) {
+        for (uint64_t done = 0; done < frames; done += PERIOD) {
+            auto start = Clock::now();
+            _synth->fillAudioBuffer(_buffer.data(), PERIOD, (oboe::ChannelCount) _channels);
+            double seconds = secondsSince(start);
+
+            result.renderSeconds += seconds;
+            if (seconds > result.worstPeriodSeconds) result.worstPeriodSeconds = seconds;
+            result.frames += PERIOD;
+            if (output != nullptr) output->write(_buffer.data(), PERIOD);
+        }
+        result.audioSeconds = (double) result.frames / _samplingRate;
+    }
+
+    AeolusOfflineRenderer::Result AeolusOfflineRenderer::render(const AeolusEventList &events,
+                                                                double tailSeconds,
+                                                                WavFileWriter *output) {
+        Result result;
+        auto start = Clock::now();
+
+        for (const AeolusEvent &event: events.events()) {
+            auto eventFrame = (uint64_t) (event.time * _samplingRate + 0.5);
+            if (eventFrame > result.frames) {
+                renderFrames(eventFrame - result.frames, output, result);
+            }
+            apply(event);
+        }
+        renderFrames((uint64_t) (tailSeconds * _samplingRate), output, result);
+
+        result.wallSeconds = secondsSince(start);
+        return result;
+    }
+
+}
@@ -0,0 +1,123 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIDI_SYNTH_AEOLUSOFFLINERENDERER_H
+#define MIDI_SYNTH_AEOLUSOFFLINERENDERER_H
+
+#include <cstdint>
+#include <vector>
+#include "../aeolusSynthesizer/Synthesizer/include/AeolusSynthesizer.h"
+#include "AeolusEventList.h"
+#include "../aeolusSynthesizer/Platform/WavFile.h"
+
+namespace Aeolussynthesizer {
+
+    /**
+     * @brief Renders audio from an AeolusSynthesizer as fast as possible, without audio device
+     *
+     * The renderer drives the synthesizer's regular audio path (queue processing, key logic and
+     * synthesis, through fillAudioBuffer) from the calling thread, one engine period at a time, and
+     * applies the events of an AeolusEventList at their respective times. The synthesizer is expected
+     * to have been constructed without audio output.<br />
+     * Stop changes, tremulants and retuning go through the model and slave threads; the renderer waits
+     * for them to take effect before rendering on, such that the result does not depend on the
+     * relative speed of the threads. Waiting time is excluded from the reported render time.
+     */
+    class AeolusOfflineRenderer {
+    public:
+        /** Timing of a render run */
+        struct Result {
+            /** Number of frames rendered */
+            uint64_t frames = 0;
+            /** Duration of the audio rendered, in seconds */
+            double audioSeconds = 0;
+            /** Time spent rendering audio, in seconds */
+            double renderSeconds = 0;
+            /** Total time including waiting for stop changes and retuning, in seconds */
+            double wallSeconds = 0;
+            /** Longest time spent rendering a single engine period, in seconds */
+            double worstPeriodSeconds = 0;
+
+            /** How many times faster than real time the audio was rendered */
+            double realTimeFactor() const { return renderSeconds > 0 ? audioSeconds / renderSeconds : 0; }
+
+            /** Render time per frame, in nanoseconds */
+            double nanosecondsPerFrame() const { return frames > 0 ? 1e9 * renderSeconds / frames : 0; }
+        };
+
+        /**
+         * @param synth The synthesizer to render, constructed without audio output
+         * @param samplingRate Sampling rate of the synthesizer
+         */
+        AeolusOfflineRenderer(AeolusSynthesizer *synth, int samplingRate);
+
+        /**
+         * Wait for the synthesizer to finish loading the instrument
+         * @param timeoutSeconds Maximum time to wait
+         * @return True if the synthesizer is ready
+         */
+        bool waitUntilReady(double timeoutSeconds);
+
+        /**
+         * Render the events, followed by a tail
+         * @param events The events to apply
+         * @param tailSeconds Time to render after the last event, e.g. for the reverb to decay
+         * @param output File to write to, or nullptr to discard the audio
+         * @return Timing of the run
+         */
+        Result render(const AeolusEventList &events, double tailSeconds, WavFileWriter *output);
+
+        /**
+         * Apply a single event now, waiting for stop changes and retuning to take effect
+         * @param event The event
+         */
+        void apply(const AeolusEvent &event);
+
+        /** Turn off all stops, tremulants and couplers, waiting for the changes to take effect */
+        void clearRegistration();
+
+        /**
+         * Turn all couplers on or off, waiting for the changes to take effect
+         * @param on True to turn the couplers on
+         */
+        void setCouplers(bool on);
+
+        /**
+         * Render a number of frames
+         * @param frames Number of frames, rounded up to whole engine periods
+         * @param output File to write to, or nullptr to discard the audio
+         * @param result Accumulates the timing
+         */
+        void renderFrames(uint64_t frames, WavFileWriter *output, Result &result);
+
+        /** Number of interleaved output channels */
+        int channels() const { return _channels; }
+
+        /** Sampling rate */
+        int samplingRate() const { return _samplingRate; }
+
+    private:
+        void waitForStop(int division, int stop, bool activated);
+
+        AeolusSynthesizer *_synth;
+        int _samplingRate;
+        int _channels;
+        std::vector<float> _buffer;
+    };
+}
+
+#endif //MIDI_SYNTH_AEOLUSOFFLINERENDERER_H
@@ -0,0 +1,342 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// Render throughput benchmark of the Aeolus synthesizer, using the instrument installed under a stops
+// root (stops/Aeolus for the bundled instrument). The cases sweep the registration from a single stop
+// to the full organ, the number of held notes from one to a ten-finger chord with all couplers on, and
+// tremulants and reverb on or off. For each case, the chord is held and rendered offline for a fixed
+// duration, and the time per frame, the real time factor and the worst engine period are reported.
+//
+// Usage: aeolus_bench -s <stops root> [-d <seconds per case>] [-r <reverb amount>] [-c <results.csv>]
+//                     [-p <worker threads>] [-n] [-v] [-k <scalar|sse2|avx2|neon>] [-g <stop changes per period>]
+//                     [-q] [-l <pipes>] [-i] [-z] [-t <cents>]
+//
+// With -p, the divisions are rendered in parallel (see AeolusSynthesizer::setParallelRendering), with the
+// given number of worker threads, 0 for one less than the number of cores. With -n, idle divisions are
+// rendered anyway (see AeolusSynthesizer::setDivisionCulling). With -v, the render time of each division
+// is listed after each case, and the stop warm-up counters at the end. With -k, the given vector kernels are used instead of the ones detected for
+// the CPU (see AeolusKernels), for comparison with the scalar reference.
+//
+// Finally, with a ten-finger chord held and all couplers on, the full organ is drawn at once and then
+// cancelled at once, and the worst engine period after each switch is reported. With -g, at most the
+// given number of stop changes are passed to the model per engine period, 0 for no limit (see
+// AeolusSynthesizer::setRegistrationChangesPerPeriod), to compare the peaks with and without staging.
+// With -q, the CPU budget governor is on (see AeolusSynthesizer::setBudgetGovernor), and its summary
+// is printed at the end. With -l, the pipes sounding for held and releasing keys are limited to the given
+// number (see AeolusSynthesizer::setPolyphonyCeiling), and the numbers of notes stolen are printed at the end.
+// The last case holds no notes, measuring the cost of silence; with -i, rendering is not suspended
+// while silent (see AeolusSynthesizer::setIdleDetection), for comparison. The periods skipped while
+// silent are printed at the end. With -z, denormals are not flushed to zero while rendering (see
+// AeolusSynthesizer::setFlushDenormals), for comparison with the default. When the instrument has
+// recorded ranks (see AeolusSynthesizer::getSampledRankStatistics), their memory use and streaming
+// underruns are printed at the end. With -t, the pitch is offset by the given number of cents (see
+// AeolusSynthesizer::setFineTune), measuring the cost of playing the engine output at a different rate,
+// which renders engine periods more or less often than output periods.
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+#include "AeolusOfflineRenderer.h"
+
+using Aeolussynthesizer::AeolusEvent;
+using Aeolussynthesizer::AeolusKernels;
+using Aeolussynthesizer::AeolusOfflineRenderer;
+using Aeolussynthesizer::AeolusSynthesizer;
+
+static Lfq_u32  note_queue (256);
+static Lfq_u32  comm_queue (256);
+static Lfq_u8   midi_queue (1024);
+
+namespace {
+
+    // Keys of a ten-finger chord spread over the keyboard, the first n are used for n notes
+    const int chordKeys[] = {36, 43, 48, 52, 55, 60, 64, 67, 72, 76};
+    const int maxNotes = sizeof(chordKeys) / sizeof(chordKeys[0]);
+
+    struct BenchCase {
+        std::string name;
+        // Stops to activate, as (division, stop)
+        std::vector<std::pair<int, int>> stops;
+        int notes = 3;
+        bool couplers = false;
+        bool tremulants = false;
+        bool reverb = true;
+    };
+
+    struct Bench {
+        AeolusSynthesizer *synth;
+        AeolusOfflineRenderer *renderer;
+        double seconds;
+        float reverbAmount;
+        FILE *csv;
+        bool divisionDetails;
+
+        void applyEvent(AeolusEvent::Type type, int a, int b = 0, int c = 0) {
+            AeolusEvent event;
+            event.type = type;
+            event.a = a;
+            event.b = b;
+            event.c = c;
+            renderer->apply(event);
+        }
+
+        // Send the chord on all MIDI channels, such that it reaches every keyboard whatever the
+        // MIDI configuration of the instrument
+        void playChord(int notes, bool on) {
+            for (int channel = 0; channel < 16; channel++) {
+                for (int n = 0; n < notes; n++) {
+                    applyEvent(on ? AeolusEvent::NOTE_ON : AeolusEvent::NOTE_OFF, channel, chordKeys[n], 100);
+                }
+            }
+        }
+
+        // Worst engine period after drawing the full organ at once, and after cancelling it at once
+        void runRegistrationSwitch() {
+            renderer->clearRegistration();
+            renderer->setCouplers(true);
+            synth->setReverbAmount(reverbAmount);
+            AeolusOfflineRenderer::Result ignored;
+            playChord(maxNotes, true);
+            renderer->renderFrames(renderer->samplingRate() / 4, nullptr, ignored);
+
+            AeolusOfflineRenderer::Result drawn;
+            for (int d = 0; d < synth->get_n_divisions(); d++) {
+                synth->setStopActivationBitmask(d, (1ul << synth->get_n_stops_for_division(d)) - 1);
+            }
+            renderer->renderFrames(renderer->samplingRate() / 2, nullptr, drawn);
+
+            AeolusOfflineRenderer::Result cancelled;
+            for (int d = 0; d < synth->get_n_divisions(); d++) synth->setStopActivationBitmask(d, 0);
+            renderer->renderFrames(renderer->samplingRate() / 2, nullptr, cancelled);
+
+            playChord(maxNotes, false);
+            renderer->setCouplers(false);
+            renderer->renderFrames(renderer->samplingRate() * 2, nullptr, ignored);
+
+            double budget = 1e6 * PERIOD / renderer->samplingRate();
+            int limit = synth->getRegistrationChangesPerPeriod();
+            printf("\nRegistration switch, %d notes, couplers, %s:\n", maxNotes,
+                   limit > 0 ? (std::to_string(limit) + " stop changes per period").c_str() : "no staging");
+            printf("%-36s %10.1f %7.1f%%\n", "worst period after tutti", drawn.worstPeriodSeconds * 1e6,
+                   100.0 * drawn.worstPeriodSeconds * 1e6 / budget);
+            printf("%-36s %10.1f %7.1f%%\n", "worst period after general cancel", cancelled.worstPeriodSeconds * 1e6,
+                   100.0 * cancelled.worstPeriodSeconds * 1e6 / budget);
+            Aeolussynthesizer::AeolusRegistrationStager::Statistics staging = synth->getRegistrationStagingStatistics();
+            printf("%llu stop changes, %llu deferred, spread over up to %llu periods\n",
+                   (unsigned long long) staging.changes, (unsigned long long) staging.deferredChanges,
+                   (unsigned long long) staging.worstSpreadPeriods);
+        }
+
+        void run(const BenchCase &benchCase) {
+            renderer->clearRegistration();
+            for (const auto &stop: benchCase.stops) applyEvent(AeolusEvent::STOP_ON, stop.first, stop.second);
+            if (benchCase.couplers) renderer->setCouplers(true);
+            if (benchCase.tremulants) {
+                for (int d = 0; d < synth->get_n_divisions(); d++) {
+                    if (synth->division_has_tremulant(d)) applyEvent(AeolusEvent::TREMULANT_ON, d);
+                }
+            }
+            synth->setReverbAmount(benchCase.reverb ? reverbAmount : 0.0f);
+
+            AeolusOfflineRenderer::Result ignored;
+            playChord(benchCase.notes, true);
+            // Let the attack pass before measuring
+            renderer->renderFrames(renderer->samplingRate() / 4, nullptr, ignored);
+
+            AeolusOfflineRenderer::Result result;
+            synth->resetDivisionActivity();
+            renderer->renderFrames((uint64_t) (seconds * renderer->samplingRate()), nullptr, result);
+
+            playChord(benchCase.notes, false);
+            // Let the release and the reverb decay, such that the next case starts from silence
+            renderer->renderFrames(renderer->samplingRate() * 2, nullptr, ignored);
+
+            double budget = 1e6 * PERIOD / renderer->samplingRate();
+            printf("%-36s %5zu %5d %10.1f %8.2f %10.1f %7.1f%%\n", benchCase.name.c_str(),
+                   benchCase.stops.size(), benchCase.notes, result.nanosecondsPerFrame(),
+                   result.realTimeFactor(), result.worstPeriodSeconds * 1e6,
+                   100.0 * result.worstPeriodSeconds * 1e6 / budget);
+            if (divisionDetails) printf("%s", synth->getDivisionActivitySummary().c_str());
+            fflush(stdout);
+            if (csv != nullptr) {
+                fprintf(csv, "\"%s\",%zu,%d,%d,%d,%d,%.3f,%.4f,%.3f\n", benchCase.name.c_str(),
+                        benchCase.stops.size(), benchCase.notes, benchCase.couplers, benchCase.tremulants,
+                        benchCase.reverb, result.nanosecondsPerFrame(), result.realTimeFactor(),
+                        result.worstPeriodSeconds * 1e6);
+            }
+        }
+    };
+
+    void usage() {
+        fprintf(stderr, "Usage: aeolus_bench -s <stops root> [-d <seconds per case>] [-r <reverb amount>] [-c <results.csv>]"
+                        " [-p <worker threads>] [-n] [-v] [-k <scalar|sse2|avx2|neon>] [-g <stop changes per period>] [-q] [-l <pipes>] [-i] [-z] [-t <cents>]\n");
+    }
+}
+
+int main(int argc, char **argv) {
+    std::string stopsRoot;
+    std::string csvFile;
+    double seconds = 5.0;
+    float reverbAmount = 0.32f;
+    int workers = -1;
+    bool culling = true;
+    bool divisionDetails = false;
+    const char *kernels = nullptr;
+    int changesPerPeriod = -1;
+    bool governor = false;
+    int polyphonyCeiling = 0;
+    bool idleDetection = true;
+    bool flushDenormals = true;
+    float fineTune = 0.0f;
+
+    int option;
+    while ((option = getopt(argc, argv, "s:d:r:c:p:nvk:g:ql:izt:h")) != -1) {
+        switch (option) {
+            case 's': stopsRoot = optarg; break;
+            case 'd': seconds = atof(optarg); break;
+            case 'r': reverbAmount = (float) atof(optarg); break;
+            case 'c': csvFile = optarg; break;
+            case 'p': workers = atoi(optarg); break;
+            case 'n': culling = false; break;
+            case 'v': divisionDetails = true; break;
+            case 'k': kernels = optarg; break;
+            case 'g': changesPerPeriod = atoi(optarg); break;
+            case 'q': governor = true; break;
+            case 'l': polyphonyCeiling = atoi(optarg); break;
+            case 'i': idleDetection = false; break;
+            case 'z': flushDenormals = false; break;
+            case 't': fineTune = (float) atof(optarg); break;
+            default: usage(); return 1;
+        }
+    }
+    if (stopsRoot.empty() || seconds <= 0) {
+        usage();
+        return 1;
+    }
+
+    if (kernels != nullptr && !AeolusKernels::select(AeolusKernels::isaFromName(kernels))) {
+        fprintf(stderr, "The %s kernels are not available on this machine\n", kernels);
+        return 1;
+    }
+
+    auto synth = std::make_unique<AeolusSynthesizer>(&note_queue, &comm_queue, &midi_queue, stopsRoot.c_str(), false);
+    AeolusOfflineRenderer renderer(synth.get(), synthesizerBase::samplingRate);
+    if (!renderer.waitUntilReady(120.0)) {
+        fprintf(stderr, "Timeout while loading the instrument from %s\n", stopsRoot.c_str());
+        return 1;
+    }
+
+    if (workers >= 0) synth->setParallelRendering(true, workers);
+    synth->setDivisionCulling(culling);
+    if (changesPerPeriod >= 0) synth->setRegistrationChangesPerPeriod(changesPerPeriod);
+    synth->setBudgetGovernor(governor);
+    synth->setPolyphonyCeiling(polyphonyCeiling);
+    synth->setIdleDetection(idleDetection);
+    synth->setFlushDenormals(flushDenormals);
+    synth->setFineTune(fineTune);
+
+    Bench bench{synth.get(), &renderer, seconds, reverbAmount, nullptr, divisionDetails};
+    if (!csvFile.empty()) {
+        bench.csv = fopen(csvFile.c_str(), "w");
+        if (bench.csv == nullptr) {
+            fprintf(stderr, "Cannot write %s\n", csvFile.c_str());
+            return 1;
+        }
+        fprintf(bench.csv, "case,stops,notes,couplers,tremulants,reverb,ns_per_frame,real_time_factor,worst_period_us\n");
+    }
+
+    // All stops of the instrument, division by division
+    std::vector<std::pair<int, int>> allStops;
+    for (int d = 0; d < synth->get_n_divisions(); d++) {
+        for (int s = 0; s < synth->get_n_stops_for_division(d); s++) allStops.emplace_back(d, s);
+    }
+    if (allStops.empty()) {
+        fprintf(stderr, "The instrument has no stops\n");
+        return 1;
+    }
+
+    std::vector<BenchCase> cases;
+    // Registration sweep: 1, 2, 4, ... stops and the full organ, with a three-note chord
+    for (size_t n = 1; ; n *= 2) {
+        if (n > allStops.size()) n = allStops.size();
+        BenchCase c;
+        c.stops.assign(allStops.begin(), allStops.begin() + (long) n);
+        c.name = n == allStops.size() ? "full organ" : std::to_string(n) + " stops";
+        cases.push_back(c);
+        if (n == allStops.size()) break;
+    }
+    // Polyphony sweep on the full organ, up to a ten-finger chord, then with all couplers
+    for (int notes: {1, 2, 4, 6, 8, maxNotes}) {
+        BenchCase c;
+        c.stops = allStops;
+        c.notes = notes;
+        c.name = "full organ, " + std::to_string(notes) + " notes";
+        cases.push_back(c);
+    }
+    BenchCase worst;
+    worst.stops = allStops;
+    worst.notes = maxNotes;
+    worst.couplers = true;
+    worst.name = "full organ, 10 notes, couplers";
+    cases.push_back(worst);
+    // Effects on the heaviest case
+    worst.tremulants = true;
+    worst.name = "full organ, 10 notes, couplers, trem";
+    cases.push_back(worst);
+    worst.tremulants = false;
+    worst.reverb = false;
+    worst.name = "full organ, 10 notes, couplers, no rev";
+    cases.push_back(worst);
+    // Nothing played, only the release tails of the previous case and then silence
+    BenchCase silent;
+    silent.stops = allStops;
+    silent.notes = 0;
+    silent.name = "full organ, no notes";
+    cases.push_back(silent);
+
+    printf("Sampling rate %d Hz, engine period %d frames (%.1f us), %.1f s per case, %s rendering, %s, %s kernels, %s, "
+           "pitch offset %.1f cents%s\n\n",
+           renderer.samplingRate(), PERIOD, 1e6 * PERIOD / renderer.samplingRate(), seconds,
+           synth->isParallelRendering() ? "parallel" : "serial",
+           synth->isDivisionCulling() ? "idle divisions culled" : "all divisions rendered",
+           AeolusKernels::isaName(AeolusKernels::active().isa),
+           synth->isFlushDenormals() ? "denormals flushed" : "denormals kept", synth->getPitchOffset(),
+           synth->isPitchOffsetLimited() ? " (limited)" : "");
+    printf("%-36s %5s %5s %10s %8s %10s %8s\n", "case", "stops", "notes", "ns/frame", "RTF", "worst us", "budget");
+    for (const BenchCase &c: cases) bench.run(c);
+    bench.runRegistrationSwitch();
+    if (polyphonyCeiling > 0) {
+        printf("\nPolyphony ceiling %d pipes: %llu notes stolen, %llu releases stolen\n", polyphonyCeiling,
+               (unsigned long long) synth->getPipeSteals(), (unsigned long long) synth->getReleaseSteals());
+    }
+    if (synth->isParallelRendering()) {
+        printf("\nParallel rendering: %llu late periods\n", (unsigned long long) synth->getLateParallelPeriods());
+    }
+    if (governor) printf("\nBudget governor:\n%s", synth->getBudgetGovernorSummary().c_str());
+    printf("\nSilence: %s", synth->getIdleSummary().c_str());
+    if (synth->getSampledRankStatistics().ranks > 0) {
+        printf("\nRecorded ranks: %s", synth->getSampledRankSummary().c_str());
+    }
+    if (divisionDetails) printf("\nStop warm-up: %s", synth->getStopWarmUpSummary().c_str());
+
+    if (bench.csv != nullptr) fclose(bench.csv);
+    return 0;
+}
@@ -0,0 +1,362 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// Golden audio regression harness. Fixed scenarios (a chord on each division, stop toggles with a held
+// chord, retuning between temperaments, and a rank turned on directly) are rendered offline through AeolusSynthesizer and compared
+// sample by sample to reference renders, within a configurable tolerance. The render time per frame of
+// each scenario is recorded along with the reference and reported, and optionally checked, on each run.
+// The rank turned on directly bypasses the stops, so its scenario also checks that the render still sounds
+// after idle_division_release_seconds, when division culling would have silenced a division without stops;
+// this check applies when recording as well.
+//
+// Usage: aeolus_golden -s <stops root> -g <reference dir> [-R] [-a <max abs difference>] [-x <max slowdown>]
+//                      [-S <seed>] [-P] [-E]
+//
+// With -R, the references are (re)recorded. The random noise of the pipes is made reproducible in two
+// ways: the wavetables (ae1 files, in which the pipe noise is computed once) are stored with the reference
+// on recording and rendered from a scratch copy of these later on, and the C library random generators
+// are seeded before the synthesizer and its threads start, for wavetables computed while retuning.
+//
+// With -P, the scenarios are rendered with parallel division rendering, which is expected to match
+// references recorded with serial rendering exactly.
+//
+// With -E, the references are left aside: with division culling off, each scenario is rendered once section
+// by section (see AeolusSynthesizer::setSectionRendering) and once through the engine's own proc_synth, and
+// the two renders are compared with each other, such that the section by section rendering is checked
+// against the engine whenever the latter changes.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "AeolusOfflineRenderer.h"
+
+namespace fs = std::filesystem;
+using Aeolussynthesizer::AeolusEvent;
+using Aeolussynthesizer::AeolusEventList;
+using Aeolussynthesizer::AeolusOfflineRenderer;
+using Aeolussynthesizer::AeolusSynthesizer;
+using Aeolussynthesizer::WavFileData;
+using Aeolussynthesizer::WavFileWriter;
+
+static Lfq_u32  note_queue (256);
+static Lfq_u32  comm_queue (256);
+static Lfq_u8   midi_queue (1024);
+
+namespace {
+
+    const int chordKeys[] = {60, 64, 67};
+
+    struct Scenario {
+        std::string name;
+        AeolusEventList events;
+        double tailSeconds = 2.0;
+        // The render must not be silent in the second from this time on, negative for no check
+        double soundsAt = -1.0;
+    };
+
+    AeolusEvent makeEvent(double time, AeolusEvent::Type type, int a, int b = 0, int c = 0, float value = 0) {
+        AeolusEvent event;
+        event.time = time;
+        event.type = type;
+        event.a = a;
+        event.b = b;
+        event.c = c;
+        event.value = value;
+        return event;
+    }
+
+    // The chord goes out on all MIDI channels, such that it reaches every keyboard whatever the MIDI
+    // configuration; the registration decides which divisions sound
+    void addChord(AeolusEventList &events, double start, double stop) {
+        for (int channel = 0; channel < 16; channel++) {
+            for (int key: chordKeys) {
+                events.add(makeEvent(start, AeolusEvent::NOTE_ON, channel, key, 100));
+                events.add(makeEvent(stop, AeolusEvent::NOTE_OFF, channel, key, 0));
+            }
+        }
+    }
+
+    std::vector<Scenario> makeScenarios(AeolusSynthesizer *synth) {
+        std::vector<Scenario> scenarios;
+
+        for (int d = 0; d < synth->get_n_divisions(); d++) {
+            if (synth->get_n_stops_for_division(d) == 0) continue;
+            Scenario s;
+            s.name = "division" + std::to_string(d);
+            s.events.add(makeEvent(0.0, AeolusEvent::STOP_ON, d, 0));
+            addChord(s.events, 0.0, 1.5);
+            scenarios.push_back(std::move(s));
+        }
+
+        int toggled = synth->get_n_stops_for_division(0) < 3 ? synth->get_n_stops_for_division(0) : 3;
+        if (toggled > 0) {
+            Scenario s;
+            s.name = "stop_toggles";
+            addChord(s.events, 0.0, 0.5 * (2 * toggled + 1));
+            for (int i = 0; i < toggled; i++) {
+                s.events.add(makeEvent(0.5 * i, AeolusEvent::STOP_ON, 0, i));
+                s.events.add(makeEvent(0.5 * (toggled + i), AeolusEvent::STOP_OFF, 0, i));
+            }
+            scenarios.push_back(std::move(s));
+        }
+
+        if (synth->get_n_tunings() > 1 && synth->get_n_stops_for_division(0) > 0) {
+            int tuning = synth->getCurrentTuning();
+            float frequency = synth->getBaseFrequency();
+            Scenario s;
+            s.name = "retune";
+            s.events.add(makeEvent(0.0, AeolusEvent::STOP_ON, 0, 0));
+            addChord(s.events, 0.0, 1.0);
+            s.events.add(makeEvent(1.5, AeolusEvent::RETUNE, (tuning + 1) % synth->get_n_tunings(), 0, 0, frequency));
+            addChord(s.events, 1.5, 2.5);
+            s.events.add(makeEvent(3.0, AeolusEvent::RETUNE, tuning, 0, 0, frequency));
+            addChord(s.events, 3.0, 4.0);
+            scenarios.push_back(std::move(s));
+        }
+
+        if (synth->get_n_stops_for_division(0) > 0) {
+            // The first chord while the division has just been woken up, the second once culling
+            // would have set in for a division without active stops
+            double later = idle_division_release_seconds + 1.0;
+            Scenario s;
+            s.name = "direct_rank";
+            s.events.add(makeEvent(0.0, AeolusEvent::RANK_ON, 0, 0));
+            addChord(s.events, 0.0, 1.0);
+            addChord(s.events, later, later + 1.0);
+            s.events.add(makeEvent(later + 1.0, AeolusEvent::RANK_OFF, 0, 0));
+            s.soundsAt = later;
+            scenarios.push_back(std::move(s));
+        }
+
+        return scenarios;
+    }
+
+    bool copyWaves(const fs::path &from, const fs::path &to) {
+        std::error_code error;
+        fs::create_directories(to, error);
+        if (!fs::is_directory(from)) return !error;
+        for (const auto &entry: fs::directory_iterator(from)) {
+            if (entry.path().extension() != ".ae1") continue;
+            fs::copy_file(entry.path(), to / entry.path().filename(), fs::copy_options::overwrite_existing, error);
+            if (error) return false;
+        }
+        return true;
+    }
+
+    struct Comparison {
+        bool sameLength = false;
+        double maxDiff = 0;
+        double rmsDiff = 0;
+    };
+
+    Comparison compareSamples(const WavFileData &expected, const WavFileData &actual) {
+        Comparison c;
+        double sumSquares = 0;
+        c.sameLength = expected.samples.size() == actual.samples.size() && expected.channels == actual.channels;
+        size_t n = c.sameLength ? actual.samples.size() : 0;
+        for (size_t i = 0; i < n; i++) {
+            double diff = std::fabs((double) actual.samples[i] - expected.samples[i]);
+            if (diff > c.maxDiff) c.maxDiff = diff;
+            sumSquares += diff * diff;
+        }
+        c.rmsDiff = n > 0 ? std::sqrt(sumSquares / n) : 0;
+        return c;
+    }
+
+    bool soundsAt(const WavFileData &data, double time) {
+        uint64_t from = (uint64_t) (time * data.samplingRate);
+        uint64_t to = std::min<uint64_t>(from + data.samplingRate, data.frames());
+        float peak = 0;
+        for (uint64_t i = from * data.channels; i < to * data.channels; i++) peak = std::max(peak, std::fabs(data.samples[i]));
+        return peak > 1e-3f;
+    }
+
+    double readTiming(const fs::path &path) {
+        std::ifstream in(path);
+        double nanosecondsPerFrame = 0;
+        in >> nanosecondsPerFrame;
+        return nanosecondsPerFrame;
+    }
+
+    void usage() {
+        fprintf(stderr, "Usage: aeolus_golden -s <stops root> -g <reference dir> [-R] [-a <max abs difference>]"
+                        " [-x <max slowdown>] [-S <seed>] [-P] [-E]\n");
+    }
+}
+
+int main(int argc, char **argv) {
+    std::string stopsRoot;
+    std::string referenceDir;
+    bool record = false;
+    double maxDifference = 1e-4;
+    double maxSlowdown = 0;
+    unsigned int seed = 1;
+    bool parallel = false;
+    bool engineCheck = false;
+
+    int option;
+    while ((option = getopt(argc, argv, "s:g:Ra:x:S:PEh")) != -1) {
+        switch (option) {
+            case 's': stopsRoot = optarg; break;
+            case 'g': referenceDir = optarg; break;
+            case 'R': record = true; break;
+            case 'a': maxDifference = atof(optarg); break;
+            case 'x': maxSlowdown = atof(optarg); break;
+            case 'S': seed = (unsigned int) strtoul(optarg, nullptr, 10); break;
+            case 'P': parallel = true; break;
+            case 'E': engineCheck = true; break;
+            default: usage(); return 1;
+        }
+    }
+    if (stopsRoot.empty() || referenceDir.empty()) {
+        usage();
+        return 1;
+    }
+
+    // Scratch stops root: the instrument definition of the given stops root, with a private copy of the
+    // reference wavetables, such that retuning does not touch the references
+    fs::path reference(referenceDir);
+    fs::path scratch = fs::temp_directory_path() / ("aeolus_golden_" + std::to_string(getpid()));
+    std::error_code error;
+    fs::remove_all(scratch, error);
+    fs::create_directories(scratch, error);
+    fs::create_directory_symlink(fs::absolute(fs::path(stopsRoot) / "stops"), scratch / "stops", error);
+    if (error) {
+        fprintf(stderr, "Cannot set up %s: %s\n", scratch.c_str(), error.message().c_str());
+        return 1;
+    }
+    if (record) {
+        fs::create_directories(reference, error);
+        if (!copyWaves(fs::path(stopsRoot) / "waves", reference / "waves")) {
+            fprintf(stderr, "Cannot store the wavetables in %s\n", reference.c_str());
+            return 1;
+        }
+    }
+    if (!copyWaves(reference / "waves", scratch / "waves")) {
+        fprintf(stderr, "Cannot copy the wavetables from %s\n", reference.c_str());
+        return 1;
+    }
+
+    srand(seed);
+    srandom(seed);
+    auto synth = std::make_unique<AeolusSynthesizer>(&note_queue, &comm_queue, &midi_queue, scratch.c_str(), false);
+    AeolusOfflineRenderer renderer(synth.get(), synthesizerBase::samplingRate);
+    if (!renderer.waitUntilReady(600.0)) {
+        fprintf(stderr, "Timeout while loading the instrument\n");
+        return 1;
+    }
+
+    if (parallel) synth->setParallelRendering(true);
+    if (engineCheck) synth->setDivisionCulling(false);
+
+    int failures = 0;
+    printf("%-16s %10s %12s %12s %10s %10s\n", "scenario", "result", "max diff", "rms diff", "ns/frame",
+           engineCheck ? "sections" : "reference");
+    auto renderScenario = [&renderer](Scenario &scenario, const fs::path &rendered) {
+        renderer.clearRegistration();
+        // Let the previous scenario decay completely
+        AeolusOfflineRenderer::Result ignored;
+        renderer.renderFrames((uint64_t) renderer.samplingRate() * 8, nullptr, ignored);
+
+        WavFileWriter writer;
+        writer.open(rendered.string(), renderer.samplingRate(), renderer.channels(), WavFileWriter::FLOAT_32);
+        AeolusOfflineRenderer::Result result = renderer.render(scenario.events, scenario.tailSeconds, &writer);
+        writer.close();
+        return result;
+    };
+    for (Scenario &scenario: makeScenarios(synth.get())) {
+        fs::path rendered = scratch / (scenario.name + ".wav");
+        if (engineCheck) {
+            fs::path sectionsRendered = scratch / (scenario.name + ".sections.wav");
+            synth->setSectionRendering(true);
+            AeolusOfflineRenderer::Result sectionsResult = renderScenario(scenario, sectionsRendered);
+            synth->setSectionRendering(false);
+            AeolusOfflineRenderer::Result result = renderScenario(scenario, rendered);
+
+            WavFileData expected;
+            WavFileData actual;
+            std::string message;
+            if (!expected.read(rendered.string(), message) || !actual.read(sectionsRendered.string(), message)) {
+                printf("%-16s %10s  %s\n", scenario.name.c_str(), "ERROR", message.c_str());
+                failures++;
+                continue;
+            }
+            Comparison c = compareSamples(expected, actual);
+            const char *verdict = !c.sameLength ? "LENGTH" : c.maxDiff > maxDifference ? "DIFFERS" : "ok";
+            if (verdict[0] != 'o') failures++;
+            printf("%-16s %10s %12.3g %12.3g %10.1f %10.1f\n", scenario.name.c_str(), verdict, c.maxDiff, c.rmsDiff,
+                   result.nanosecondsPerFrame(), sectionsResult.nanosecondsPerFrame());
+            continue;
+        }
+
+        AeolusOfflineRenderer::Result result = renderScenario(scenario, rendered);
+
+        if (scenario.soundsAt >= 0) {
+            WavFileData actual;
+            std::string message;
+            if (!actual.read(rendered.string(), message) || !soundsAt(actual, scenario.soundsAt)) {
+                printf("%-16s %10s  no sound at %.1f s %s\n", scenario.name.c_str(), "SILENT", scenario.soundsAt,
+                       message.c_str());
+                failures++;
+                continue;
+            }
+        }
+
+        fs::path referenceWav = reference / (scenario.name + ".wav");
+        fs::path referenceTiming = reference / (scenario.name + ".time");
+        if (record) {
+            fs::copy_file(rendered, referenceWav, fs::copy_options::overwrite_existing, error);
+            std::ofstream(referenceTiming) << result.nanosecondsPerFrame() << "\n";
+            printf("%-16s %10s %12s %12s %10.1f %10s\n", scenario.name.c_str(), error ? "ERROR" : "recorded",
+                   "", "", result.nanosecondsPerFrame(), "");
+            if (error) failures++;
+            continue;
+        }
+
+        WavFileData expected;
+        WavFileData actual;
+        std::string message;
+        if (!expected.read(referenceWav.string(), message) || !actual.read(rendered.string(), message)) {
+            printf("%-16s %10s  %s\n", scenario.name.c_str(), "ERROR", message.c_str());
+            failures++;
+            continue;
+        }
+
+        Comparison c = compareSamples(expected, actual);
+        double referenceNanoseconds = readTiming(referenceTiming);
+        bool tooSlow = maxSlowdown > 0 && referenceNanoseconds > 0 &&
+                       result.nanosecondsPerFrame() > maxSlowdown * referenceNanoseconds;
+        const char *verdict = !c.sameLength ? "LENGTH" : c.maxDiff > maxDifference ? "DIFFERS" : tooSlow ? "SLOW" : "ok";
+        if (verdict[0] != 'o') failures++;
+        printf("%-16s %10s %12.3g %12.3g %10.1f %10.1f\n", scenario.name.c_str(), verdict, c.maxDiff, c.rmsDiff,
+               result.nanosecondsPerFrame(), referenceNanoseconds);
+    }
+
+    if (failures == 0) {
+        fs::remove_all(scratch, error);
+    } else if (!record || engineCheck) {
+        printf("\n%d scenario(s) failed, renders kept in %s\n", failures, scratch.c_str());
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,496 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// Validation and benchmark of the vector kernels of the audio path (see AeolusKernels). Each instruction
+// set available on this machine is checked against the scalar reference on random data, including
+// samples beyond full scale, for block sizes with and without left-over frames. With each instruction set,
+// the FFT, the partitioned convolution and the convolution reverb (fading in and out) are also checked against
+// a direct computation on synthetic data, so no impulse response files are needed. Then each kernel is timed
+// on blocks of one engine period, and its speed is compared with the scalar reference.
+// A decaying feedback network, as in a reverb tail, is then timed with and without denormals flushed to
+// zero (see AeolusKernels::FlushDenormals), and the convolution reverb is timed with room responses of
+// 0.5 to 8 seconds, reporting its cost per second of audio (see AeolusConvolutionReverb).
+//
+// Usage: aeolus_kernel_bench [-V] [-d <seconds per kernel>]
+//
+// With -V, only the validation is run. The exit status is non-zero if any kernel does not match the
+// scalar reference, or any convolution the direct computation.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <unistd.h>
+#include "../aeolusSynthesizer/AeolusSignalProcessing/AeolusKernels.h"
+#include "../aeolusSynthesizer/AeolusSignalProcessing/AeolusConvolutionReverb.h"
+#include "../aeolusSynthesizer/AeolusSignalProcessing/AeolusFft.h"
+#include "../aeolusSynthesizer/AeolusSignalProcessing/AeolusPartitionedConvolution.h"
+
+using Aeolussynthesizer::AeolusConvolutionReverb;
+using Aeolussynthesizer::AeolusFft;
+using Aeolussynthesizer::AeolusKernels;
+using Aeolussynthesizer::AeolusPartitionedConvolution;
+
+namespace {
+
+    // Largest block used, in frames
+    const int maxFrames = 1024;
+    // Engine period, the block size of the mix kernel
+    const int periodFrames = 64;
+
+    struct Buffers {
+        std::vector<float> a, b, c;
+        std::vector<float> floatOut, floatOut2, reference, reference2;
+
+        explicit Buffers(unsigned int seed)
+                : a(maxFrames), b(maxFrames), c(maxFrames), floatOut(2 * maxFrames), floatOut2(maxFrames),
+                  reference(2 * maxFrames), reference2(maxFrames) {
+            // Up to 50% beyond full scale
+            std::mt19937 generator(seed);
+            std::uniform_real_distribution<float> distribution(-1.5f, 1.5f);
+            for (int i = 0; i < maxFrames; i++) {
+                a[i] = distribution(generator);
+                b[i] = distribution(generator);
+                c[i] = distribution(generator);
+            }
+        }
+    };
+
+    float maxDifference(const std::vector<float> &x, const std::vector<float> &y, int n) {
+        float d = 0;
+        for (int i = 0; i < n; i++) d = std::fmax(d, std::fabs(x[i] - y[i]));
+        return d;
+    }
+
+    // Compare all kernels of a table with the scalar reference
+    bool validate(const AeolusKernels &kernels, Buffers &buf) {
+        const AeolusKernels &scalar = *AeolusKernels::forIsa(AeolusKernels::SCALAR);
+        // Results within a few units in the last place of values up to about 4
+        const float floatTolerance = 4e-6f;
+        const float gain = 0.7f;
+        bool ok = true;
+
+        for (int frames: {1, 7, 61, 64, 192, maxFrames}) {
+            float fd;
+
+            scalar.mixStereo(buf.a.data(), buf.b.data(), buf.c.data(), 0.6f, buf.reference.data(),
+                             buf.reference2.data(), frames);
+            kernels.mixStereo(buf.a.data(), buf.b.data(), buf.c.data(), 0.6f, buf.floatOut.data(),
+                              buf.floatOut2.data(), frames);
+            fd = std::fmax(maxDifference(buf.floatOut, buf.reference, frames),
+                           maxDifference(buf.floatOut2, buf.reference2, frames));
+            if (fd > floatTolerance) {
+                printf("  mixStereo, %d frames: max difference %g\n", frames, fd);
+                ok = false;
+            }
+
+            scalar.interleaveStereoFloat(buf.a.data(), buf.b.data(), buf.reference.data(), frames, gain);
+            kernels.interleaveStereoFloat(buf.a.data(), buf.b.data(), buf.floatOut.data(), frames, gain);
+            fd = maxDifference(buf.floatOut, buf.reference, 2 * frames);
+            if (fd > floatTolerance) {
+                printf("  interleaveStereoFloat, %d frames: max difference %g\n", frames, fd);
+                ok = false;
+            }
+
+            scalar.downmixMonoFloat(buf.a.data(), buf.b.data(), buf.reference.data(), frames, gain);
+            kernels.downmixMonoFloat(buf.a.data(), buf.b.data(), buf.floatOut.data(), frames, gain);
+            fd = maxDifference(buf.floatOut, buf.reference, frames);
+            if (fd > floatTolerance) {
+                printf("  downmixMonoFloat, %d frames: max difference %g\n", frames, fd);
+                ok = false;
+            }
+
+            std::fill(buf.reference.begin(), buf.reference.end(), 0.25f);
+            std::fill(buf.floatOut.begin(), buf.floatOut.end(), 0.25f);
+            scalar.accumulateFloat(buf.a.data(), gain, buf.reference.data(), frames);
+            kernels.accumulateFloat(buf.a.data(), gain, buf.floatOut.data(), frames);
+            fd = maxDifference(buf.floatOut, buf.reference, frames);
+            if (fd > floatTolerance) {
+                printf("  accumulateFloat, %d frames: max difference %g\n", frames, fd);
+                ok = false;
+            }
+
+            // A ramp crossing both ends of the gain range within the block
+            std::copy(buf.b.begin(), buf.b.end(), buf.reference.begin());
+            std::copy(buf.b.begin(), buf.b.end(), buf.floatOut.begin());
+            float step = 1.5f / (float) frames;
+            scalar.crossfade(buf.a.data(), buf.reference.data(), -0.25f, step, frames);
+            kernels.crossfade(buf.a.data(), buf.floatOut.data(), -0.25f, step, frames);
+            fd = maxDifference(buf.floatOut, buf.reference, frames);
+            if (fd > floatTolerance) {
+                printf("  crossfade, %d frames: max difference %g\n", frames, fd);
+                ok = false;
+            }
+
+            std::fill(buf.reference.begin(), buf.reference.end(), 0.25f);
+            std::fill(buf.reference2.begin(), buf.reference2.end(), -0.25f);
+            std::fill(buf.floatOut.begin(), buf.floatOut.end(), 0.25f);
+            std::fill(buf.floatOut2.begin(), buf.floatOut2.end(), -0.25f);
+            scalar.multiplyAccumulateComplex(buf.a.data(), buf.b.data(), buf.c.data(), buf.a.data(),
+                                             buf.reference.data(), buf.reference2.data(), frames);
+            kernels.multiplyAccumulateComplex(buf.a.data(), buf.b.data(), buf.c.data(), buf.a.data(),
+                                              buf.floatOut.data(), buf.floatOut2.data(), frames);
+            fd = std::fmax(maxDifference(buf.floatOut, buf.reference, frames),
+                           maxDifference(buf.floatOut2, buf.reference2, frames));
+            if (fd > floatTolerance) {
+                printf("  multiplyAccumulateComplex, %d frames: max difference %g\n", frames, fd);
+                ok = false;
+            }
+        }
+        return ok;
+    }
+
+    // Direct convolution of x with h, the first n samples
+    std::vector<float> convolveDirectly(const std::vector<float> &x, const std::vector<float> &h, int n) {
+        std::vector<float> y(n);
+        for (int i = 0; i < n; i++) {
+            double sum = 0.0;
+            for (int k = 0; k < (int) h.size() && k <= i; k++) sum += (double) h[k] * x[i - k];
+            y[i] = (float) sum;
+        }
+        return y;
+    }
+
+    // Compare the FFT with a direct DFT, and check that the inverse gives the signal back
+    bool validateFft(const Buffers &buf) {
+        bool ok = true;
+        for (int size: {4, 16, 256, 1024}) {
+            AeolusFft fft(size);
+            std::vector<float> re(fft.bins()), im(fft.bins()), back(size);
+            fft.forward(buf.a.data(), re.data(), im.data());
+            double d = 0.0;
+            for (int k = 0; k < fft.bins(); k++) {
+                double sumRe = 0.0, sumIm = 0.0;
+                for (int n = 0; n < size; n++) {
+                    double phase = -2.0 * M_PI * (double) k * n / size;
+                    sumRe += buf.a[n] * cos(phase);
+                    sumIm += buf.a[n] * sin(phase);
+                }
+                d = std::max(d, std::max(std::fabs(sumRe - re[k]), std::fabs(sumIm - im[k])));
+            }
+            // Rounding grows with the size of the transform
+            if (d > 1e-5 * size) {
+                printf("  AeolusFft, %d samples: max difference %g to the direct DFT\n", size, d);
+                ok = false;
+            }
+            fft.inverse(re.data(), im.data(), back.data());
+            std::vector<float> input(buf.a.begin(), buf.a.begin() + size);
+            float id = maxDifference(back, input, size);
+            if (id > 1e-5f) {
+                printf("  AeolusFft, %d samples: max difference %g after the inverse\n", size, id);
+                ok = false;
+            }
+        }
+        return ok;
+    }
+
+    // Partitioned convolution of noise with responses of a few blocks, one not a whole number of blocks
+    bool validatePartitionedConvolution(const Buffers &buf) {
+        bool ok = true;
+        const int blocks = 16;
+        for (int blockSize: {16, periodFrames}) {
+            for (int length: {1, blockSize, 5 * blockSize / 2}) {
+                std::vector<float> h(buf.b.begin(), buf.b.begin() + length);
+                std::vector<float> x(buf.a.begin(), buf.a.begin() + blocks * blockSize);
+                std::vector<float> expected = convolveDirectly(x, h, blocks * blockSize);
+                std::vector<float> actual(blocks * blockSize, 0.0f);
+                AeolusPartitionedConvolution convolution(h.data(), length, blockSize);
+                for (int b = 0; b < blocks; b++) convolution.process(&x[b * blockSize], &actual[b * blockSize]);
+                float d = maxDifference(actual, expected, blocks * blockSize);
+                if (d > 1e-4f) {
+                    printf("  AeolusPartitionedConvolution, %d frames in blocks of %d: max difference %g\n",
+                           length, blockSize, d);
+                    ok = false;
+                }
+            }
+        }
+        return ok;
+    }
+
+    // Convolution reverb with a stereo response longer than the head, the tail convolved in the foreground,
+    // turned on and then off: the output is the input plus the direct convolution with the normalized
+    // response, faded in and out with the gain ramp of the reverb
+    bool validateConvolutionReverb() {
+        const int samplingRate = 44100;
+        const int tailBlock = 4 * periodFrames;
+        const int fadePeriods = 4;
+        const int length = 11 * tailBlock + 13;
+        const int periods = 120;
+        const int offPeriod = 80;
+        const float wet = 0.5f;
+        std::mt19937 generator(99);
+        std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+
+        std::vector<float> response(2 * (size_t) length);
+        for (int i = 0; i < length; i++) {
+            float envelope = powf(10.0f, -3.0f * (float) i / (float) length);
+            response[2 * i] = envelope * noise(generator);
+            response[2 * i + 1] = envelope * noise(generator);
+        }
+        // Audible up to the end, such that nothing is cut
+        response[2 * (length - 1)] = 1e-3f;
+        std::vector<float> h[2];
+        double energy = 0.0;
+        for (int c = 0; c < 2; c++) {
+            double e = 0.0;
+            for (int i = 0; i < length; i++) {
+                h[c].push_back(response[2 * i + c]);
+                e += (double) response[2 * i + c] * response[2 * i + c];
+            }
+            energy = std::max(energy, e);
+        }
+        for (int c = 0; c < 2; c++) {
+            for (float &v: h[c]) v = (float) (v / sqrt(energy));
+        }
+
+        int frames = periods * periodFrames;
+        std::vector<float> input[2], output[2];
+        for (int c = 0; c < 2; c++) {
+            for (int i = 0; i < frames; i++) input[c].push_back(noise(generator));
+            output[c] = input[c];
+        }
+
+        AeolusConvolutionReverb reverb(samplingRate, periodFrames, tailBlock, fadePeriods);
+        reverb.setTailInBackground(false);
+        reverb.setImpulseResponse(response.data(), length, 2, samplingRate);
+        for (int p = 0; p < periods; p++) {
+            if (p == offPeriod) reverb.setImpulseResponse(nullptr, 0, 2, samplingRate);
+            reverb.process(&output[0][p * periodFrames], &output[1][p * periodFrames], wet);
+        }
+
+        // The gain moves by 1/(fadePeriods*periodFrames) per frame, from the period after the change
+        std::vector<float> gain(frames);
+        float g = 0.0f;
+        float step = 1.0f / (float) (fadePeriods * periodFrames);
+        for (int i = 0; i < frames; i++) {
+            float target = i < offPeriod * periodFrames ? wet : 0.0f;
+            g = target > g ? std::min(target, g + step) : std::max(target, g - step);
+            gain[i] = g;
+        }
+        bool ok = true;
+        for (int c = 0; c < 2; c++) {
+            std::vector<float> convolved = convolveDirectly(input[c], h[c], frames);
+            float d = 0.0f;
+            for (int i = 0; i < frames; i++) {
+                d = std::max(d, std::fabs(output[c][i] - (input[c][i] + gain[i] * convolved[i])));
+            }
+            if (d > 1e-4f) {
+                printf("  AeolusConvolutionReverb, channel %d: max difference %g\n", c, d);
+                ok = false;
+            }
+        }
+        if (reverb.active()) {
+            printf("  AeolusConvolutionReverb: still active after fading out\n");
+            ok = false;
+        }
+        return ok;
+    }
+
+    // Time a kernel call on one engine period, repeated for the given duration
+    template<typename Call>
+    double nanosecondsPerFrame(double seconds, Call call) {
+        using Clock = std::chrono::steady_clock;
+        uint64_t calls = 0;
+        auto start = Clock::now();
+        double elapsed = 0;
+        while (elapsed < seconds) {
+            for (int i = 0; i < 1000; i++) call();
+            calls += 1000;
+            elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        }
+        return 1e9 * elapsed / ((double) calls * periodFrames);
+    }
+
+    struct Timing {
+        double kernel[6];
+    };
+
+    Timing benchmark(const AeolusKernels &k, Buffers &buf, double seconds) {
+        Timing t{};
+        const int n = periodFrames;
+        t.kernel[0] = nanosecondsPerFrame(seconds, [&] {
+            k.mixStereo(buf.a.data(), buf.b.data(), buf.c.data(), 0.6f, buf.floatOut.data(), buf.floatOut2.data(), n);
+        });
+        t.kernel[1] = nanosecondsPerFrame(seconds, [&] {
+            k.interleaveStereoFloat(buf.a.data(), buf.b.data(), buf.floatOut.data(), n, 0.7f);
+        });
+        t.kernel[2] = nanosecondsPerFrame(seconds, [&] {
+            k.downmixMonoFloat(buf.a.data(), buf.b.data(), buf.floatOut.data(), n, 0.7f);
+        });
+        t.kernel[3] = nanosecondsPerFrame(seconds, [&] {
+            k.accumulateFloat(buf.a.data(), 0.7f, buf.floatOut.data(), n);
+        });
+        t.kernel[4] = nanosecondsPerFrame(seconds, [&] {
+            k.crossfade(buf.a.data(), buf.floatOut.data(), 0.5f, 1.0f / (16 * n), n);
+        });
+        t.kernel[5] = nanosecondsPerFrame(seconds, [&] {
+            k.multiplyAccumulateComplex(buf.a.data(), buf.b.data(), buf.c.data(), buf.a.data(),
+                                        buf.floatOut.data(), buf.floatOut2.data(), n);
+        });
+        return t;
+    }
+
+    // A bank of decaying feedback delays, as in a reverb, left to ring out into denormal numbers
+    double decayNanosecondsPerSample(double seconds) {
+        const int lines = 8;
+        const int length = 1031;
+        std::vector<float> delay(lines * length);
+        using Clock = std::chrono::steady_clock;
+        uint64_t samples = 0;
+        float output = 0.0f;
+        auto start = Clock::now();
+        double elapsed = 0;
+        while (elapsed < seconds) {
+            // Start from the end of a tail, just above the smallest normal float, and let it decay to zero
+            for (int i = 0; i < lines * length; i++) delay[i] = (i % 3 == 0 ? 1e-37f : -1e-37f);
+            for (int n = 0; n < 200 * length; n++) {
+                int i = n % length;
+                float sum = 0.0f;
+                for (int l = 0; l < lines; l++) sum += delay[l * length + i];
+                for (int l = 0; l < lines; l++) {
+                    float *x = &delay[l * length + i];
+                    *x = 0.7f * *x + 0.02f * sum;
+                }
+                output += sum;
+            }
+            samples += (uint64_t) 200 * length * lines;
+            elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        }
+        // Keep the output alive
+        if (output == 12345.0f) printf(" ");
+        return 1e9 * elapsed / (double) samples;
+    }
+
+    void compareDenormals(double seconds) {
+        double slow = decayNanosecondsPerSample(seconds);
+        double fast;
+        {
+            AeolusKernels::FlushDenormals flush;
+            fast = decayNanosecondsPerSample(seconds);
+        }
+        printf("\nDecaying feedback delays into denormals: %.3f ns/sample, %.3f ns/sample flushed to zero (%.1fx)\n",
+               slow, fast, slow / fast);
+    }
+
+    // Convolution reverb with synthetic room responses (exponentially decaying noise) of increasing length,
+    // fed with noise for the given duration of audio. The tail is convolved on the calling thread, such
+    // that head and tail are timed alike.
+    void compareConvolution(double audioSeconds) {
+        const int samplingRate = 44100;
+        const int tailBlock = 1024;
+        printf("\nConvolution reverb, %d Hz, periods of %d frames, tail blocks of %d frames\n", samplingRate,
+               periodFrames, tailBlock);
+        printf("%-10s %14s %14s %14s %8s\n", "response", "head ms/s", "tail ms/s", "total ms/s", "CPU");
+        std::mt19937 generator(2024);
+        std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+        for (double seconds: {0.5, 1.0, 2.0, 4.0, 8.0}) {
+            int frames = (int) (seconds * samplingRate);
+            // Stereo, decaying by 60 dB over the length of the response
+            std::vector<float> response(2 * (size_t) frames);
+            for (int i = 0; i < frames; i++) {
+                float envelope = powf(10.0f, -3.0f * (float) i / (float) frames);
+                response[2 * i] = envelope * noise(generator);
+                response[2 * i + 1] = envelope * noise(generator);
+            }
+            AeolusConvolutionReverb reverb(samplingRate, periodFrames, tailBlock, 16);
+            reverb.setTailInBackground(false);
+            reverb.setImpulseResponse(response.data(), frames, 2, samplingRate);
+            float left[periodFrames], right[periodFrames];
+            int periods = (int) (audioSeconds * samplingRate / periodFrames);
+            for (int p = 0; p < periods; p++) {
+                for (int i = 0; i < periodFrames; i++) {
+                    left[i] = 0.1f * noise(generator);
+                    right[i] = 0.1f * noise(generator);
+                }
+                reverb.process(left, right, 0.5f);
+            }
+            AeolusConvolutionReverb::Statistics st = reverb.statistics();
+            double audio = (double) st.periods * periodFrames / samplingRate;
+            double head = 1e-6 * (double) st.headNanoseconds / audio;
+            double tail = 1e-6 * (double) st.tailNanoseconds / audio;
+            printf("%8.1f s %14.3f %14.3f %14.3f %7.2f%%\n", seconds, head, tail, head + tail, (head + tail) / 10.0);
+        }
+    }
+
+    void usage() {
+        fprintf(stderr, "Usage: aeolus_kernel_bench [-V] [-d <seconds per kernel>]\n");
+    }
+}
+
+int main(int argc, char **argv) {
+    bool validateOnly = false;
+    double seconds = 0.25;
+
+    int option;
+    while ((option = getopt(argc, argv, "Vd:h")) != -1) {
+        switch (option) {
+            case 'V': validateOnly = true; break;
+            case 'd': seconds = atof(optarg); break;
+            default: usage(); return 1;
+        }
+    }
+    if (seconds <= 0) {
+        usage();
+        return 1;
+    }
+
+    printf("Detected instruction set: %s\n", AeolusKernels::isaName(AeolusKernels::detect()));
+
+    Buffers buf(12345);
+    std::vector<const AeolusKernels *> available;
+    bool ok = true;
+    for (int i = 0; i < AeolusKernels::n_isas; i++) {
+        const AeolusKernels *kernels = AeolusKernels::forIsa((AeolusKernels::Isa) i);
+        if (kernels == nullptr) continue;
+        available.push_back(kernels);
+        bool valid = validate(*kernels, buf);
+        // The convolutions use the active table
+        AeolusKernels::select(kernels->isa);
+        valid = validateFft(buf) && valid;
+        valid = validatePartitionedConvolution(buf) && valid;
+        valid = validateConvolutionReverb() && valid;
+        AeolusKernels::select(AeolusKernels::detect());
+        printf("%-8s %s\n", AeolusKernels::isaName(kernels->isa),
+               valid ? "matches the scalar reference and the direct convolutions" : "FAILED");
+        ok = ok && valid;
+    }
+    if (validateOnly || !ok) return ok ? 0 : 1;
+
+    const char *names[] = {"mixStereo", "interleaveStereoFloat", "downmixMonoFloat", "accumulateFloat",
+                           "crossfade", "multiplyAccumulateComplex"};
+    printf("\nns per frame on blocks of %d frames (speed-up over scalar)\n", periodFrames);
+    printf("%-26s", "kernel");
+    for (const AeolusKernels *k: available) printf(" %16s", AeolusKernels::isaName(k->isa));
+    printf("\n");
+
+    std::vector<Timing> timings;
+    for (const AeolusKernels *k: available) timings.push_back(benchmark(*k, buf, seconds));
+    for (int j = 0; j < 6; j++) {
+        printf("%-26s", names[j]);
+        for (const Timing &t: timings) {
+            printf(" %8.3f (%4.1fx)", t.kernel[j], timings[0].kernel[j] / t.kernel[j]);
+        }
+        printf("\n");
+    }
+
+    compareDenormals(4 * seconds);
+    compareConvolution(40 * seconds);
+    return 0;
+}
@@ -0,0 +1,110 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// Command line tool rendering an event script or a MIDI file with the Aeolus synthesizer to a WAV
+// file, as fast as the machine allows, and reporting the achieved real time factor.
+//
+// Usage: aeolus_render -s <stops root> (-m <file.mid> | -e <script>) [-o <out.wav>] [-t <tail seconds>] [-f]
+//
+// The stops root is the directory containing stops/stops, stops/Aeolus and waves, as installed on the
+// device. Without -o, the audio is rendered but discarded, which is useful for timing only. With -f,
+// the WAV file holds 32 bit float samples instead of 16 bit integers.
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include "AeolusOfflineRenderer.h"
+
+static Lfq_u32  note_queue (256);
+static Lfq_u32  comm_queue (256);
+static Lfq_u8   midi_queue (1024);
+
+static void usage() {
+    fprintf(stderr,
+            "Usage: aeolus_render -s <stops root> (-m <file.mid> | -e <script>) [-o <out.wav>] [-t <tail seconds>] [-f]\n");
+}
+
+int main(int argc, char **argv) {
+    std::string stopsRoot;
+    std::string midiFile;
+    std::string scriptFile;
+    std::string outputFile;
+    double tailSeconds = 2.0;
+    bool floatOutput = false;
+
+    int option;
+    while ((option = getopt(argc, argv, "s:m:e:o:t:fh")) != -1) {
+        switch (option) {
+            case 's': stopsRoot = optarg; break;
+            case 'm': midiFile = optarg; break;
+            case 'e': scriptFile = optarg; break;
+            case 'o': outputFile = optarg; break;
+            case 't': tailSeconds = atof(optarg); break;
+            case 'f': floatOutput = true; break;
+            default: usage(); return 1;
+        }
+    }
+    if (stopsRoot.empty() || midiFile.empty() == scriptFile.empty()) {
+        usage();
+        return 1;
+    }
+
+    Aeolussynthesizer::AeolusEventList events;
+    std::string error;
+    bool loaded = midiFile.empty() ? events.loadScript(scriptFile, error) : events.loadMidiFile(midiFile, error);
+    if (!loaded) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    auto synth = std::make_unique<Aeolussynthesizer::AeolusSynthesizer>(&note_queue, &comm_queue, &midi_queue,
+                                                                        stopsRoot.c_str(), false);
+    Aeolussynthesizer::AeolusOfflineRenderer renderer(synth.get(), synthesizerBase::samplingRate);
+    if (!renderer.waitUntilReady(120.0)) {
+        fprintf(stderr, "Timeout while loading the instrument from %s\n", stopsRoot.c_str());
+        return 1;
+    }
+
+    Aeolussynthesizer::WavFileWriter writer;
+    if (!outputFile.empty() &&
+        !writer.open(outputFile, renderer.samplingRate(), renderer.channels(),
+                     floatOutput ? Aeolussynthesizer::WavFileWriter::FLOAT_32
+                                 : Aeolussynthesizer::WavFileWriter::PCM_16)) {
+        fprintf(stderr, "Cannot write %s\n", outputFile.c_str());
+        return 1;
+    }
+
+    Aeolussynthesizer::AeolusOfflineRenderer::Result result =
+            renderer.render(events, tailSeconds, outputFile.empty() ? nullptr : &writer);
+
+    if (!outputFile.empty() && !writer.close()) {
+        fprintf(stderr, "Error while writing %s\n", outputFile.c_str());
+        return 1;
+    }
+
+    printf("events:            %zu\n", events.events().size());
+    printf("frames:            %llu\n", (unsigned long long) result.frames);
+    printf("audio:             %.3f s\n", result.audioSeconds);
+    printf("render time:       %.3f s\n", result.renderSeconds);
+    printf("wall time:         %.3f s\n", result.wallSeconds);
+    printf("per frame:         %.1f ns\n", result.nanosecondsPerFrame());
+    printf("worst period:      %.1f us\n", result.worstPeriodSeconds * 1e6);
+    printf("real time factor:  %.2f x\n", result.realTimeFactor());
+    return 0;
+}
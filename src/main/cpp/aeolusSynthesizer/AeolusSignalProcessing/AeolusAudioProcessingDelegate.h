@@ -47,14 +47,13 @@ public:
      * for audio output is needed. This invocation takes place from a high priority thread,
      * avoid blocking or time consuming tasks.<br />
      *
-     * audioData represents a pre-reserved float array of length framesCount*channelCount, with a block
-     * structure with channelCount blocks of each block consisting of framesCount consecutive floats. I.e.
-     * This can for example be achieved with an array of the structure float[channelCount][framesCount]. Oboe
+     * audioData represents a pre-reserved float array of length framesCount*channelCount, with
+     * interleaved frames, i.e. the structure float[framesCount][channelCount]. Oboe
      * expects that the values provided be in the interval -1.0 to +1.0
      * @param audioData Pointer to the start of the audio data buffer, preallocated by oboe, of length
-     *                  framesCount*channelCount and with an intended blockwise structure float[channelCount][framesCount]
+     *                  framesCount*channelCount and with interleaved structure float[framesCount][channelCount]
      * @param framesCount Number of samples to be supplied in each channel
-     * @param channelCount Number of channels, e.g., number of blocks. Mono=1, Stereo=2
+     * @param channelCount Number of channels per frame. Mono=1, Stereo=2
      */
     virtual void fillAudioBuffer(float *audioData, int32_t framesCount,
                                         oboe::ChannelCount channelCount)=0;
@@ -0,0 +1,70 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstring>
+#include "AeolusAudioRing.h"
+
+namespace Aeolussynthesizer {
+
+    namespace {
+        // A power of two keeps the slot index continuous when the positions wrap around
+        int roundUpToPowerOfTwo(int n) {
+            int p = 1;
+            while (p < n) p <<= 1;
+            return p;
+        }
+    }
+
+    AeolusAudioRing::AeolusAudioRing(int channels, int periodFrames, int capacity)
+            : _channels(channels),
+              _periodFrames(periodFrames),
+              _capacity(roundUpToPowerOfTwo(capacity)),
+              _stride((periodFrames + 15) & ~15),
+              _storage((size_t) _stride * channels * _capacity, 0.0f) {
+    }
+
+    int AeolusAudioRing::fill() const {
+        return (int) (_writePosition.load(std::memory_order_acquire) - _readPosition.load(std::memory_order_acquire));
+    }
+
+    float *AeolusAudioRing::slot(uint32_t position, int channel) {
+        size_t index = position & (uint32_t) (_capacity - 1);
+        return _storage.data() + (index * _channels + channel) * _stride;
+    }
+
+    float *AeolusAudioRing::writeChannel(int channel) {
+        return slot(_writePosition.load(std::memory_order_relaxed), channel);
+    }
+
+    void AeolusAudioRing::commitWrite() {
+        _writePosition.fetch_add(1, std::memory_order_release);
+    }
+
+    bool AeolusAudioRing::read(float *const *destination) {
+        uint32_t position = _readPosition.load(std::memory_order_relaxed);
+        if (_writePosition.load(std::memory_order_acquire) == position) return false;
+        for (int c = 0; c < _channels; c++) {
+            memcpy(destination[c], slot(position, c), _periodFrames * sizeof(float));
+        }
+        _readPosition.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    void AeolusAudioRing::clear() {
+        _readPosition.store(_writePosition.load(std::memory_order_acquire), std::memory_order_release);
+    }
+}
@@ -0,0 +1,83 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIDI_SYNTH_AEOLUSAUDIORING_H
+#define MIDI_SYNTH_AEOLUSAUDIORING_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace Aeolussynthesizer {
+    /**
+     * @brief Lock-free single producer, single consumer ring of rendered engine periods
+     *
+     * Each slot holds one engine period of planar audio. The producer renders straight into the slot
+     * at the write position and commits it; the consumer copies the oldest committed slot out and
+     * releases it. Positions are atomic counters, the storage is allocated once at construction, so
+     * neither side ever locks or allocates.
+     */
+    class AeolusAudioRing {
+    public:
+        /**
+         * @param channels Number of planar channels
+         * @param periodFrames Number of frames per period (slot)
+         * @param capacity Minimum number of slots, rounded up to a power of two
+         */
+        AeolusAudioRing(int channels, int periodFrames, int capacity);
+
+        /** Number of slots */
+        int capacity() const { return _capacity; }
+
+        /** Number of committed periods not read yet, from either side */
+        int fill() const;
+
+        /**
+         * Producer: channel storage of the slot at the write position. Only valid while fill() < capacity().
+         * @param channel Index of the channel
+         * @return Pointer to periodFrames floats
+         */
+        float *writeChannel(int channel);
+
+        /** Producer: publish the slot at the write position */
+        void commitWrite();
+
+        /**
+         * Consumer: copy the oldest committed period out and release its slot
+         * @param destination One pointer per channel, to periodFrames floats each
+         * @return False if the ring is empty
+         */
+        bool read(float *const *destination);
+
+        /** Consumer: drop all committed periods */
+        void clear();
+
+    private:
+        float *slot(uint32_t position, int channel);
+
+        int _channels;
+        int _periodFrames;
+        int _capacity;
+        /** Distance between two consecutive channel blocks, rounded up to a full cache line */
+        int _stride;
+        std::vector<float> _storage;
+        alignas(64) std::atomic<uint32_t> _writePosition{0};
+        alignas(64) std::atomic<uint32_t> _readPosition{0};
+    };
+}
+
+#endif //MIDI_SYNTH_AEOLUSAUDIORING_H
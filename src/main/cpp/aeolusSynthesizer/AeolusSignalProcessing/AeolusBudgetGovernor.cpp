@@ -0,0 +1,135 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "AeolusBudgetGovernor.h"
+
+namespace Aeolussynthesizer {
+
+    namespace {
+        // Single writer increment, as in AeolusCallbackStats
+        inline void add(std::atomic<uint64_t> &counter, uint64_t value) {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+    }
+
+    AeolusBudgetGovernor::AeolusBudgetGovernor(double periodNanoseconds, int holdPeriods)
+            : _periodNanoseconds(periodNanoseconds),
+              _holdPeriods(holdPeriods),
+              _hold(holdPeriods) {
+        for (auto &p: _periods) p.store(0, std::memory_order_relaxed);
+    }
+
+    void AeolusBudgetGovernor::setEnabled(bool enabled) {
+        _enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    void AeolusBudgetGovernor::setThresholds(float degradeLoad, float recoverLoad) {
+        if (recoverLoad > degradeLoad) recoverLoad = degradeLoad;
+        _degradeLoad.store(degradeLoad, std::memory_order_relaxed);
+        _recoverLoad.store(recoverLoad, std::memory_order_relaxed);
+    }
+
+    void AeolusBudgetGovernor::setTierAllowed(Tier tier, bool allowed) {
+        if (tier <= FULL || tier >= n_tiers) return;
+        if (allowed) {
+            _allowedTiers.fetch_or(1u << tier, std::memory_order_relaxed);
+        } else {
+            _allowedTiers.fetch_and(~(1u << tier), std::memory_order_relaxed);
+        }
+    }
+
+    AeolusBudgetGovernor::Tier AeolusBudgetGovernor::update(uint64_t nanoseconds) {
+        _period++;
+        float load = (float) ((double) nanoseconds / _periodNanoseconds);
+        _average += (load - _average) * averagingWeight;
+        _load.store(_average, std::memory_order_relaxed);
+
+        int current = _tier.load(std::memory_order_relaxed);
+        add(_periods[current], 1);
+
+        if (!_enabled.load(std::memory_order_relaxed)) {
+            if (current != FULL) stepTo(FULL);
+            return tier();
+        }
+
+        unsigned allowed = _allowedTiers.load(std::memory_order_relaxed) | 1u;
+        if (_average > _degradeLoad.load(std::memory_order_relaxed)) {
+            _lowSince = 0;
+            if (_period - _lastStep < (uint64_t) settlePeriods) return tier();
+            int next = current + 1;
+            while (next < n_tiers && (allowed & (1u << next)) == 0) next++;
+            if (next < n_tiers) {
+                // Back down soon after a recovery: the recovery was premature, wait longer next time
+                if (_lastRecovery != 0 && _period - _lastRecovery < 2 * (uint64_t) _hold &&
+                    _hold < maxHoldFactor * _holdPeriods) {
+                    _hold *= 2;
+                }
+                add(_degradations, 1);
+                stepTo(next);
+            }
+        } else if (_average < _recoverLoad.load(std::memory_order_relaxed) && current != FULL) {
+            if (_lowSince == 0) _lowSince = _period;
+            if (_period - _lowSince < (uint64_t) _hold || _period - _lastStep < (uint64_t) settlePeriods) {
+                return tier();
+            }
+            int next = current - 1;
+            while (next > FULL && (allowed & (1u << next)) == 0) next--;
+            add(_recoveries, 1);
+            _lastRecovery = _period;
+            _lowSince = 0;
+            stepTo(next);
+        } else {
+            _lowSince = 0;
+            // Stable for long: the initial hold time is enough again
+            if (_period - _lastStep > 4 * (uint64_t) maxHoldFactor * _holdPeriods) _hold = _holdPeriods;
+        }
+        return tier();
+    }
+
+    void AeolusBudgetGovernor::stepTo(int tier) {
+        int from = _tier.load(std::memory_order_relaxed);
+        _tier.store(tier, std::memory_order_relaxed);
+        if (tier > _worstTier.load(std::memory_order_relaxed)) _worstTier.store(tier, std::memory_order_relaxed);
+        _lastStep = _period;
+        _lastTransition.store((_period << 16) | ((uint64_t) from << 8) | (uint64_t) tier, std::memory_order_relaxed);
+    }
+
+    AeolusBudgetGovernor::Statistics AeolusBudgetGovernor::statistics() const {
+        Statistics s;
+        s.tier = tier();
+        s.worstTier = (Tier) _worstTier.load(std::memory_order_relaxed);
+        s.load = _load.load(std::memory_order_relaxed);
+        s.degradations = _degradations.load(std::memory_order_relaxed);
+        s.recoveries = _recoveries.load(std::memory_order_relaxed);
+        for (int t = 0; t < n_tiers; t++) s.periods[t] = _periods[t].load(std::memory_order_relaxed);
+        uint64_t transition = _lastTransition.load(std::memory_order_relaxed);
+        s.lastTransitionPeriod = transition >> 16;
+        s.lastFrom = (Tier) ((transition >> 8) & 0xff);
+        s.lastTo = (Tier) (transition & 0xff);
+        return s;
+    }
+
+    const char *AeolusBudgetGovernor::tierName(Tier tier) {
+        switch (tier) {
+            case FULL: return "full";
+            case SHORT_RELEASE: return "short release";
+            case NO_REVERB: return "no reverb";
+            case NO_TREMULANT: return "no tremulant";
+            default: return "unknown";
+        }
+    }
+}
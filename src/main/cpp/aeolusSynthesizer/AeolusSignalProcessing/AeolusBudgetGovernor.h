@@ -0,0 +1,169 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIDI_SYNTH_AEOLUSBUDGETGOVERNOR_H
+#define MIDI_SYNTH_AEOLUSBUDGETGOVERNOR_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace Aeolussynthesizer {
+
+    /**
+     * @brief Trades quality for render time when the engine periods come close to their deadline
+     *
+     * The audio side reports the render time of each engine period. The governor keeps a moving average
+     * of the load, i.e. render time over the duration of the period, and steps down one quality tier
+     * when the average exceeds the degrade threshold, and back up one tier when it has stayed below the
+     * recover threshold for a hold time. The tiers are cumulative: each one keeps the savings of the tiers
+     * before it. Tiers can be left out, in which case the governor skips them.<br />
+     * After each step, the average is given time to settle before the next step. If the load comes back
+     * soon after a recovery, the hold time is doubled (up to maxHoldFactor times the initial hold time),
+     * so that the governor does not oscillate between two tiers; it goes back to the initial hold time
+     * once the tier has been stable for a while.<br />
+     * As for AeolusCallbackStats, the audio side is the only writer and never waits; the settings and
+     * counters can be accessed from any thread.
+     */
+    class AeolusBudgetGovernor {
+    public:
+        /** Quality tiers, from full quality to the cheapest */
+        enum Tier {
+            /** Full quality */
+            FULL,
+            /** Release tails of divisions without stops are cut short */
+            SHORT_RELEASE,
+            /** The reverb is faded out and no longer computed */
+            NO_REVERB,
+            /** The tremulants are turned off */
+            NO_TREMULANT,
+            n_tiers
+        };
+
+        /** Weight of the latest period in the moving average of the load */
+        static constexpr float averagingWeight = 1.0f / 32.0f;
+        /** Periods after a step during which the governor does not step down further */
+        static constexpr int settlePeriods = 64;
+        /** Maximum hold time before recovery, relative to the initial one */
+        static constexpr int maxHoldFactor = 16;
+
+        /** State and counters of the governor */
+        struct Statistics {
+            /** Current tier */
+            Tier tier = FULL;
+            /** Lowest quality tier reached */
+            Tier worstTier = FULL;
+            /** Moving average of the load, 1 = render time equal to the period duration */
+            float load = 0.0f;
+            /** Number of steps down */
+            uint64_t degradations = 0;
+            /** Number of steps up */
+            uint64_t recoveries = 0;
+            /** Number of periods rendered in each tier */
+            uint64_t periods[n_tiers] = {};
+            /** Period count at the last step, 0 if none */
+            uint64_t lastTransitionPeriod = 0;
+            /** Tier before the last step */
+            Tier lastFrom = FULL;
+            /** Tier after the last step */
+            Tier lastTo = FULL;
+        };
+
+        /**
+         * @param periodNanoseconds Duration of an engine period, in nanoseconds
+         * @param holdPeriods Initial number of periods below the recover threshold before stepping up
+         */
+        AeolusBudgetGovernor(double periodNanoseconds, int holdPeriods);
+
+        /**
+         * Turn the governor on or off, from any thread. When off, the tier goes back to FULL at the
+         * next period.
+         * @param enabled True to govern
+         */
+        void setEnabled(bool enabled);
+
+        /** Is the governor on? */
+        bool isEnabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+        /**
+         * Set the load thresholds, from any thread
+         * @param degradeLoad Average load above which the quality is lowered, e.g. 0.8
+         * @param recoverLoad Average load below which the quality is raised again, lower than degradeLoad
+         */
+        void setThresholds(float degradeLoad, float recoverLoad);
+
+        /**
+         * Allow or skip a tier, from any thread. FULL is always allowed.
+         * @param tier The tier
+         * @param allowed False to skip the tier
+         */
+        void setTierAllowed(Tier tier, bool allowed);
+
+        /**
+         * Audio side: record the render time of a period and decide on the tier for the next one
+         * @param nanoseconds Render time of the period
+         * @return Tier to render the next period with
+         */
+        Tier update(uint64_t nanoseconds);
+
+        /** Current tier, from any thread */
+        Tier tier() const { return (Tier) _tier.load(std::memory_order_relaxed); }
+
+        /**
+         * Read the state and counters, from any thread
+         * @return Copy of the statistics
+         */
+        Statistics statistics() const;
+
+        /**
+         * Name of a tier, for display
+         * @param tier The tier
+         * @return Short name
+         */
+        static const char *tierName(Tier tier);
+
+    private:
+        void stepTo(int tier);
+
+        const double _periodNanoseconds;
+        const int _holdPeriods;
+
+        std::atomic<bool> _enabled{false};
+        std::atomic<float> _degradeLoad{0.8f};
+        std::atomic<float> _recoverLoad{0.5f};
+        std::atomic<unsigned> _allowedTiers{(1u << n_tiers) - 1};
+
+        // Audio side state
+        float _average = 0.0f;
+        uint64_t _period = 0;
+        uint64_t _lastStep = 0;
+        uint64_t _lastRecovery = 0;
+        uint64_t _lowSince = 0;
+        int _hold;
+
+        // Written by the audio side only
+        std::atomic<int> _tier{FULL};
+        std::atomic<int> _worstTier{FULL};
+        std::atomic<float> _load{0.0f};
+        std::atomic<uint64_t> _degradations{0};
+        std::atomic<uint64_t> _recoveries{0};
+        std::atomic<uint64_t> _periods[n_tiers];
+        /** Period of the last step, shifted left by 16, with the tiers before and after in the low bits */
+        std::atomic<uint64_t> _lastTransition{0};
+    };
+}
+
+#endif //MIDI_SYNTH_AEOLUSBUDGETGOVERNOR_H
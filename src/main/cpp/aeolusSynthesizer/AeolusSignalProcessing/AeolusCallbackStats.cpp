@@ -0,0 +1,87 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "AeolusCallbackStats.h"
+
+namespace Aeolussynthesizer {
+
+    namespace {
+        // Single writer: a relaxed load followed by a relaxed store is sufficient and avoids
+        // read-modify-write instructions on the audio thread
+        inline void add(std::atomic<uint64_t> &counter, uint64_t value) {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t AeolusCallbackStats::bucketUpperBoundMicroseconds(int bucket) {
+        return firstBucketMicroseconds << bucket;
+    }
+
+    void AeolusCallbackStats::record(uint64_t durationNanoseconds, int32_t frames,
+                                     uint64_t deadlineNanoseconds) {
+        if (_resetRequested.load(std::memory_order_acquire)) {
+            clear();
+            _resetRequested.store(false, std::memory_order_release);
+        }
+
+        add(_callbacks, 1);
+        add(_framesRendered, (uint64_t) frames);
+        add(_totalNanoseconds, durationNanoseconds);
+        if (durationNanoseconds > deadlineNanoseconds) {
+            add(_deadlineMisses, 1);
+        }
+        if (durationNanoseconds > _worstNanoseconds.load(std::memory_order_relaxed)) {
+            _worstNanoseconds.store(durationNanoseconds, std::memory_order_relaxed);
+        }
+
+        uint64_t microseconds = durationNanoseconds / 1000;
+        int bucket = 0;
+        while (bucket < histogramBuckets - 1 && microseconds >= bucketUpperBoundMicroseconds(bucket)) {
+            bucket++;
+        }
+        add(_histogram[bucket], 1);
+    }
+
+    AeolusCallbackStats::Snapshot AeolusCallbackStats::snapshot() const {
+        Snapshot s;
+        s.callbacks = _callbacks.load(std::memory_order_relaxed);
+        s.framesRendered = _framesRendered.load(std::memory_order_relaxed);
+        s.deadlineMisses = _deadlineMisses.load(std::memory_order_relaxed);
+        s.worstNanoseconds = _worstNanoseconds.load(std::memory_order_relaxed);
+        s.totalNanoseconds = _totalNanoseconds.load(std::memory_order_relaxed);
+        for (int i = 0; i < histogramBuckets; i++) {
+            s.histogram[i] = _histogram[i].load(std::memory_order_relaxed);
+        }
+        return s;
+    }
+
+    void AeolusCallbackStats::requestReset() {
+        _resetRequested.store(true, std::memory_order_release);
+    }
+
+    void AeolusCallbackStats::clear() {
+        _callbacks.store(0, std::memory_order_relaxed);
+        _framesRendered.store(0, std::memory_order_relaxed);
+        _deadlineMisses.store(0, std::memory_order_relaxed);
+        _worstNanoseconds.store(0, std::memory_order_relaxed);
+        _totalNanoseconds.store(0, std::memory_order_relaxed);
+        for (auto &bucket: _histogram) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+}
@@ -0,0 +1,100 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIDI_SYNTH_AEOLUSCALLBACKSTATS_H
+#define MIDI_SYNTH_AEOLUSCALLBACKSTATS_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace Aeolussynthesizer {
+    /**
+     * @brief Timing statistics of the audio callback
+     *
+     * Collects, for every audio callback, the time spent producing the audio data and compares it with
+     * the time represented by the audio data (the deadline). The statistics consist of a histogram of the
+     * callback durations, the number of callbacks exceeding their deadline, the worst duration observed,
+     * and the number of frames rendered.<br />
+     * The audio thread is the only writer; it only performs plain atomic loads and stores, no locking,
+     * no system calls and no logging. Any other thread can read a snapshot at any time. Resetting is
+     * requested by the reader and carried out by the audio thread at its next callback, such that
+     * neither side ever waits for the other.
+     */
+    class AeolusCallbackStats {
+    public:
+        /** Number of histogram buckets */
+        static constexpr int histogramBuckets = 16;
+        /** Upper bound of the first histogram bucket, in microseconds. Each further bucket doubles the bound */
+        static constexpr uint64_t firstBucketMicroseconds = 16;
+
+        /** Copy of the statistics at a given point of time */
+        struct Snapshot {
+            /** Number of callbacks recorded */
+            uint64_t callbacks = 0;
+            /** Number of frames delivered by the recorded callbacks */
+            uint64_t framesRendered = 0;
+            /** Number of callbacks that took longer than the duration of the audio they delivered */
+            uint64_t deadlineMisses = 0;
+            /** Longest callback duration, in nanoseconds */
+            uint64_t worstNanoseconds = 0;
+            /** Sum of all callback durations, in nanoseconds */
+            uint64_t totalNanoseconds = 0;
+            /** Callback duration histogram, see bucketUpperBoundMicroseconds */
+            uint64_t histogram[histogramBuckets] = {};
+        };
+
+        /**
+         * Upper bound of a histogram bucket. Bucket 0 counts callbacks shorter than firstBucketMicroseconds,
+         * bucket k those between the bounds of buckets k-1 and k. The last bucket also counts everything longer.
+         * @param bucket Index of the bucket
+         * @return Upper bound in microseconds
+         */
+        static uint64_t bucketUpperBoundMicroseconds(int bucket);
+
+        /**
+         * Record a callback. Only to be called from the audio thread.
+         * @param durationNanoseconds Time spent in the callback
+         * @param frames Number of frames delivered
+         * @param deadlineNanoseconds Duration of the audio delivered
+         */
+        void record(uint64_t durationNanoseconds, int32_t frames, uint64_t deadlineNanoseconds);
+
+        /**
+         * Read the current statistics, from any thread
+         * @return Copy of the statistics
+         */
+        Snapshot snapshot() const;
+
+        /**
+         * Ask the audio thread to clear the statistics at its next callback
+         */
+        void requestReset();
+
+    private:
+        void clear();
+
+        std::atomic<uint64_t> _callbacks{0};
+        std::atomic<uint64_t> _framesRendered{0};
+        std::atomic<uint64_t> _deadlineMisses{0};
+        std::atomic<uint64_t> _worstNanoseconds{0};
+        std::atomic<uint64_t> _totalNanoseconds{0};
+        std::atomic<uint64_t> _histogram[histogramBuckets]{};
+        std::atomic<bool> _resetRequested{false};
+    };
+}
+
+#endif //MIDI_SYNTH_AEOLUSCALLBACKSTATS_H
@@ -0,0 +1,398 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "AeolusConvolutionReverb.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <semaphore.h>
+#include "AeolusKernels.h"
+#include "AeolusPartitionedConvolution.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace Aeolussynthesizer {
+
+    namespace {
+        // Slots of the tail input and output rings: the block being written, the block being convolved,
+        // and one block of slack on either side
+        constexpr int tailSlots = 4;
+
+        // Level, relative to the peak, below which the end of an impulse response is cut (-100 dB)
+        constexpr float trimLevel = 1e-5f;
+
+        inline void add(std::atomic<uint64_t> &counter, uint64_t value) {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        inline uint64_t elapsedNanoseconds(std::chrono::steady_clock::time_point start) {
+            return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+        }
+    }
+
+    /**
+     * Convolution state for one impulse response. Tail block k is the input from frames kT to kT+T-1;
+     * its convolution with the tail of the response sounds from block k+2 on, as the tail starts 2T
+     * frames into the response.
+     */
+    struct AeolusConvolutionReverb::Impulse {
+        AeolusConvolutionReverb &owner;
+        const int periodFrames;
+        const int tailFrames;
+        const bool background;
+        std::unique_ptr<AeolusPartitionedConvolution> head[2];
+        std::unique_ptr<AeolusPartitionedConvolution> tail[2];
+        bool hasTail;
+        /** Input of the tail blocks, by slot and channel */
+        std::vector<float> tailInput;
+        /** Tail contribution to the output blocks, by slot and channel */
+        std::vector<float> tailOutput;
+        /** Convolved head, by channel */
+        std::vector<float> wet;
+
+        // Audio side
+        /** Tail block being written */
+        uint64_t block = 0;
+        /** Frames of the block written so far */
+        int position = 0;
+        /** First block with a tail contribution to use */
+        uint64_t validFrom = 2;
+        /** Tail contribution to the current block, nullptr if none */
+        const float *tailSlot = nullptr;
+
+        /** Number of tail blocks whose input is complete */
+        std::atomic<uint64_t> completedInputs{0};
+        /** Tail contributions are ready for the output blocks below this number */
+        std::atomic<uint64_t> readyOutputs{0};
+        /** One more than the block before which the tail convolution starts over, 0 if never */
+        std::atomic<uint64_t> resetBefore{0};
+        /** Value of resetBefore last applied, tail side */
+        uint64_t resetApplied = 0;
+
+        std::atomic<bool> exit{false};
+        sem_t wake;
+        std::thread thread;
+
+        Impulse(AeolusConvolutionReverb &owner, const std::vector<float> *channels, int nChannels, bool background)
+                : owner(owner), periodFrames(owner._periodFrames), tailFrames(owner._tailBlockFrames),
+                  background(background),
+                  tailInput((size_t) tailSlots * 2 * tailFrames), tailOutput((size_t) tailSlots * 2 * tailFrames),
+                  wet((size_t) 2 * periodFrames) {
+            int length = (int) channels[0].size();
+            int headLength = std::min(length, 2 * tailFrames);
+            for (int c = 0; c < 2; c++) {
+                const std::vector<float> &response = channels[std::min(c, nChannels - 1)];
+                head[c] = std::make_unique<AeolusPartitionedConvolution>(response.data(), headLength, periodFrames);
+                tail[c] = std::make_unique<AeolusPartitionedConvolution>(response.data() + headLength,
+                                                                         length - headLength, tailFrames);
+            }
+            hasTail = tail[0]->partitions() > 0;
+            sem_init(&wake, 0, 0);
+            if (hasTail && background) thread = std::thread(&Impulse::threadMain, this);
+        }
+
+        ~Impulse() {
+            if (thread.joinable()) {
+                exit.store(true);
+                sem_post(&wake);
+                thread.join();
+            }
+            sem_destroy(&wake);
+        }
+
+        float *inputSlot(uint64_t k, int channel) {
+            return &tailInput[((size_t) (k % tailSlots) * 2 + channel) * tailFrames];
+        }
+
+        float *outputSlot(uint64_t k, int channel) {
+            return &tailOutput[((size_t) (k % tailSlots) * 2 + channel) * tailFrames];
+        }
+
+        /** Start over, as after silence. Audio side. */
+        void reset() {
+            for (int c = 0; c < 2; c++) {
+                head[c]->reset();
+                memset(inputSlot(block, c), 0, position * sizeof(float));
+            }
+            // Contributions still in flight were computed from the previous input
+            tailSlot = nullptr;
+            validFrom = block + 2;
+            resetBefore.store(block + 1, std::memory_order_relaxed);
+        }
+
+        /** Convolve the complete input block k with the tail, for output block k+2 */
+        void convolveTail(uint64_t k) {
+            auto start = std::chrono::steady_clock::now();
+            uint64_t reset = resetBefore.load(std::memory_order_relaxed);
+            if (reset > resetApplied && k + 1 >= reset) {
+                tail[0]->reset();
+                tail[1]->reset();
+                resetApplied = reset;
+            }
+            for (int c = 0; c < 2; c++) {
+                float *out = outputSlot(k + 2, c);
+                memset(out, 0, tailFrames * sizeof(float));
+                tail[c]->process(inputSlot(k, c), out);
+            }
+            readyOutputs.store(k + 3, std::memory_order_release);
+            uint64_t ns = elapsedNanoseconds(start);
+            add(owner._tailBlocks, 1);
+            add(owner._tailNanoseconds, ns);
+            if (ns > owner._worstTailNanoseconds.load(std::memory_order_relaxed)) {
+                owner._worstTailNanoseconds.store(ns, std::memory_order_relaxed);
+            }
+        }
+
+        void threadMain() {
+#ifdef __linux__
+            // Below the synthesis thread of render-ahead mode, which the output depends on first
+            sched_param param{};
+            param.sched_priority = sched_get_priority_min(SCHED_FIFO) + 1;
+            pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+#endif
+            AeolusKernels::FlushDenormals flush;
+            uint64_t next = 0;
+            while (!exit.load(std::memory_order_acquire)) {
+                uint64_t completed = completedInputs.load(std::memory_order_acquire);
+                if (next < completed) {
+                    // Too far behind, the oldest inputs may be overwritten: carry on with the latest.
+                    // The audio side counts the blocks left out.
+                    if (completed - next > 2) next = completed - 1;
+                    convolveTail(next++);
+                    continue;
+                }
+                // Wait for the next block, with a timeout as safety net
+                timespec deadline{};
+                clock_gettime(CLOCK_REALTIME, &deadline);
+                deadline.tv_nsec += 5000000;
+                if (deadline.tv_nsec >= 1000000000) {
+                    deadline.tv_sec++;
+                    deadline.tv_nsec -= 1000000000;
+                }
+                while (sem_timedwait(&wake, &deadline) == -1 && errno == EINTR) {}
+            }
+        }
+
+        /** Convolve one period, leaving the wet signal in wet. Audio side. */
+        void process(const float *left, const float *right) {
+            if (hasTail && position == 0) {
+                bool ready = block >= validFrom && readyOutputs.load(std::memory_order_acquire) > block;
+                if (block >= validFrom && !ready) add(owner._lateTailBlocks, 1);
+                tailSlot = ready ? outputSlot(block, 0) : nullptr;
+            }
+            const float *input[2] = {left, right};
+            for (int c = 0; c < 2; c++) {
+                float *w = &wet[(size_t) c * periodFrames];
+                memset(w, 0, periodFrames * sizeof(float));
+                head[c]->process(input[c], w);
+                if (!hasTail) continue;
+                memcpy(inputSlot(block, c) + position, input[c], periodFrames * sizeof(float));
+                if (tailSlot != nullptr) {
+                    // Channels follow each other in the slot
+                    AeolusKernels::active().accumulateFloat(tailSlot + (size_t) c * tailFrames + position, 1.0f,
+                                                            w, periodFrames);
+                }
+            }
+            if (!hasTail) return;
+            position += periodFrames;
+            if (position == tailFrames) {
+                position = 0;
+                completedInputs.store(block + 1, std::memory_order_release);
+                if (background) {
+                    sem_post(&wake);
+                } else {
+                    convolveTail(block);
+                }
+                block++;
+            }
+        }
+    };
+
+    namespace {
+        // Its address marks a request to turn the convolution off in _pending
+        char offMarker;
+    }
+
+    AeolusConvolutionReverb::AeolusConvolutionReverb(int samplingRate, int periodFrames, int tailBlockFrames,
+                                                     int fadePeriods)
+            : _samplingRate(samplingRate), _periodFrames(periodFrames), _tailBlockFrames(tailBlockFrames),
+              _fadePeriods(fadePeriods) {
+    }
+
+    AeolusConvolutionReverb::~AeolusConvolutionReverb() {
+        collect();
+        Impulse *off = reinterpret_cast<Impulse *>(&offMarker);
+        Impulse *pending = _pending.exchange(nullptr);
+        if (pending != off) delete pending;
+        delete _current;
+    }
+
+    void AeolusConvolutionReverb::collect() {
+        delete _retired.exchange(nullptr, std::memory_order_acq_rel);
+    }
+
+    void AeolusConvolutionReverb::setTailInBackground(bool background) {
+        _tailInBackground.store(background, std::memory_order_relaxed);
+    }
+
+    void AeolusConvolutionReverb::setImpulseResponse(const float *samples, int frames, int channels, int samplingRate) {
+        Impulse *off = reinterpret_cast<Impulse *>(&offMarker);
+        Impulse *next = off;
+        int nChannels = std::min(channels, 2);
+        int length = 0;
+        if (samples != nullptr && frames > 0 && channels > 0 && samplingRate > 0) {
+            // Resample by linear interpolation, which is enough for the diffuse part that makes the room
+            double ratio = (double) samplingRate / _samplingRate;
+            length = (int) std::min((double) frames / ratio, maxImpulseSeconds * _samplingRate);
+            std::vector<float> response[2];
+            float peak = 0.0f;
+            for (int c = 0; c < nChannels; c++) {
+                response[c].resize(length);
+                for (int i = 0; i < length; i++) {
+                    double x = i * ratio;
+                    int j = (int) x;
+                    float f = (float) (x - j);
+                    float a = samples[(size_t) j * channels + c];
+                    float b = j + 1 < frames ? samples[(size_t) (j + 1) * channels + c] : 0.0f;
+                    response[c][i] = a + f * (b - a);
+                    peak = std::max(peak, std::fabs(response[c][i]));
+                }
+            }
+            // Cut the end once decayed, and scale to unit energy in the louder channel
+            while (length > 1) {
+                bool audible = false;
+                for (int c = 0; c < nChannels; c++) audible = audible || std::fabs(response[c][length - 1]) >= trimLevel * peak;
+                if (audible) break;
+                length--;
+            }
+            double energy = 0.0;
+            for (int c = 0; c < nChannels; c++) {
+                response[c].resize(length);
+                double e = 0.0;
+                for (float x: response[c]) e += (double) x * x;
+                energy = std::max(energy, e);
+            }
+            if (energy > 0.0) {
+                float scale = (float) (1.0 / sqrt(energy));
+                for (int c = 0; c < nChannels; c++) {
+                    for (float &x: response[c]) x *= scale;
+                }
+                next = new Impulse(*this, response, nChannels, _tailInBackground.load(std::memory_order_relaxed));
+            } else {
+                length = 0;
+            }
+        }
+        _impulseFrames.store(next == off ? 0 : length, std::memory_order_relaxed);
+        _impulseChannels.store(next == off ? 0 : nChannels, std::memory_order_relaxed);
+
+        collect();
+        Impulse *replaced = _pending.exchange(next, std::memory_order_acq_rel);
+        if (replaced != nullptr && replaced != off) delete replaced;
+        // Wait for the audio thread to take it over, such that the one it replaces can be freed here;
+        // when turning off, until the current one has faded out. Without audio callbacks, it is taken
+        // over when they start.
+        for (int i = 0; i < 200 && (_pending.load(std::memory_order_acquire) != nullptr ||
+                                    (next == off && _currentSet.load(std::memory_order_acquire))); i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        collect();
+    }
+
+    void AeolusConvolutionReverb::process(float *left, float *right, float wet) {
+        if (_retired.load(std::memory_order_acquire) == nullptr) {
+            Impulse *next = _pending.exchange(nullptr, std::memory_order_acq_rel);
+            if (next == reinterpret_cast<Impulse *>(&offMarker)) {
+                // Fade the current response out first, it is retired below once silent
+                _fadingOut = _current != nullptr;
+            } else if (next != nullptr) {
+                if (_current != nullptr) _retired.store(_current, std::memory_order_release);
+                _current = next;
+                _currentSet.store(true, std::memory_order_release);
+                // Fade the new response in
+                _wet = 0.0f;
+                _bypassed = false;
+                _fadingOut = false;
+            }
+        }
+        if (_current == nullptr) return;
+        if (_fadingOut) wet = 0.0f;
+        if (_wet == 0.0f && wet == 0.0f) {
+            if (_fadingOut && _retired.load(std::memory_order_acquire) == nullptr) {
+                _retired.store(_current, std::memory_order_release);
+                _current = nullptr;
+                _fadingOut = false;
+                _currentSet.store(false, std::memory_order_release);
+            }
+            _bypassed = true;
+            return;
+        }
+        auto start = std::chrono::steady_clock::now();
+        // A tail block convolved here is accounted for as tail
+        uint64_t tailBefore = _tailNanoseconds.load(std::memory_order_relaxed);
+        if (_bypassed) {
+            _current->reset();
+            _bypassed = false;
+        }
+        _current->process(left, right);
+
+        float *out[2] = {left, right};
+        float step = (wet > _wet ? 1.0f : -1.0f) / (float) (_fadePeriods * _periodFrames);
+        float gain = _wet;
+        for (int c = 0; c < 2; c++) {
+            const float *w = &_current->wet[(size_t) c * _periodFrames];
+            if (_wet == wet) {
+                AeolusKernels::active().accumulateFloat(w, wet, out[c], _periodFrames);
+                continue;
+            }
+            gain = _wet;
+            for (int i = 0; i < _periodFrames; i++) {
+                gain += step;
+                if ((step > 0.0f && gain > wet) || (step < 0.0f && gain < wet)) gain = wet;
+                out[c][i] += gain * w[i];
+            }
+        }
+        _wet = gain;
+        add(_periods, 1);
+        uint64_t ns = elapsedNanoseconds(start);
+        if (!_current->background) ns -= std::min(ns, _tailNanoseconds.load(std::memory_order_relaxed) - tailBefore);
+        add(_headNanoseconds, ns);
+    }
+
+    AeolusConvolutionReverb::Statistics AeolusConvolutionReverb::statistics() const {
+        Statistics s;
+        s.impulseFrames = _impulseFrames.load(std::memory_order_relaxed);
+        s.impulseChannels = _impulseChannels.load(std::memory_order_relaxed);
+        s.tailInBackground = _tailInBackground.load(std::memory_order_relaxed);
+        s.periods = _periods.load(std::memory_order_relaxed);
+        s.tailBlocks = _tailBlocks.load(std::memory_order_relaxed);
+        s.lateTailBlocks = _lateTailBlocks.load(std::memory_order_relaxed);
+        s.headNanoseconds = _headNanoseconds.load(std::memory_order_relaxed);
+        s.tailNanoseconds = _tailNanoseconds.load(std::memory_order_relaxed);
+        s.worstTailNanoseconds = _worstTailNanoseconds.load(std::memory_order_relaxed);
+        return s;
+    }
+}
@@ -0,0 +1,161 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIDI_SYNTH_AEOLUSCONVOLUTIONREVERB_H
+#define MIDI_SYNTH_AEOLUSCONVOLUTIONREVERB_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace Aeolussynthesizer {
+
+    /**
+     * @brief Stereo convolution with a measured impulse response, as a room model on the master output
+     *
+     * The impulse response is split in two parts, each convolved by uniformly partitioned convolution (see
+     * AeolusPartitionedConvolution). The head, the first two tail blocks of the response, is convolved in
+     * blocks of one engine period on the audio thread, so the convolution adds no latency. The tail, the
+     * rest of the response, is convolved in blocks of tailBlockFrames on a background thread: once a block
+     * of input is complete, the thread has the duration of one tail block to deliver its contribution,
+     * which only starts to sound two blocks later. A tail block not delivered in time is left out, and
+     * counted in Statistics::lateTailBlocks; the audio thread never waits. With the tail in the foreground
+     * (see setTailInBackground), the tail blocks are convolved on the audio thread as soon as their input
+     * is complete, for offline rendering, where the output must not depend on thread scheduling.<br />
+     * setImpulseResponse prepares the convolution on the calling thread, and the audio thread takes it
+     * over at its next period, fading the wet signal in; the one replaced is freed on the control side.
+     * Turning the convolution off fades the wet signal out over the same number of periods before the
+     * response is retired.
+     */
+    class AeolusConvolutionReverb {
+    public:
+        /** Longest impulse response used, longer ones are cut */
+        static constexpr double maxImpulseSeconds = 20.0;
+
+        /** Counters */
+        struct Statistics {
+            /** Frames of the impulse response in use after trimming and resampling, 0 when off */
+            int impulseFrames = 0;
+            /** Channels of the impulse response in use, 1 or 2 */
+            int impulseChannels = 0;
+            /** Is the tail convolved on the background thread? */
+            bool tailInBackground = true;
+            /** Engine periods convolved */
+            uint64_t periods = 0;
+            /** Tail blocks convolved */
+            uint64_t tailBlocks = 0;
+            /** Tail blocks not delivered in time, and left out */
+            uint64_t lateTailBlocks = 0;
+            /** Total time spent on the head, on the audio thread */
+            uint64_t headNanoseconds = 0;
+            /** Total time spent on the tail */
+            uint64_t tailNanoseconds = 0;
+            /** Longest time spent on a single tail block */
+            uint64_t worstTailNanoseconds = 0;
+        };
+
+        /**
+         * @param samplingRate Sampling rate of the output, in Hz
+         * @param periodFrames Frames per engine period, a power of two
+         * @param tailBlockFrames Frames per tail block, a power of two multiple of periodFrames
+         * @param fadePeriods Number of periods over which the wet signal fades in or out
+         */
+        AeolusConvolutionReverb(int samplingRate, int periodFrames, int tailBlockFrames, int fadePeriods);
+
+        ~AeolusConvolutionReverb();
+
+        AeolusConvolutionReverb(const AeolusConvolutionReverb &) = delete;
+
+        AeolusConvolutionReverb &operator=(const AeolusConvolutionReverb &) = delete;
+
+        /**
+         * Set the impulse response, from a control thread. The response is resampled to the output
+         * sampling rate, cut after it has decayed by 100 dB or after maxImpulseSeconds, and normalized
+         * to unit energy in its louder channel. Waits briefly for the audio thread to take it over.
+         * @param samples Interleaved samples, nullptr to turn the convolution off
+         * @param frames Number of frames, 0 to turn the convolution off
+         * @param channels Number of channels; mono responses are used for both output channels, and
+         * channels beyond the second are ignored
+         * @param samplingRate Sampling rate of the response, in Hz
+         */
+        void setImpulseResponse(const float *samples, int frames, int channels, int samplingRate);
+
+        /**
+         * Convolve the tail on a background thread (the default) or on the audio thread. Takes effect
+         * with the next setImpulseResponse.
+         * @param background True for a background thread
+         */
+        void setTailInBackground(bool background);
+
+        /** Is the tail convolved on a background thread? See setTailInBackground */
+        bool isTailInBackground() const { return _tailInBackground.load(std::memory_order_relaxed); }
+
+        /** Audio side: is an impulse response in use? False as soon as it fades out to be turned off. */
+        bool active() const { return _current != nullptr && !_fadingOut; }
+
+        /**
+         * Audio side: add the convolution of one period of output to it
+         * @param left Left channel, periodFrames frames, in place
+         * @param right Right channel, periodFrames frames, in place
+         * @param wet Gain of the convolved signal, faded to from the current one. At 0, once faded
+         * out, nothing is computed.
+         */
+        void process(float *left, float *right, float wet);
+
+        /**
+         * Read the counters, from any thread
+         * @return Copy of the counters
+         */
+        Statistics statistics() const;
+
+    private:
+        struct Impulse;
+
+        /** Free the impulse response replaced by the audio thread, if any. Control side. */
+        void collect();
+
+        const int _samplingRate;
+        const int _periodFrames;
+        const int _tailBlockFrames;
+        const int _fadePeriods;
+        std::atomic<bool> _tailInBackground{true};
+
+        /** Impulse response for the audio thread to take over, or the off marker */
+        std::atomic<Impulse *> _pending{nullptr};
+        /** Impulse response replaced by the audio thread, to be freed on the control side */
+        std::atomic<Impulse *> _retired{nullptr};
+
+        // Audio side state
+        Impulse *_current = nullptr;
+        float _wet = 0.0f;
+        bool _bypassed = false;
+        /** Turning off: _current fades out, and is retired once silent */
+        bool _fadingOut = false;
+        /** _current is set, for the control side to wait for the end of a fade-out */
+        std::atomic<bool> _currentSet{false};
+
+        std::atomic<int> _impulseFrames{0};
+        std::atomic<int> _impulseChannels{0};
+        std::atomic<uint64_t> _periods{0};
+        std::atomic<uint64_t> _tailBlocks{0};
+        std::atomic<uint64_t> _lateTailBlocks{0};
+        std::atomic<uint64_t> _headNanoseconds{0};
+        std::atomic<uint64_t> _tailNanoseconds{0};
+        std::atomic<uint64_t> _worstTailNanoseconds{0};
+    };
+}
+
+#endif //MIDI_SYNTH_AEOLUSCONVOLUTIONREVERB_H
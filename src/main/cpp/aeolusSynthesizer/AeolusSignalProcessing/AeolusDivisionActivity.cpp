@@ -0,0 +1,115 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "AeolusDivisionActivity.h"
+
+namespace Aeolussynthesizer {
+
+    namespace {
+        // Single writer: a relaxed load followed by a relaxed store is sufficient and avoids
+        // read-modify-write instructions on the audio thread
+        inline void add(std::atomic<uint64_t> &counter, uint64_t value) {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+    }
+
+    AeolusDivisionActivity::AeolusDivisionActivity(int releasePeriods, int fadePeriods)
+            : _releasePeriods(releasePeriods), _releaseLimit(releasePeriods), _fadePeriods(fadePeriods) {
+    }
+
+    void AeolusDivisionActivity::limitRelease(int periods) {
+        int limit = periods < 0 || periods > _releasePeriods ? _releasePeriods : periods;
+        if (limit > _releaseLimit) {
+            // Resuming the frozen tail of a division culled early would be heard as a click
+            for (auto &d: _divisions) {
+                if (d.periodsWithoutStops >= _releaseLimit) d.periodsWithoutStops = _releasePeriods;
+            }
+        }
+        _releaseLimit = limit;
+    }
+
+    void AeolusDivisionActivity::setEnabled(bool enabled) {
+        _enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    void AeolusDivisionActivity::setStopsActive(int division, bool active) {
+        if (division < 0 || division >= maxDivisions) return;
+        _divisions[division].stopsActive.store(active, std::memory_order_relaxed);
+    }
+
+    void AeolusDivisionActivity::beginPeriod() {
+        if (_resetRequested.load(std::memory_order_acquire)) {
+            for (auto &d: _divisions) {
+                d.processedPeriods.store(0, std::memory_order_relaxed);
+                d.culledPeriods.store(0, std::memory_order_relaxed);
+                d.ticks.store(0, std::memory_order_relaxed);
+                d.worstTicks.store(0, std::memory_order_relaxed);
+            }
+            _resetRequested.store(false, std::memory_order_release);
+        }
+    }
+
+    bool AeolusDivisionActivity::shouldProcess(int division, bool gainIsZero) {
+        if (division < 0 || division >= maxDivisions) return true;
+        Division &d = _divisions[division];
+
+        // The counters saturate at the limits, which is all that matters
+        if (d.stopsActive.load(std::memory_order_relaxed)) {
+            d.periodsWithoutStops = 0;
+        } else if (d.periodsWithoutStops < _releasePeriods) {
+            d.periodsWithoutStops++;
+        }
+        if (!gainIsZero) {
+            d.periodsAtZeroGain = 0;
+        } else if (d.periodsAtZeroGain < _fadePeriods) {
+            d.periodsAtZeroGain++;
+        }
+
+        bool idle = d.periodsWithoutStops >= _releaseLimit || d.periodsAtZeroGain >= _fadePeriods;
+        bool culled = idle && _enabled.load(std::memory_order_relaxed);
+        d.culled.store(culled, std::memory_order_relaxed);
+        if (culled) add(d.culledPeriods, 1);
+        return !culled;
+    }
+
+    void AeolusDivisionActivity::recordProcessed(int division, uint64_t ticks) {
+        if (division < 0 || division >= maxDivisions) return;
+        Division &d = _divisions[division];
+        add(d.processedPeriods, 1);
+        add(d.ticks, ticks);
+        if (ticks > d.worstTicks.load(std::memory_order_relaxed)) {
+            d.worstTicks.store(ticks, std::memory_order_relaxed);
+        }
+    }
+
+    AeolusDivisionActivity::DivisionStatistics AeolusDivisionActivity::statistics(int division) const {
+        DivisionStatistics s;
+        if (division < 0 || division >= maxDivisions) return s;
+        const Division &d = _divisions[division];
+        s.processedPeriods = d.processedPeriods.load(std::memory_order_relaxed);
+        s.culledPeriods = d.culledPeriods.load(std::memory_order_relaxed);
+        s.ticks = d.ticks.load(std::memory_order_relaxed);
+        s.worstTicks = d.worstTicks.load(std::memory_order_relaxed);
+        s.culled = d.culled.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    void AeolusDivisionActivity::requestReset() {
+        _resetRequested.store(true, std::memory_order_release);
+    }
+
+}
@@ -0,0 +1,148 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIDI_SYNTH_AEOLUSDIVISIONACTIVITY_H
+#define MIDI_SYNTH_AEOLUSDIVISIONACTIVITY_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace Aeolussynthesizer {
+
+    /**
+     * @brief Decides which divisions need rendering, and accounts for the render time per division
+     *
+     * A division without active stops only renders the release tails of its pipes, and once these have
+     * decayed, it only adds zeros to its audio section. Likewise, the output of a division whose gain
+     * (see AeolusAudio::setVolumeForDivision) is zero fades to nothing within a few hundred milliseconds,
+     * as the engine moves the gain by at most 5% per period. Such divisions are culled, that is not
+     * processed at all, after releasePeriods periods without stops or fadePeriods periods at zero gain.
+     * A culled division keeps the state of its pipes, and carries on from there as soon as stops or gain
+     * come back.<br />
+     * The stop state is provided by the control side for each division, from any thread. The audio side
+     * asks shouldProcess for each division and period; this happens on the audio thread or on a render
+     * worker, but for a given period, a division is only ever seen by one thread. The number of processed
+     * and culled periods and the render time of each division are recorded, and can be read from any
+     * thread. As for AeolusCallbackStats, resetting is requested by the reader and carried out on the
+     * audio thread, in beginPeriod.
+     */
+    class AeolusDivisionActivity {
+    public:
+        /** Maximum number of divisions tracked, as NDIVIS in the Aeolus engine */
+        static constexpr int maxDivisions = 8;
+
+        /** Activity of a division */
+        struct DivisionStatistics {
+            /** Number of periods the division was processed */
+            uint64_t processedPeriods = 0;
+            /** Number of periods the division was skipped */
+            uint64_t culledPeriods = 0;
+            /** Total cycle counter ticks spent processing the division, see AeolusRenderProfiler::readCycleCounter */
+            uint64_t ticks = 0;
+            /** Largest number of ticks spent processing the division in a single period */
+            uint64_t worstTicks = 0;
+            /** Is the division culled at present? */
+            bool culled = false;
+        };
+
+        /**
+         * @param releasePeriods Periods without active stops after which a division is culled
+         * @param fadePeriods Periods at zero gain after which a division is culled
+         */
+        AeolusDivisionActivity(int releasePeriods, int fadePeriods);
+
+        /**
+         * Turn culling on or off; when off, shouldProcess always returns true, but the statistics
+         * are still recorded. Can be called from any thread.
+         * @param enabled True to cull idle divisions
+         */
+        void setEnabled(bool enabled);
+
+        /** Is culling on? */
+        bool isEnabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+        /**
+         * Tell whether a division has active stops. Divisions are assumed to have active stops until
+         * told otherwise. Can be called from any thread.
+         * @param division Index of the division
+         * @param active True if at least one stop of the division is active
+         */
+        void setStopsActive(int division, bool active);
+
+        /**
+         * Cull divisions without active stops after at most the given number of periods rather than
+         * releasePeriods, cutting their release tails short, e.g. under CPU pressure. Divisions culled
+         * meanwhile stay culled until their stops come back. Audio thread only.
+         * @param periods Maximum number of periods, negative to go back to releasePeriods
+         */
+        void limitRelease(int periods);
+
+        /** Start of an engine period, before any call to shouldProcess. Audio thread only. */
+        void beginPeriod();
+
+        /**
+         * Does a division need processing in this period? Counts the period as culled if not.
+         * @param division Index of the division
+         * @param gainIsZero True if the gain of the division is currently set to zero
+         * @return True if the division has to be processed
+         */
+        bool shouldProcess(int division, bool gainIsZero);
+
+        /**
+         * Record the time spent processing a division in this period
+         * @param division Index of the division
+         * @param ticks Cycle counter ticks spent
+         */
+        void recordProcessed(int division, uint64_t ticks);
+
+        /**
+         * Read the activity of a division, from any thread
+         * @param division Index of the division
+         * @return Copy of the statistics
+         */
+        DivisionStatistics statistics(int division) const;
+
+        /**
+         * Ask the audio thread to clear the statistics at its next period
+         */
+        void requestReset();
+
+    private:
+        struct Division {
+            std::atomic<bool> stopsActive{true};
+            // Audio side state
+            int periodsWithoutStops = 0;
+            int periodsAtZeroGain = 0;
+            // Statistics, single writer at a time
+            std::atomic<uint64_t> processedPeriods{0};
+            std::atomic<uint64_t> culledPeriods{0};
+            std::atomic<uint64_t> ticks{0};
+            std::atomic<uint64_t> worstTicks{0};
+            std::atomic<bool> culled{false};
+        };
+
+        const int _releasePeriods;
+        /** Release periods in effect, audio side */
+        int _releaseLimit;
+        const int _fadePeriods;
+        std::atomic<bool> _enabled{true};
+        std::atomic<bool> _resetRequested{false};
+        Division _divisions[maxDivisions];
+    };
+}
+
+#endif //MIDI_SYNTH_AEOLUSDIVISIONACTIVITY_H
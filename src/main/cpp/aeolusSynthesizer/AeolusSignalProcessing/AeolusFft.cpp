@@ -0,0 +1,126 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "AeolusFft.h"
+#include <cmath>
+
+namespace Aeolussynthesizer {
+
+    AeolusFft::AeolusFft(int size)
+            : _size(size), _bitReversed(size / 2), _cos(size / 4), _sin(size / 4),
+              _splitCos(size / 2 + 1), _splitSin(size / 2 + 1), _re(size / 2), _im(size / 2) {
+        int m = size / 2;
+        int bits = 0;
+        while ((1 << bits) < m) bits++;
+        for (int i = 0; i < m; i++) {
+            int r = 0;
+            for (int b = 0; b < bits; b++) r |= ((i >> b) & 1) << (bits - 1 - b);
+            _bitReversed[i] = r;
+        }
+        // In double precision, such that the tables are exact to float precision
+        for (int k = 0; k < m / 2; k++) {
+            _cos[k] = (float) cos(2 * M_PI * k / m);
+            _sin[k] = (float) sin(2 * M_PI * k / m);
+        }
+        for (int k = 0; k <= m; k++) {
+            _splitCos[k] = (float) cos(2 * M_PI * k / size);
+            _splitSin[k] = (float) sin(2 * M_PI * k / size);
+        }
+    }
+
+    void AeolusFft::transform(float *re, float *im, bool forward) {
+        int m = _size / 2;
+        for (int i = 0; i < m; i++) {
+            int j = _bitReversed[i];
+            if (j > i) {
+                float t = re[i];
+                re[i] = re[j];
+                re[j] = t;
+                t = im[i];
+                im[i] = im[j];
+                im[j] = t;
+            }
+        }
+        float sign = forward ? -1.0f : 1.0f;
+        for (int length = 2; length <= m; length <<= 1) {
+            int half = length / 2;
+            int stride = m / length;
+            for (int start = 0; start < m; start += length) {
+                for (int j = 0; j < half; j++) {
+                    float wr = _cos[j * stride];
+                    float wi = sign * _sin[j * stride];
+                    int a = start + j;
+                    int b = a + half;
+                    float tr = re[b] * wr - im[b] * wi;
+                    float ti = re[b] * wi + im[b] * wr;
+                    re[b] = re[a] - tr;
+                    im[b] = im[a] - ti;
+                    re[a] += tr;
+                    im[a] += ti;
+                }
+            }
+        }
+    }
+
+    void AeolusFft::forward(const float *input, float *re, float *im) {
+        int m = _size / 2;
+        for (int n = 0; n < m; n++) {
+            _re[n] = input[2 * n];
+            _im[n] = input[2 * n + 1];
+        }
+        transform(_re.data(), _im.data(), true);
+        // With Z the transform of the even (real part) and odd (imaginary part) samples, their spectra
+        // are E = (Z[k] + conj(Z[M-k]))/2 and O = (Z[k] - conj(Z[M-k]))/2i, and X[k] = E + e^(-2 pi i k/N) O
+        for (int k = 0; k <= m; k++) {
+            int a = k < m ? k : 0;
+            int b = k > 0 ? m - k : 0;
+            float er = 0.5f * (_re[a] + _re[b]);
+            float ei = 0.5f * (_im[a] - _im[b]);
+            float oddRe = 0.5f * (_im[a] + _im[b]);
+            float oddIm = -0.5f * (_re[a] - _re[b]);
+            float wr = _splitCos[k];
+            float wi = -_splitSin[k];
+            re[k] = er + wr * oddRe - wi * oddIm;
+            im[k] = ei + wr * oddIm + wi * oddRe;
+        }
+    }
+
+    void AeolusFft::inverse(const float *re, const float *im, float *output) {
+        int m = _size / 2;
+        // The reverse of the split: E = (X[k] + conj(X[M-k]))/2, O = (X[k] - conj(X[M-k]))/2 e^(2 pi i k/N),
+        // and Z[k] = E + i O
+        for (int k = 0; k < m; k++) {
+            int b = m - k;
+            float er = 0.5f * (re[k] + re[b]);
+            float ei = 0.5f * (im[k] - im[b]);
+            float dr = 0.5f * (re[k] - re[b]);
+            float di = 0.5f * (im[k] + im[b]);
+            float wr = _splitCos[k];
+            float wi = _splitSin[k];
+            float oddRe = dr * wr - di * wi;
+            float oddIm = dr * wi + di * wr;
+            _re[k] = er - oddIm;
+            _im[k] = ei + oddRe;
+        }
+        transform(_re.data(), _im.data(), false);
+        float scale = 1.0f / (float) m;
+        for (int n = 0; n < m; n++) {
+            output[2 * n] = scale * _re[n];
+            output[2 * n + 1] = scale * _im[n];
+        }
+    }
+}
@@ -0,0 +1,83 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIDI_SYNTH_AEOLUSFFT_H
+#define MIDI_SYNTH_AEOLUSFFT_H
+
+#include <vector>
+
+namespace Aeolussynthesizer {
+
+    /**
+     * @brief Fast Fourier transform of real signals, for power of two sizes
+     *
+     * The real signal of size N is transformed as a complex signal of size N/2 (even samples as real
+     * part, odd samples as imaginary part) by an iterative radix-2 transform, followed by the split into
+     * the N/2+1 bins of the real spectrum. Spectra are kept as separate arrays of real and imaginary
+     * parts, such that products of spectra vectorize (see AeolusKernels::multiplyAccumulateComplex).<br />
+     * The tables are computed by the constructor; forward and inverse use scratch buffers of the object,
+     * so an object is meant to be used by one thread at a time.
+     */
+    class AeolusFft {
+    public:
+        /**
+         * @param size Number of real samples, a power of two of at least 4
+         */
+        explicit AeolusFft(int size);
+
+        /** Number of real samples */
+        int size() const { return _size; }
+
+        /** Number of bins of the spectrum, size()/2+1 */
+        int bins() const { return _size / 2 + 1; }
+
+        /**
+         * Spectrum of a real signal
+         * @param input size() samples
+         * @param re Real parts of the bins() bins
+         * @param im Imaginary parts of the bins() bins
+         */
+        void forward(const float *input, float *re, float *im);
+
+        /**
+         * Real signal from its spectrum, such that inverse(forward(x)) gives x
+         * @param re Real parts of the bins() bins
+         * @param im Imaginary parts of the bins() bins
+         * @param output size() samples
+         */
+        void inverse(const float *re, const float *im, float *output);
+
+    private:
+        /** In place complex transform of size _size/2, e^(-2 pi i kn/M) if forward, else e^(+2 pi i kn/M) */
+        void transform(float *re, float *im, bool forward);
+
+        int _size;
+        /** Bit reversed index of each index of the complex transform */
+        std::vector<int> _bitReversed;
+        /** cos and sin of 2 pi k/(N/2), for k < N/4, for the complex transform */
+        std::vector<float> _cos;
+        std::vector<float> _sin;
+        /** cos and sin of 2 pi k/N, for k <= N/2, for the split into the real spectrum */
+        std::vector<float> _splitCos;
+        std::vector<float> _splitSin;
+        /** Complex signal of size N/2 */
+        std::vector<float> _re;
+        std::vector<float> _im;
+    };
+}
+
+#endif //MIDI_SYNTH_AEOLUSFFT_H
@@ -0,0 +1,78 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "AeolusIdleDetector.h"
+
+namespace Aeolussynthesizer {
+
+    namespace {
+        inline void add(std::atomic<uint64_t> &counter, uint64_t value) {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+    }
+
+    AeolusIdleDetector::AeolusIdleDetector(float threshold, int holdPeriods)
+            : _threshold(threshold), _holdPeriods(holdPeriods) {
+    }
+
+    void AeolusIdleDetector::setEnabled(bool enabled) {
+        _enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    void AeolusIdleDetector::rendered(float *const *channels, int nChannels, int frames, bool activity) {
+        add(_renderedPeriods, 1);
+        if (activity || !_enabled.load(std::memory_order_relaxed)) {
+            _quietPeriods = 0;
+            return;
+        }
+        // Denormals and any other residue far below the threshold count as silence
+        float peak = 0.0f;
+        for (int c = 0; c < nChannels; c++) {
+            const float *x = channels[c];
+            for (int i = 0; i < frames; i++) {
+                float a = x[i] < 0.0f ? -x[i] : x[i];
+                peak = a > peak ? a : peak;
+            }
+        }
+        if (peak >= _threshold) {
+            _quietPeriods = 0;
+        } else if (++_quietPeriods >= _holdPeriods) {
+            _idle = true;
+            _idleFlag.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    void AeolusIdleDetector::idlePeriod() {
+        add(_idlePeriods, 1);
+    }
+
+    void AeolusIdleDetector::wake() {
+        _idle = false;
+        _quietPeriods = 0;
+        _idleFlag.store(false, std::memory_order_relaxed);
+        add(_wakeUps, 1);
+    }
+
+    AeolusIdleDetector::Statistics AeolusIdleDetector::statistics() const {
+        Statistics s;
+        s.renderedPeriods = _renderedPeriods.load(std::memory_order_relaxed);
+        s.idlePeriods = _idlePeriods.load(std::memory_order_relaxed);
+        s.wakeUps = _wakeUps.load(std::memory_order_relaxed);
+        s.idle = _idleFlag.load(std::memory_order_relaxed);
+        return s;
+    }
+}
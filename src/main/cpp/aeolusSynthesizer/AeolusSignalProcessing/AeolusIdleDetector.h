@@ -0,0 +1,108 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIDI_SYNTH_AEOLUSIDLEDETECTOR_H
+#define MIDI_SYNTH_AEOLUSIDLEDETECTOR_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace Aeolussynthesizer {
+
+    /**
+     * @brief Detects when the synthesizer has fallen silent, so that rendering can be suspended
+     *
+     * The audio side reports, for each rendered period, whether there was any activity (input from
+     * the queues, held notes, control changes) and passes the rendered audio. Once there has been no
+     * activity and the peak level of the output has stayed below the threshold for holdPeriods periods,
+     * i.e. the release tails and the reverb have decayed, the detector goes idle. While idle, the audio
+     * side outputs zeros instead of rendering, and calls idlePeriod; at the first activity, it calls wake
+     * and renders again.<br />
+     * As for AeolusCallbackStats, the audio side is the only writer and never waits; the counters can
+     * be read from any thread.
+     */
+    class AeolusIdleDetector {
+    public:
+        /** Counters */
+        struct Statistics {
+            /** Periods rendered */
+            uint64_t renderedPeriods = 0;
+            /** Periods skipped while idle */
+            uint64_t idlePeriods = 0;
+            /** Number of times rendering resumed after being idle */
+            uint64_t wakeUps = 0;
+            /** Is rendering suspended at present? */
+            bool idle = false;
+        };
+
+        /**
+         * @param threshold Peak level below which the output counts as silent
+         * @param holdPeriods Number of silent periods without activity before going idle
+         */
+        AeolusIdleDetector(float threshold, int holdPeriods);
+
+        /**
+         * Allow or forbid suspending the rendering, from any thread. When forbidden, the audio side
+         * wakes up at its next period.
+         * @param enabled True to suspend rendering when silent
+         */
+        void setEnabled(bool enabled);
+
+        /** Is suspending allowed? */
+        bool isEnabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+        /** Is rendering suspended? Audio side. */
+        bool idle() const { return _idle; }
+
+        /**
+         * Audio side: a period has been rendered
+         * @param channels Planar output of the period
+         * @param nChannels Number of channels
+         * @param frames Frames per channel
+         * @param activity True if there was input or anything else that may sound soon
+         */
+        void rendered(float *const *channels, int nChannels, int frames, bool activity);
+
+        /** Audio side: a period was skipped while idle */
+        void idlePeriod();
+
+        /** Audio side: resume rendering */
+        void wake();
+
+        /**
+         * Read the counters, from any thread
+         * @return Copy of the counters
+         */
+        Statistics statistics() const;
+
+    private:
+        const float _threshold;
+        const int _holdPeriods;
+        std::atomic<bool> _enabled{true};
+
+        // Audio side state
+        bool _idle = false;
+        int _quietPeriods = 0;
+
+        std::atomic<uint64_t> _renderedPeriods{0};
+        std::atomic<uint64_t> _idlePeriods{0};
+        std::atomic<uint64_t> _wakeUps{0};
+        std::atomic<bool> _idleFlag{false};
+    };
+}
+
+#endif //MIDI_SYNTH_AEOLUSIDLEDETECTOR_H
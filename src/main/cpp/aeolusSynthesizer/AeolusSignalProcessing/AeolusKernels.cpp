@@ -0,0 +1,476 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "AeolusKernels.h"
+#include <atomic>
+#include <cstring>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+// AVX2 kernels are compiled with a function target attribute, and only called if the CPU supports AVX2
+#define AEOLUS_KERNELS_AVX2
+#define AEOLUS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace Aeolussynthesizer {
+
+    namespace {
+
+        // Scalar reference, also used for the frames left over by the vector kernels
+
+        void mixStereoScalar(const float *W, const float *X, const float *Y, float pposit,
+                             float *left, float *right, int frames) {
+            for (int i = 0; i < frames; i++) {
+                left[i] = W[i] + pposit * X[i] + Y[i];
+                right[i] = W[i] + pposit * X[i] - Y[i];
+            }
+        }
+
+        void interleaveStereoFloatScalar(const float *left, const float *right, float *output, int frames, float gain) {
+            for (int i = 0; i < frames; i++) {
+                output[2 * i] = gain * left[i];
+                output[2 * i + 1] = gain * right[i];
+            }
+        }
+
+        void downmixMonoFloatScalar(const float *left, const float *right, float *output, int frames, float gain) {
+            float g2 = 0.5f * gain;
+            for (int i = 0; i < frames; i++) {
+                output[i] = g2 * (left[i] + right[i]);
+            }
+        }
+
+        void accumulateFloatScalar(const float *samples, float gain, float *output, int frames) {
+            for (int i = 0; i < frames; i++) {
+                output[i] += gain * samples[i];
+            }
+        }
+
+        void crossfadeScalar(const float *dry, float *wet, float gain, float step, int frames) {
+            for (int i = 0; i < frames; i++) {
+                float g = gain + (float) (i + 1) * step;
+                g = g < 0.0f ? 0.0f : (g > 1.0f ? 1.0f : g);
+                wet[i] = dry[i] + g * (wet[i] - dry[i]);
+            }
+        }
+
+        void multiplyAccumulateComplexScalar(const float *aRe, const float *aIm, const float *bRe, const float *bIm,
+                                             float *sumRe, float *sumIm, int bins) {
+            for (int i = 0; i < bins; i++) {
+                sumRe[i] += aRe[i] * bRe[i] - aIm[i] * bIm[i];
+                sumIm[i] += aRe[i] * bIm[i] + aIm[i] * bRe[i];
+            }
+        }
+
+        const AeolusKernels scalarKernels{
+                AeolusKernels::SCALAR,
+                mixStereoScalar,
+                interleaveStereoFloatScalar,
+                downmixMonoFloatScalar,
+                accumulateFloatScalar,
+                crossfadeScalar,
+                multiplyAccumulateComplexScalar
+        };
+
+#if defined(__aarch64__)
+
+        void mixStereoNeon(const float *W, const float *X, const float *Y, float pposit,
+                           float *left, float *right, int frames) {
+            float32x4_t p = vdupq_n_f32(pposit);
+            int i = 0;
+            for (; i + 4 <= frames; i += 4) {
+                float32x4_t m = vmlaq_f32(vld1q_f32(W + i), p, vld1q_f32(X + i));
+                float32x4_t y = vld1q_f32(Y + i);
+                vst1q_f32(left + i, vaddq_f32(m, y));
+                vst1q_f32(right + i, vsubq_f32(m, y));
+            }
+            mixStereoScalar(W + i, X + i, Y + i, pposit, left + i, right + i, frames - i);
+        }
+
+        void interleaveStereoFloatNeon(const float *left, const float *right, float *output, int frames, float gain) {
+            float32x4_t g = vdupq_n_f32(gain);
+            int i = 0;
+            for (; i + 4 <= frames; i += 4) {
+                float32x4x2_t lr;
+                lr.val[0] = vmulq_f32(vld1q_f32(left + i), g);
+                lr.val[1] = vmulq_f32(vld1q_f32(right + i), g);
+                vst2q_f32(output + 2 * i, lr);
+            }
+            interleaveStereoFloatScalar(left + i, right + i, output + 2 * i, frames - i, gain);
+        }
+
+        void downmixMonoFloatNeon(const float *left, const float *right, float *output, int frames, float gain) {
+            float32x4_t g = vdupq_n_f32(0.5f * gain);
+            int i = 0;
+            for (; i + 4 <= frames; i += 4) {
+                vst1q_f32(output + i, vmulq_f32(vaddq_f32(vld1q_f32(left + i), vld1q_f32(right + i)), g));
+            }
+            downmixMonoFloatScalar(left + i, right + i, output + i, frames - i, gain);
+        }
+
+        void accumulateFloatNeon(const float *samples, float gain, float *output, int frames) {
+            float32x4_t g = vdupq_n_f32(gain);
+            int i = 0;
+            for (; i + 4 <= frames; i += 4) {
+                vst1q_f32(output + i, vmlaq_f32(vld1q_f32(output + i), g, vld1q_f32(samples + i)));
+            }
+            accumulateFloatScalar(samples + i, gain, output + i, frames - i);
+        }
+
+        void crossfadeNeon(const float *dry, float *wet, float gain, float step, int frames) {
+            const float ramp[4] = {1.0f, 2.0f, 3.0f, 4.0f};
+            float32x4_t r = vmulq_n_f32(vld1q_f32(ramp), step);
+            float32x4_t zero = vdupq_n_f32(0.0f);
+            float32x4_t one = vdupq_n_f32(1.0f);
+            int i = 0;
+            for (; i + 4 <= frames; i += 4) {
+                float32x4_t g = vminq_f32(vmaxq_f32(vaddq_f32(vdupq_n_f32(gain + (float) i * step), r), zero), one);
+                float32x4_t d = vld1q_f32(dry + i);
+                vst1q_f32(wet + i, vmlaq_f32(d, g, vsubq_f32(vld1q_f32(wet + i), d)));
+            }
+            crossfadeScalar(dry + i, wet + i, gain + (float) i * step, step, frames - i);
+        }
+
+        void multiplyAccumulateComplexNeon(const float *aRe, const float *aIm, const float *bRe, const float *bIm,
+                                           float *sumRe, float *sumIm, int bins) {
+            int i = 0;
+            for (; i + 4 <= bins; i += 4) {
+                float32x4_t ar = vld1q_f32(aRe + i);
+                float32x4_t ai = vld1q_f32(aIm + i);
+                float32x4_t br = vld1q_f32(bRe + i);
+                float32x4_t bi = vld1q_f32(bIm + i);
+                vst1q_f32(sumRe + i, vmlsq_f32(vmlaq_f32(vld1q_f32(sumRe + i), ar, br), ai, bi));
+                vst1q_f32(sumIm + i, vmlaq_f32(vmlaq_f32(vld1q_f32(sumIm + i), ar, bi), ai, br));
+            }
+            multiplyAccumulateComplexScalar(aRe + i, aIm + i, bRe + i, bIm + i, sumRe + i, sumIm + i, bins - i);
+        }
+
+        const AeolusKernels neonKernels{
+                AeolusKernels::NEON,
+                mixStereoNeon,
+                interleaveStereoFloatNeon,
+                downmixMonoFloatNeon,
+                accumulateFloatNeon,
+                crossfadeNeon,
+                multiplyAccumulateComplexNeon
+        };
+
+#elif defined(__SSE2__)
+
+        void mixStereoSse2(const float *W, const float *X, const float *Y, float pposit,
+                           float *left, float *right, int frames) {
+            __m128 p = _mm_set1_ps(pposit);
+            int i = 0;
+            for (; i + 4 <= frames; i += 4) {
+                __m128 m = _mm_add_ps(_mm_loadu_ps(W + i), _mm_mul_ps(p, _mm_loadu_ps(X + i)));
+                __m128 y = _mm_loadu_ps(Y + i);
+                _mm_storeu_ps(left + i, _mm_add_ps(m, y));
+                _mm_storeu_ps(right + i, _mm_sub_ps(m, y));
+            }
+            mixStereoScalar(W + i, X + i, Y + i, pposit, left + i, right + i, frames - i);
+        }
+
+        void interleaveStereoFloatSse2(const float *left, const float *right, float *output, int frames, float gain) {
+            __m128 g = _mm_set1_ps(gain);
+            int i = 0;
+            for (; i + 4 <= frames; i += 4) {
+                __m128 l = _mm_mul_ps(_mm_loadu_ps(left + i), g);
+                __m128 r = _mm_mul_ps(_mm_loadu_ps(right + i), g);
+                _mm_storeu_ps(output + 2 * i, _mm_unpacklo_ps(l, r));
+                _mm_storeu_ps(output + 2 * i + 4, _mm_unpackhi_ps(l, r));
+            }
+            interleaveStereoFloatScalar(left + i, right + i, output + 2 * i, frames - i, gain);
+        }
+
+        void downmixMonoFloatSse2(const float *left, const float *right, float *output, int frames, float gain) {
+            __m128 g = _mm_set1_ps(0.5f * gain);
+            int i = 0;
+            for (; i + 4 <= frames; i += 4) {
+                _mm_storeu_ps(output + i, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(left + i), _mm_loadu_ps(right + i)), g));
+            }
+            downmixMonoFloatScalar(left + i, right + i, output + i, frames - i, gain);
+        }
+
+        void accumulateFloatSse2(const float *samples, float gain, float *output, int frames) {
+            __m128 g = _mm_set1_ps(gain);
+            int i = 0;
+            for (; i + 4 <= frames; i += 4) {
+                _mm_storeu_ps(output + i, _mm_add_ps(_mm_loadu_ps(output + i), _mm_mul_ps(g, _mm_loadu_ps(samples + i))));
+            }
+            accumulateFloatScalar(samples + i, gain, output + i, frames - i);
+        }
+
+        void crossfadeSse2(const float *dry, float *wet, float gain, float step, int frames) {
+            __m128 r = _mm_mul_ps(_mm_setr_ps(1.0f, 2.0f, 3.0f, 4.0f), _mm_set1_ps(step));
+            __m128 zero = _mm_setzero_ps();
+            __m128 one = _mm_set1_ps(1.0f);
+            int i = 0;
+            for (; i + 4 <= frames; i += 4) {
+                __m128 g = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_set1_ps(gain + (float) i * step), r), zero), one);
+                __m128 d = _mm_loadu_ps(dry + i);
+                _mm_storeu_ps(wet + i, _mm_add_ps(d, _mm_mul_ps(g, _mm_sub_ps(_mm_loadu_ps(wet + i), d))));
+            }
+            crossfadeScalar(dry + i, wet + i, gain + (float) i * step, step, frames - i);
+        }
+
+        void multiplyAccumulateComplexSse2(const float *aRe, const float *aIm, const float *bRe, const float *bIm,
+                                           float *sumRe, float *sumIm, int bins) {
+            int i = 0;
+            for (; i + 4 <= bins; i += 4) {
+                __m128 ar = _mm_loadu_ps(aRe + i);
+                __m128 ai = _mm_loadu_ps(aIm + i);
+                __m128 br = _mm_loadu_ps(bRe + i);
+                __m128 bi = _mm_loadu_ps(bIm + i);
+                __m128 re = _mm_sub_ps(_mm_mul_ps(ar, br), _mm_mul_ps(ai, bi));
+                __m128 im = _mm_add_ps(_mm_mul_ps(ar, bi), _mm_mul_ps(ai, br));
+                _mm_storeu_ps(sumRe + i, _mm_add_ps(_mm_loadu_ps(sumRe + i), re));
+                _mm_storeu_ps(sumIm + i, _mm_add_ps(_mm_loadu_ps(sumIm + i), im));
+            }
+            multiplyAccumulateComplexScalar(aRe + i, aIm + i, bRe + i, bIm + i, sumRe + i, sumIm + i, bins - i);
+        }
+
+        const AeolusKernels sse2Kernels{
+                AeolusKernels::SSE2,
+                mixStereoSse2,
+                interleaveStereoFloatSse2,
+                downmixMonoFloatSse2,
+                accumulateFloatSse2,
+                crossfadeSse2,
+                multiplyAccumulateComplexSse2
+        };
+
+#endif
+
+#if defined(AEOLUS_KERNELS_AVX2)
+
+        AEOLUS_TARGET_AVX2
+        void mixStereoAvx2(const float *W, const float *X, const float *Y, float pposit,
+                           float *left, float *right, int frames) {
+            __m256 p = _mm256_set1_ps(pposit);
+            int i = 0;
+            for (; i + 8 <= frames; i += 8) {
+                __m256 m = _mm256_add_ps(_mm256_loadu_ps(W + i), _mm256_mul_ps(p, _mm256_loadu_ps(X + i)));
+                __m256 y = _mm256_loadu_ps(Y + i);
+                _mm256_storeu_ps(left + i, _mm256_add_ps(m, y));
+                _mm256_storeu_ps(right + i, _mm256_sub_ps(m, y));
+            }
+            // Back to SSE code: clear the upper halves to avoid the AVX-SSE transition penalty
+            _mm256_zeroupper();
+            mixStereoScalar(W + i, X + i, Y + i, pposit, left + i, right + i, frames - i);
+        }
+
+        AEOLUS_TARGET_AVX2
+        void interleaveStereoFloatAvx2(const float *left, const float *right, float *output, int frames, float gain) {
+            __m256 g = _mm256_set1_ps(gain);
+            int i = 0;
+            for (; i + 8 <= frames; i += 8) {
+                __m256 l = _mm256_mul_ps(_mm256_loadu_ps(left + i), g);
+                __m256 r = _mm256_mul_ps(_mm256_loadu_ps(right + i), g);
+                // Interleaving works within 128 bit lanes, the lane permutation puts the frames in order
+                __m256 lo = _mm256_unpacklo_ps(l, r);
+                __m256 hi = _mm256_unpackhi_ps(l, r);
+                _mm256_storeu_ps(output + 2 * i, _mm256_permute2f128_ps(lo, hi, 0x20));
+                _mm256_storeu_ps(output + 2 * i + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+            }
+            // Back to SSE code: clear the upper halves to avoid the AVX-SSE transition penalty
+            _mm256_zeroupper();
+            interleaveStereoFloatScalar(left + i, right + i, output + 2 * i, frames - i, gain);
+        }
+
+        AEOLUS_TARGET_AVX2
+        void downmixMonoFloatAvx2(const float *left, const float *right, float *output, int frames, float gain) {
+            __m256 g = _mm256_set1_ps(0.5f * gain);
+            int i = 0;
+            for (; i + 8 <= frames; i += 8) {
+                _mm256_storeu_ps(output + i,
+                                 _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(left + i), _mm256_loadu_ps(right + i)), g));
+            }
+            // Back to SSE code: clear the upper halves to avoid the AVX-SSE transition penalty
+            _mm256_zeroupper();
+            downmixMonoFloatScalar(left + i, right + i, output + i, frames - i, gain);
+        }
+
+        AEOLUS_TARGET_AVX2
+        void accumulateFloatAvx2(const float *samples, float gain, float *output, int frames) {
+            __m256 g = _mm256_set1_ps(gain);
+            int i = 0;
+            for (; i + 8 <= frames; i += 8) {
+                _mm256_storeu_ps(output + i,
+                                 _mm256_add_ps(_mm256_loadu_ps(output + i), _mm256_mul_ps(g, _mm256_loadu_ps(samples + i))));
+            }
+            // Back to SSE code: clear the upper halves to avoid the AVX-SSE transition penalty
+            _mm256_zeroupper();
+            accumulateFloatScalar(samples + i, gain, output + i, frames - i);
+        }
+
+        AEOLUS_TARGET_AVX2
+        void crossfadeAvx2(const float *dry, float *wet, float gain, float step, int frames) {
+            __m256 r = _mm256_mul_ps(_mm256_setr_ps(1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f),
+                                     _mm256_set1_ps(step));
+            __m256 zero = _mm256_setzero_ps();
+            __m256 one = _mm256_set1_ps(1.0f);
+            int i = 0;
+            for (; i + 8 <= frames; i += 8) {
+                __m256 g = _mm256_min_ps(_mm256_max_ps(_mm256_add_ps(_mm256_set1_ps(gain + (float) i * step), r),
+                                                       zero), one);
+                __m256 d = _mm256_loadu_ps(dry + i);
+                _mm256_storeu_ps(wet + i, _mm256_add_ps(d, _mm256_mul_ps(g, _mm256_sub_ps(_mm256_loadu_ps(wet + i), d))));
+            }
+            // Back to SSE code: clear the upper halves to avoid the AVX-SSE transition penalty
+            _mm256_zeroupper();
+            crossfadeScalar(dry + i, wet + i, gain + (float) i * step, step, frames - i);
+        }
+
+        AEOLUS_TARGET_AVX2
+        void multiplyAccumulateComplexAvx2(const float *aRe, const float *aIm, const float *bRe, const float *bIm,
+                                           float *sumRe, float *sumIm, int bins) {
+            int i = 0;
+            for (; i + 8 <= bins; i += 8) {
+                __m256 ar = _mm256_loadu_ps(aRe + i);
+                __m256 ai = _mm256_loadu_ps(aIm + i);
+                __m256 br = _mm256_loadu_ps(bRe + i);
+                __m256 bi = _mm256_loadu_ps(bIm + i);
+                __m256 re = _mm256_sub_ps(_mm256_mul_ps(ar, br), _mm256_mul_ps(ai, bi));
+                __m256 im = _mm256_add_ps(_mm256_mul_ps(ar, bi), _mm256_mul_ps(ai, br));
+                _mm256_storeu_ps(sumRe + i, _mm256_add_ps(_mm256_loadu_ps(sumRe + i), re));
+                _mm256_storeu_ps(sumIm + i, _mm256_add_ps(_mm256_loadu_ps(sumIm + i), im));
+            }
+            // Back to SSE code: clear the upper halves to avoid the AVX-SSE transition penalty
+            _mm256_zeroupper();
+            multiplyAccumulateComplexScalar(aRe + i, aIm + i, bRe + i, bIm + i, sumRe + i, sumIm + i, bins - i);
+        }
+
+        const AeolusKernels avx2Kernels{
+                AeolusKernels::AVX2,
+                mixStereoAvx2,
+                interleaveStereoFloatAvx2,
+                downmixMonoFloatAvx2,
+                accumulateFloatAvx2,
+                crossfadeAvx2,
+                multiplyAccumulateComplexAvx2
+        };
+
+        bool cpuHasAvx2() {
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+        }
+
+#endif
+
+        const char *const isaNames[AeolusKernels::n_isas] = {"scalar", "sse2", "avx2", "neon"};
+
+        std::atomic<const AeolusKernels *> selected{nullptr};
+    }
+
+    const AeolusKernels *AeolusKernels::forIsa(Isa isa) {
+        switch (isa) {
+            case SCALAR:
+                return &scalarKernels;
+#if defined(__aarch64__)
+            case NEON:
+                return &neonKernels;
+#elif defined(__SSE2__)
+            case SSE2:
+                return &sse2Kernels;
+#endif
+#if defined(AEOLUS_KERNELS_AVX2)
+            case AVX2:
+                return cpuHasAvx2() ? &avx2Kernels : nullptr;
+#endif
+            default:
+                return nullptr;
+        }
+    }
+
+    AeolusKernels::Isa AeolusKernels::detect() {
+        // In order of preference
+        static const Isa best = [] {
+            const Isa candidates[] = {AVX2, NEON, SSE2};
+            for (Isa isa: candidates) {
+                if (forIsa(isa) != nullptr) return isa;
+            }
+            return SCALAR;
+        }();
+        return best;
+    }
+
+    const AeolusKernels &AeolusKernels::active() {
+        const AeolusKernels *kernels = selected.load(std::memory_order_acquire);
+        if (kernels == nullptr) {
+            // Several threads may get here at first, they all come to the same result
+            kernels = forIsa(detect());
+            selected.store(kernels, std::memory_order_release);
+        }
+        return *kernels;
+    }
+
+    bool AeolusKernels::select(Isa isa) {
+        const AeolusKernels *kernels = forIsa(isa);
+        if (kernels == nullptr) return false;
+        selected.store(kernels, std::memory_order_release);
+        return true;
+    }
+
+    const char *AeolusKernels::isaName(Isa isa) {
+        return isa >= 0 && isa < n_isas ? isaNames[isa] : "unknown";
+    }
+
+    AeolusKernels::FlushDenormals::FlushDenormals(bool enabled) {
+        if (!enabled) return;
+#if defined(__aarch64__)
+        // FZ, bit 24 of the floating point control register, also applies to NEON
+        uint64_t fpcr;
+        __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+        _saved = fpcr;
+        fpcr |= 1ull << 24;
+        if (fpcr != _saved) {
+            __asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr));
+            _changed = true;
+        }
+#elif defined(__SSE2__)
+        // FTZ (bit 15) and DAZ (bit 6) of the MXCSR
+        unsigned int csr = _mm_getcsr();
+        _saved = csr;
+        csr |= 0x8040;
+        if (csr != _saved) {
+            _mm_setcsr(csr);
+            _changed = true;
+        }
+#endif
+    }
+
+    AeolusKernels::FlushDenormals::~FlushDenormals() {
+        if (!_changed) return;
+#if defined(__aarch64__)
+        __asm__ __volatile__("msr fpcr, %0" : : "r"(_saved));
+#elif defined(__SSE2__)
+        _mm_setcsr((unsigned int) _saved);
+#endif
+    }
+
+    AeolusKernels::Isa AeolusKernels::isaFromName(const char *name) {
+        for (int i = 0; i < n_isas; i++) {
+            if (strcmp(name, isaNames[i]) == 0) return (Isa) i;
+        }
+        return n_isas;
+    }
+
+}
@@ -0,0 +1,183 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIDI_SYNTH_AEOLUSKERNELS_H
+#define MIDI_SYNTH_AEOLUSKERNELS_H
+
+#include <cstdint>
+
+namespace Aeolussynthesizer {
+    /**
+     * @brief Vectorized inner loops of the audio path, selected at run time according to the CPU
+     *
+     * Each instruction set provides the same table of kernels. The scalar table is the reference and is
+     * always available; the NEON table is used on arm64, and on x86_64, the AVX2 table if the CPU supports
+     * it (checked once at startup), SSE2 otherwise. The active table can be overridden with select, for
+     * validating the vector kernels against the scalar reference and comparing their speed
+     * (aeolus_kernel_bench).<br />
+     * The vector kernels give the same results as the scalar reference up to rounding, within a few units
+     * in the last place (fused multiply-add where the compiler contracts the scalar loop).
+     */
+    struct AeolusKernels {
+        /** Instruction sets */
+        enum Isa {
+            SCALAR,
+            SSE2,
+            AVX2,
+            NEON,
+            n_isas
+        };
+
+        /** Instruction set of this table */
+        Isa isa;
+
+        /**
+         * Stereo mix of the Aeolus audio section outputs: left = W + pposit*X + Y, right = W + pposit*X - Y
+         * @param W Omnidirectional component
+         * @param X Front-back component
+         * @param Y Left-right component
+         * @param pposit Weight of the front-back component
+         * @param left Left output
+         * @param right Right output
+         * @param frames Number of frames
+         */
+        void (*mixStereo)(const float *W, const float *X, const float *Y, float pposit,
+                          float *left, float *right, int frames);
+
+        /**
+         * Interleave two planar channels to stereo frames, with gain
+         * @param left Left channel
+         * @param right Right channel
+         * @param output 2*frames interleaved floats
+         * @param frames Number of frames
+         * @param gain Linear gain
+         */
+        void (*interleaveStereoFloat)(const float *left, const float *right, float *output, int frames, float gain);
+
+        /**
+         * Average of two planar channels, with gain
+         * @param left Left channel
+         * @param right Right channel
+         * @param output frames floats
+         * @param frames Number of frames
+         * @param gain Linear gain
+         */
+        void (*downmixMonoFloat)(const float *left, const float *right, float *output, int frames, float gain);
+
+        /**
+         * Accumulate with gain: output += gain * samples
+         * @param samples Samples to accumulate
+         * @param gain Linear gain
+         * @param output Buffer to accumulate into
+         * @param frames Number of samples
+         */
+        void (*accumulateFloat)(const float *samples, float gain, float *output, int frames);
+
+        /**
+         * Crossfade from a dry to a wet signal with a linear gain ramp:
+         * wet = dry + g * (wet - dry), where g = gain + (i + 1) * step for frame i, clipped to [0, 1]
+         * @param dry Dry signal
+         * @param wet Wet signal, replaced by the mix
+         * @param gain Gain of the wet signal before the first frame
+         * @param step Change of the gain per frame
+         * @param frames Number of frames
+         */
+        void (*crossfade)(const float *dry, float *wet, float gain, float step, int frames);
+
+        /**
+         * Complex multiply-accumulate of spectra in split form: sum += a * b, bin by bin
+         * @param aRe Real parts of a
+         * @param aIm Imaginary parts of a
+         * @param bRe Real parts of b
+         * @param bIm Imaginary parts of b
+         * @param sumRe Real parts of the sum
+         * @param sumIm Imaginary parts of the sum
+         * @param bins Number of bins
+         */
+        void (*multiplyAccumulateComplex)(const float *aRe, const float *aIm, const float *bRe, const float *bIm,
+                                          float *sumRe, float *sumIm, int bins);
+
+        /**
+         * @brief Flush denormal floats to zero on the calling thread, for the lifetime of the object
+         *
+         * Decaying tails (release, reverb, filters) end up in denormal numbers, which x86 processes in a
+         * slow path up to a hundred times slower than normal numbers. While the object lives, denormal
+         * results are flushed to zero and denormal inputs read as zero (FTZ and DAZ on x86, FZ on arm64);
+         * the previous mode is restored by the destructor. Elsewhere, nothing is changed. Cheap enough to
+         * be created for each engine period.
+         */
+        class FlushDenormals {
+        public:
+            /**
+             * @param enabled False to leave the floating point mode alone, for comparison
+             */
+            explicit FlushDenormals(bool enabled = true);
+
+            ~FlushDenormals();
+
+            FlushDenormals(const FlushDenormals &) = delete;
+
+            FlushDenormals &operator=(const FlushDenormals &) = delete;
+
+        private:
+            bool _changed = false;
+            uint64_t _saved = 0;
+        };
+
+        /**
+         * The kernels in use. Chosen at the first call by CPU feature detection, unless overridden by select.
+         * @return The active table
+         */
+        static const AeolusKernels &active();
+
+        /**
+         * Kernels for a given instruction set
+         * @param isa The instruction set
+         * @return The table, or nullptr if the instruction set is not compiled in or not supported by the CPU
+         */
+        static const AeolusKernels *forIsa(Isa isa);
+
+        /**
+         * The best instruction set supported by the CPU
+         * @return The instruction set chosen at startup
+         */
+        static Isa detect();
+
+        /**
+         * Override the active kernels, for validation and benchmarking. Not meant to be called while playing.
+         * @param isa The instruction set to use
+         * @return False if the instruction set is not available, in which case the active kernels are kept
+         */
+        static bool select(Isa isa);
+
+        /**
+         * Name of an instruction set
+         * @param isa The instruction set
+         * @return Lower case name, as accepted by isaFromName
+         */
+        static const char *isaName(Isa isa);
+
+        /**
+         * Instruction set from its name
+         * @param name Lower case name, see isaName
+         * @return The instruction set, or n_isas if unknown
+         */
+        static Isa isaFromName(const char *name);
+    };
+}
+
+#endif //MIDI_SYNTH_AEOLUSKERNELS_H
@@ -0,0 +1,82 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "AeolusOutputStage.h"
+
+#include "AeolusKernels.h"
+
+namespace Aeolussynthesizer {
+
+    namespace {
+
+        // Any other channel configuration: output channel c takes planar channel c, or the last
+        // planar channel if there are more output than planar channels
+        void interleaveGeneric(const float *const *planar, int planarChannels,
+                               float *output, int outputChannels, int frames, float gain) {
+            for (int c = 0; c < outputChannels; c++) {
+                const float *source = planar[c < planarChannels ? c : planarChannels - 1];
+                float *destination = output + c;
+                for (int i = 0; i < frames; i++) {
+                    destination[i * outputChannels] = gain * source[i];
+                }
+            }
+        }
+
+        inline void interleaveStereo(const float *left, const float *right, float *output, int frames, float gain) {
+            AeolusKernels::active().interleaveStereoFloat(left, right, output, frames, gain);
+        }
+
+        inline void downmixMono(const float *left, const float *right, float *output, int frames, float gain) {
+            AeolusKernels::active().downmixMonoFloat(left, right, output, frames, gain);
+        }
+
+        void interleave(const float *const *planar, int planarChannels,
+                        float *output, int outputChannels, int frames, float gain) {
+            if (planarChannels == 2 && outputChannels == 2) {
+                interleaveStereo(planar[0], planar[1], output, frames, gain);
+            } else if (planarChannels == 2 && outputChannels == 1) {
+                downmixMono(planar[0], planar[1], output, frames, gain);
+            } else {
+                interleaveGeneric(planar, planarChannels, output, outputChannels, frames, gain);
+            }
+        }
+    }
+
+    void AeolusOutputStage::setGain(float gain) {
+        _gain.store(gain, std::memory_order_relaxed);
+    }
+
+    float AeolusOutputStage::getGain() const {
+        return _gain.load(std::memory_order_relaxed);
+    }
+
+    void AeolusOutputStage::process(const float *const *planar, int planarChannels,
+                                    float *output, int outputChannels, int frames) const {
+        interleave(planar, planarChannels, output, outputChannels, frames, getGain());
+    }
+
+    void AeolusOutputStage::stereoTo(std::integral_constant<int, 1>, const float *left, const float *right,
+                                     float *output, int frames, float gain) {
+        downmixMono(left, right, output, frames, gain);
+    }
+
+    void AeolusOutputStage::stereoTo(std::integral_constant<int, 2>, const float *left, const float *right,
+                                     float *output, int frames, float gain) {
+        interleaveStereo(left, right, output, frames, gain);
+    }
+
+}
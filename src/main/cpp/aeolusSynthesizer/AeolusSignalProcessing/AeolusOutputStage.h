@@ -0,0 +1,92 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIDI_SYNTH_AEOLUSOUTPUTSTAGE_H
+#define MIDI_SYNTH_AEOLUSOUTPUTSTAGE_H
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+namespace Aeolussynthesizer {
+    /**
+     * @brief Final stage of the audio path: interleaving and master gain
+     *
+     * The Aeolus engine renders planar audio, one buffer per channel, while oboe expects interleaved
+     * float frames (L R L R ... for stereo) in the interval -1.0 to +1.0. The streams are always
+     * opened with float samples. This class converts from the former to the latter and
+     * applies the master gain on the way.<br />
+     * For the common cases (stereo or mono output from stereo planar data), the conversion runs through
+     * the vector kernels chosen for the CPU (see AeolusKernels); other channel configurations use a scalar loop. If the output has
+     * more channels than the planar data, the last planar channel is repeated. Mono output from stereo
+     * planar data is the average of both channels.<br />
+     * Callers that know the output channel count at compile time can use processStereo, which goes
+     * straight to the kernel without looking at the channel configuration.
+     */
+    class AeolusOutputStage {
+    public:
+        /**
+         * Set the master gain
+         *
+         * Can be called from any thread, takes effect at the next callback.
+         * @param gain Linear gain factor, 1 = no gain or loss
+         */
+        void setGain(float gain);
+
+        /**
+         * Get the master gain
+         * @return Linear gain factor
+         */
+        float getGain() const;
+
+        /**
+         * Interleave planar data, apply the master gain and write float output
+         * @param planar Pointers to the planar channels, each with at least frames valid floats
+         * @param planarChannels Number of planar channels
+         * @param output Interleaved output, frames*outputChannels floats
+         * @param outputChannels Number of interleaved output channels
+         * @param frames Number of frames to process
+         */
+        void process(const float *const *planar, int planarChannels,
+                     float *output, int outputChannels, int frames) const;
+
+        /**
+         * Same as process for stereo planar data and an output channel count known at compile time
+         * @tparam OutputChannels Number of interleaved output channels, 1 or 2
+         * @param left Left planar channel, at least frames valid floats
+         * @param right Right planar channel, at least frames valid floats
+         * @param output Interleaved output, frames*OutputChannels floats
+         * @param frames Number of frames to process
+         */
+        template<int OutputChannels>
+        void processStereo(const float *left, const float *right, float *output, int frames) const {
+            static_assert(OutputChannels == 1 || OutputChannels == 2, "Stereo planar data goes to mono or stereo output");
+            stereoTo(std::integral_constant<int, OutputChannels>(), left, right, output, frames, getGain());
+        }
+
+    private:
+        static void stereoTo(std::integral_constant<int, 1>, const float *left, const float *right,
+                             float *output, int frames, float gain);
+
+        static void stereoTo(std::integral_constant<int, 2>, const float *left, const float *right,
+                             float *output, int frames, float gain);
+
+        std::atomic<float> _gain{1.0f};
+    };
+}
+
+#endif //MIDI_SYNTH_AEOLUSOUTPUTSTAGE_H
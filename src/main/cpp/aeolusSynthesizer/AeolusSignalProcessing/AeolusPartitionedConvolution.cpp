@@ -0,0 +1,70 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "AeolusPartitionedConvolution.h"
+#include <algorithm>
+#include <cstring>
+#include "AeolusKernels.h"
+
+namespace Aeolussynthesizer {
+
+    AeolusPartitionedConvolution::AeolusPartitionedConvolution(const float *impulse, int length, int blockSize)
+            : _blockSize(blockSize), _bins(blockSize + 1),
+              _partitions((length + blockSize - 1) / blockSize),
+              _fft(2 * blockSize),
+              _impulseSpectra((size_t) 2 * _bins * _partitions),
+              _delayLine((size_t) 2 * _bins * _partitions),
+              _window(2 * blockSize), _sumRe(_bins), _sumIm(_bins), _time(2 * blockSize) {
+        // Each partition zero padded to two blocks
+        for (int p = 0; p < _partitions; p++) {
+            int n = std::min(blockSize, length - p * blockSize);
+            std::fill(_time.begin(), _time.end(), 0.0f);
+            memcpy(_time.data(), impulse + (size_t) p * blockSize, n * sizeof(float));
+            float *spectrum = &_impulseSpectra[(size_t) 2 * _bins * p];
+            _fft.forward(_time.data(), spectrum, spectrum + _bins);
+        }
+    }
+
+    void AeolusPartitionedConvolution::process(const float *input, float *output) {
+        if (_partitions == 0) return;
+        memmove(_window.data(), _window.data() + _blockSize, _blockSize * sizeof(float));
+        memcpy(_window.data() + _blockSize, input, _blockSize * sizeof(float));
+        _latest = _latest == 0 ? _partitions - 1 : _latest - 1;
+        float *latest = &_delayLine[(size_t) 2 * _bins * _latest];
+        _fft.forward(_window.data(), latest, latest + _bins);
+
+        // Partition p meets the input of p blocks ago, which follows the latest in the delay line
+        const AeolusKernels &kernels = AeolusKernels::active();
+        std::fill(_sumRe.begin(), _sumRe.end(), 0.0f);
+        std::fill(_sumIm.begin(), _sumIm.end(), 0.0f);
+        for (int p = 0; p < _partitions; p++) {
+            int d = _latest + p;
+            if (d >= _partitions) d -= _partitions;
+            const float *x = &_delayLine[(size_t) 2 * _bins * d];
+            const float *h = &_impulseSpectra[(size_t) 2 * _bins * p];
+            kernels.multiplyAccumulateComplex(x, x + _bins, h, h + _bins, _sumRe.data(), _sumIm.data(), _bins);
+        }
+        _fft.inverse(_sumRe.data(), _sumIm.data(), _time.data());
+        // The first block is wrapped around, the second is the linear convolution
+        kernels.accumulateFloat(_time.data() + _blockSize, 1.0f, output, _blockSize);
+    }
+
+    void AeolusPartitionedConvolution::reset() {
+        std::fill(_delayLine.begin(), _delayLine.end(), 0.0f);
+        std::fill(_window.begin(), _window.end(), 0.0f);
+    }
+}
@@ -0,0 +1,81 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIDI_SYNTH_AEOLUSPARTITIONEDCONVOLUTION_H
+#define MIDI_SYNTH_AEOLUSPARTITIONEDCONVOLUTION_H
+
+#include <vector>
+#include "AeolusFft.h"
+
+namespace Aeolussynthesizer {
+
+    /**
+     * @brief Uniformly partitioned convolution of a signal with a segment of an impulse response
+     *
+     * The segment is cut into partitions of one block, whose spectra are computed once. For each block of
+     * input, the spectrum of the last two blocks is computed and stored in a frequency domain delay line,
+     * the products of the delayed spectra with the partition spectra are summed, and the last block of the
+     * inverse transform is the output (overlap-save). The cost per block is thus two transforms of twice
+     * the block size, plus one complex multiply-accumulate per partition.<br />
+     * Everything is allocated by the constructor; process does not allocate, lock or wait.
+     */
+    class AeolusPartitionedConvolution {
+    public:
+        /**
+         * @param impulse Samples of the segment
+         * @param length Number of samples of the segment, may be 0
+         * @param blockSize Frames per block, a power of two
+         */
+        AeolusPartitionedConvolution(const float *impulse, int length, int blockSize);
+
+        /** Frames per block */
+        int blockSize() const { return _blockSize; }
+
+        /** Number of partitions, 0 for an empty segment */
+        int partitions() const { return _partitions; }
+
+        /**
+         * Convolve the next block of input
+         * @param input blockSize() frames
+         * @param output blockSize() frames, the result is added to them
+         */
+        void process(const float *input, float *output);
+
+        /** Forget past input, as if the signal had been silent so far */
+        void reset();
+
+    private:
+        int _blockSize;
+        int _bins;
+        int _partitions;
+        AeolusFft _fft;
+        /** Spectrum of each partition, real parts then imaginary parts */
+        std::vector<float> _impulseSpectra;
+        /** Spectrum of the input of each of the last _partitions blocks, as _impulseSpectra */
+        std::vector<float> _delayLine;
+        /** Index in _delayLine of the latest block */
+        int _latest = 0;
+        /** Last two blocks of input */
+        std::vector<float> _window;
+        /** Accumulated spectrum and output of the inverse transform */
+        std::vector<float> _sumRe;
+        std::vector<float> _sumIm;
+        std::vector<float> _time;
+    };
+}
+
+#endif //MIDI_SYNTH_AEOLUSPARTITIONEDCONVOLUTION_H
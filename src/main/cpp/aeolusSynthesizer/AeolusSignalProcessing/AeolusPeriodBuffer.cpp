@@ -0,0 +1,54 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "AeolusPeriodBuffer.h"
+
+namespace Aeolussynthesizer {
+
+    AeolusPeriodBuffer::AeolusPeriodBuffer(int channels, int periodFrames)
+            : _channels(channels),
+              _periodFrames(periodFrames),
+              _stride((periodFrames + 15) & ~15)
+    {
+        _storage.assign((size_t) _channels * _stride, 0.0f);
+    }
+
+    float *AeolusPeriodBuffer::channel(int index) {
+        return _storage.data() + (size_t) index * _stride;
+    }
+
+    const float *AeolusPeriodBuffer::readPointer(int index) const {
+        return _storage.data() + (size_t) index * _stride + _readPosition;
+    }
+
+    void AeolusPeriodBuffer::markRendered() {
+        _readPosition = 0;
+        _available = _periodFrames;
+    }
+
+    void AeolusPeriodBuffer::consume(int frames) {
+        if (frames > _available) frames = _available;
+        _readPosition += frames;
+        _available -= frames;
+    }
+
+    void AeolusPeriodBuffer::clear() {
+        _readPosition = _periodFrames;
+        _available = 0;
+    }
+
+}
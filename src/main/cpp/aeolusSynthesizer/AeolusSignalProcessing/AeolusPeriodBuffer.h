@@ -0,0 +1,105 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIDI_SYNTH_AEOLUSPERIODBUFFER_H
+#define MIDI_SYNTH_AEOLUSPERIODBUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Aeolussynthesizer {
+    /**
+     * @brief Planar store for exactly one engine period of rendered audio
+     *
+     * The Aeolus engine renders in blocks of a fixed number of frames (PERIOD) into the planar
+     * channel buffers pointed to by _outbuf. Oboe on the other hand asks for bursts whose size
+     * depends on the audio route and can change while the stream is running, for example after
+     * a route change or a Bluetooth reconnect.<br />
+     * This class owns the planar storage handed to the engine as _outbuf. The storage is allocated
+     * once, at construction, and the class keeps track of how many of the rendered frames have
+     * already been handed out. This permits to serve any callback size from whole engine periods
+     * without ever allocating or freeing memory in the audio callback.
+     */
+    class AeolusPeriodBuffer {
+    public:
+        /**
+         * Allocate the planar storage
+         * @param channels Number of planar channels (as rendered by the engine)
+         * @param periodFrames Number of frames rendered by the engine per period
+         */
+        AeolusPeriodBuffer(int channels, int periodFrames);
+
+        /**
+         * Start of the storage of a channel. This is what the engine renders into.
+         * @param index Index of the channel
+         * @return Pointer to periodFrames floats
+         */
+        float* channel(int index);
+
+        /**
+         * First rendered frame of a channel that has not been handed out yet
+         * @param index Index of the channel
+         * @return Pointer to available() valid floats
+         */
+        const float* readPointer(int index) const;
+
+        /**
+         * Number of rendered frames not handed out yet
+         */
+        int available() const { return _available; }
+
+        /**
+         * Position of the first frame not handed out yet, within the period
+         */
+        int readPosition() const { return _readPosition; }
+
+        /** Number of planar channels */
+        int channels() const { return _channels; }
+
+        /** Number of frames per engine period */
+        int periodFrames() const { return _periodFrames; }
+
+        /**
+         * The engine has just rendered a full period into the channel storage, make
+         * the entire period available.
+         */
+        void markRendered();
+
+        /**
+         * Mark frames as handed out
+         * @param frames Number of frames consumed, at most available()
+         */
+        void consume(int frames);
+
+        /**
+         * Drop whatever has been rendered but not handed out yet
+         */
+        void clear();
+
+    private:
+        int _channels;
+        int _periodFrames;
+        /** Distance between the starts of two consecutive channels, rounded up to a full cache line */
+        int _stride;
+        int _readPosition = 0;
+        int _available = 0;
+        std::vector<float> _storage;
+    };
+}
+
+#endif //MIDI_SYNTH_AEOLUSPERIODBUFFER_H
@@ -0,0 +1,162 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "AeolusPolyphonyLimiter.h"
+
+namespace Aeolussynthesizer {
+
+    AeolusPolyphonyLimiter::AeolusPolyphonyLimiter(Release release, void *context, int releasePeriods)
+            : _release(release), _context(context), _releasePeriods(releasePeriods < 0 ? 0 : releasePeriods) {
+        for (int d = 0; d < maxDivisions; d++) {
+            _divisionCeiling[d].store(0, std::memory_order_relaxed);
+            _pipesPerKey[d].store(0, std::memory_order_relaxed);
+        }
+        // All keys on all channels held at once, or releasing at once
+        _held.reserve(16 * 128);
+        _releasing.reserve(16 * 128);
+    }
+
+    void AeolusPolyphonyLimiter::setCeiling(int pipes) {
+        _ceiling.store(pipes < 0 ? 0 : pipes, std::memory_order_relaxed);
+    }
+
+    void AeolusPolyphonyLimiter::setDivisionCeiling(int division, int pipes) {
+        if (division < 0 || division >= maxDivisions) return;
+        _divisionCeiling[division].store(pipes < 0 ? 0 : pipes, std::memory_order_relaxed);
+    }
+
+    void AeolusPolyphonyLimiter::setPipesPerKey(int division, int pipes) {
+        if (division < 0 || division >= maxDivisions) return;
+        _pipesPerKey[division].store(pipes, std::memory_order_relaxed);
+    }
+
+    void AeolusPolyphonyLimiter::setCoupledDivisions(unsigned divisions) {
+        _coupledDivisions.store(divisions, std::memory_order_relaxed);
+    }
+
+    int AeolusPolyphonyLimiter::pipes(const Note &note, int division) const {
+        unsigned reached = note.divisions | _coupledDivisions.load(std::memory_order_relaxed);
+        int n = 0;
+        for (int d = 0; d < maxDivisions; d++) {
+            if ((reached & (1u << d)) != 0 && (division < 0 || division == d)) {
+                n += _pipesPerKey[d].load(std::memory_order_relaxed);
+            }
+        }
+        return n;
+    }
+
+    int AeolusPolyphonyLimiter::counted(int division) const {
+        int total = 0;
+        for (const Note &note: _held) total += pipes(note, division);
+        for (const Note &note: _releasing) total += pipes(note, division);
+        return total;
+    }
+
+    bool AeolusPolyphonyLimiter::exceeded(const Note &candidate, int &division) const {
+        int limit = _ceiling.load(std::memory_order_relaxed);
+        if (limit > 0 && pipes(candidate, -1) + counted(-1) > limit) {
+            division = -1;
+            return true;
+        }
+        for (int d = 0; d < maxDivisions; d++) {
+            limit = _divisionCeiling[d].load(std::memory_order_relaxed);
+            if (limit <= 0) continue;
+            int own = pipes(candidate, d);
+            if (own == 0) continue;
+            if (own + counted(d) > limit) {
+                division = d;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void AeolusPolyphonyLimiter::expire() {
+        uint64_t now = _period.load(std::memory_order_relaxed);
+        // Releases end in the order they started
+        auto ended = _releasing.begin();
+        while (ended != _releasing.end() && ended->end <= now) ++ended;
+        _releasing.erase(_releasing.begin(), ended);
+    }
+
+    void AeolusPolyphonyLimiter::forget(int channel, int key) {
+        for (auto it = _held.begin(); it != _held.end(); ++it) {
+            if (it->channel == channel && it->key == key) {
+                _held.erase(it);
+                break;
+            }
+        }
+        for (auto it = _releasing.begin(); it != _releasing.end(); ++it) {
+            if (it->channel == channel && it->key == key) {
+                _releasing.erase(it);
+                break;
+            }
+        }
+    }
+
+    void AeolusPolyphonyLimiter::noteOn(int channel, int key, unsigned divisions) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        expire();
+        // A repeated note on, or a note on during the release, counts once, as the new onset
+        forget(channel, key);
+        Note candidate{channel, key, divisions, 0};
+        int division;
+        while (exceeded(candidate, division)) {
+            // The oldest releasing note sounding pipes where the ceiling is exceeded, its pipes are
+            // already fading out
+            auto victim = _releasing.begin();
+            while (victim != _releasing.end() && pipes(*victim, division) == 0) ++victim;
+            if (victim != _releasing.end()) {
+                _releasing.erase(victim);
+                _releaseSteals.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            // Otherwise the oldest held note sounding pipes there
+            victim = _held.begin();
+            while (victim != _held.end() && pipes(*victim, division) == 0) ++victim;
+            if (victim == _held.end()) break;
+            Note stolen = *victim;
+            _held.erase(victim);
+            _steals.fetch_add(1, std::memory_order_relaxed);
+            _release(_context, stolen.channel, stolen.key);
+            // Its pipes fade out like those of any released note
+            stolen.end = _period.load(std::memory_order_relaxed) + _releasePeriods;
+            _releasing.push_back(stolen);
+        }
+        _held.push_back(candidate);
+    }
+
+    void AeolusPolyphonyLimiter::noteOff(int channel, int key) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        expire();
+        for (auto it = _held.begin(); it != _held.end(); ++it) {
+            if (it->channel == channel && it->key == key) {
+                Note released = *it;
+                _held.erase(it);
+                released.end = _period.load(std::memory_order_relaxed) + _releasePeriods;
+                if (_releasePeriods > 0) _releasing.push_back(released);
+                return;
+            }
+        }
+    }
+
+    int AeolusPolyphonyLimiter::soundingPipes() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        expire();
+        return counted(-1);
+    }
+}
@@ -0,0 +1,164 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIDI_SYNTH_AEOLUSPOLYPHONYLIMITER_H
+#define MIDI_SYNTH_AEOLUSPOLYPHONYLIMITER_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace Aeolussynthesizer {
+
+    /**
+     * @brief Ceiling on the pipes sounding for held and releasing keys, by stealing the oldest notes
+     *
+     * Each note (MIDI channel and key) sounds one pipe per active rank in each division its channel
+     * is routed to, plus the divisions reached through active couplers, while held and for releasePeriods
+     * after it is released, as its pipes fade out. The pipes per key of each division and the divisions
+     * reached through couplers are provided by the control side as the registration changes. When a new
+     * note would take the estimated number of sounding pipes beyond the ceiling of the instrument, or of
+     * one of the divisions it reaches, notes that contribute to the exceeded ceiling are stolen until the
+     * new note fits: releasing notes first, oldest first, then the oldest held notes, which are released
+     * through the release callback. A stolen releasing note is no longer counted; as the engine has no
+     * cut for a single pipe, its pipes finish their fade, which is what makes them the cheapest to steal.
+     * A note that exceeds a ceiling on its own is still played.<br />
+     * Time is counted in periods rendered, which the audio thread reports through periodRendered, so that
+     * releases last as long in offline rendering as in real time. All other methods can be called from any
+     * thread except the audio thread; they are serialized by a mutex, and the release callback is called
+     * with the mutex held.
+     */
+    class AeolusPolyphonyLimiter {
+    public:
+        /** Maximum number of divisions, as NDIVIS in the Aeolus engine */
+        static constexpr int maxDivisions = 8;
+
+        /** Release a held note, to make room for a new one */
+        typedef void (*Release)(void *context, int channel, int key);
+
+        /**
+         * @param release Called for each held note stolen
+         * @param context Passed to release
+         * @param releasePeriods Periods for which a released note is counted
+         */
+        AeolusPolyphonyLimiter(Release release, void *context, int releasePeriods);
+
+        /**
+         * Set the ceiling of the instrument
+         * @param pipes Maximum number of pipes sounding for held and releasing keys, 0 for no limit
+         */
+        void setCeiling(int pipes);
+
+        /** Ceiling of the instrument, 0 for no limit */
+        int ceiling() const { return _ceiling.load(std::memory_order_relaxed); }
+
+        /**
+         * Set the ceiling of a division
+         * @param division Index of the division
+         * @param pipes Maximum number of pipes sounding for held and releasing keys in the division, 0 for no limit
+         */
+        void setDivisionCeiling(int division, int pipes);
+
+        /**
+         * Set the number of pipes a key sounds in a division, i.e. its number of active ranks
+         * @param division Index of the division
+         * @param pipes Pipes per key
+         */
+        void setPipesPerKey(int division, int pipes);
+
+        /**
+         * Set the divisions reached by every note through active couplers
+         * @param divisions Bitmask of divisions
+         */
+        void setCoupledDivisions(unsigned divisions);
+
+        /**
+         * A note is played. Steals older notes if needed, before the note reaches the engine.
+         * @param channel MIDI channel
+         * @param key MIDI key
+         * @param divisions Bitmask of the divisions the channel is routed to
+         */
+        void noteOn(int channel, int key, unsigned divisions);
+
+        /**
+         * A note is released; it is counted for releasePeriods more
+         * @param channel MIDI channel
+         * @param key MIDI key
+         */
+        void noteOff(int channel, int key);
+
+        /** A period has been rendered. Called by the audio thread, lock-free. */
+        void periodRendered() { _period.fetch_add(1, std::memory_order_relaxed); }
+
+        /** Number of held notes stolen since construction */
+        uint64_t steals() const { return _steals.load(std::memory_order_relaxed); }
+
+        /** Number of releasing notes stolen since construction */
+        uint64_t releaseSteals() const { return _releaseSteals.load(std::memory_order_relaxed); }
+
+        /**
+         * Estimated number of pipes sounding for held and releasing keys, with the current registration
+         * @return The number of pipes
+         */
+        int soundingPipes();
+
+    private:
+        struct Note {
+            int channel;
+            int key;
+            unsigned divisions;
+            /** Period at which a releasing note is no longer counted, unused for held notes */
+            uint64_t end;
+        };
+
+        /** Pipes sounded by a note in division d, or in all divisions for d < 0. Mutex held. */
+        int pipes(const Note &note, int division) const;
+
+        /** Pipes sounded by the held and releasing notes in division d, or in all divisions for d < 0. Mutex held. */
+        int counted(int division) const;
+
+        /** Find a ceiling exceeded with the counted notes and candidate, -1 for the instrument. Mutex held. */
+        bool exceeded(const Note &candidate, int &division) const;
+
+        /** Forget the releases that have ended. Mutex held. */
+        void expire();
+
+        /** Forget a note, held or releasing. Mutex held. */
+        void forget(int channel, int key);
+
+        Release _release;
+        void *_context;
+        int _releasePeriods;
+
+        std::atomic<int> _ceiling{0};
+        std::atomic<int> _divisionCeiling[maxDivisions];
+        std::atomic<int> _pipesPerKey[maxDivisions];
+        std::atomic<unsigned> _coupledDivisions{0};
+        std::atomic<uint64_t> _steals{0};
+        std::atomic<uint64_t> _releaseSteals{0};
+        std::atomic<uint64_t> _period{0};
+
+        std::mutex _mutex;
+        /** Held notes, oldest first */
+        std::vector<Note> _held;
+        /** Releasing notes, oldest release first */
+        std::vector<Note> _releasing;
+    };
+}
+
+#endif //MIDI_SYNTH_AEOLUSPOLYPHONYLIMITER_H
@@ -0,0 +1,70 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "AeolusRegistrationStager.h"
+
+#include <chrono>
+#include <thread>
+
+namespace Aeolussynthesizer {
+
+    AeolusRegistrationStager::AeolusRegistrationStager(double periodSeconds, int changesPerPeriod)
+            : _periodSeconds(periodSeconds),
+              _changesPerPeriod(changesPerPeriod) {
+    }
+
+    void AeolusRegistrationStager::setChangesPerPeriod(int changesPerPeriod) {
+        _changesPerPeriod.store(changesPerPeriod < 0 ? 0 : changesPerPeriod, std::memory_order_relaxed);
+    }
+
+    void AeolusRegistrationStager::acquire() {
+        _changes.fetch_add(1, std::memory_order_relaxed);
+        int limit = _changesPerPeriod.load(std::memory_order_relaxed);
+        uint64_t period = _periods.load(std::memory_order_acquire);
+        if (period != _windowPeriod) {
+            _windowPeriod = period;
+            _windowChanges = 0;
+            _burstPeriods = 1;
+        }
+        if (limit > 0 && _windowChanges >= limit) {
+            _deferredChanges.fetch_add(1, std::memory_order_relaxed);
+            using Clock = std::chrono::steady_clock;
+            auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(2.0 * _periodSeconds));
+            auto poll = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(_periodSeconds / 4));
+            while (_periods.load(std::memory_order_acquire) == _windowPeriod && Clock::now() < deadline) {
+                std::this_thread::sleep_for(poll);
+            }
+            // The burst carries on in the new window, also when it was opened by the timeout
+            _windowPeriod = _periods.load(std::memory_order_acquire);
+            _windowChanges = 0;
+            _burstPeriods++;
+            if (_burstPeriods > _worstSpreadPeriods.load(std::memory_order_relaxed)) {
+                _worstSpreadPeriods.store(_burstPeriods, std::memory_order_relaxed);
+            }
+        }
+        _windowChanges++;
+    }
+
+    AeolusRegistrationStager::Statistics AeolusRegistrationStager::statistics() const {
+        Statistics s;
+        s.changes = _changes.load(std::memory_order_relaxed);
+        s.deferredChanges = _deferredChanges.load(std::memory_order_relaxed);
+        s.worstSpreadPeriods = _worstSpreadPeriods.load(std::memory_order_relaxed);
+        return s;
+    }
+}
@@ -0,0 +1,99 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIDI_SYNTH_AEOLUSREGISTRATIONSTAGER_H
+#define MIDI_SYNTH_AEOLUSREGISTRATIONSTAGER_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace Aeolussynthesizer {
+
+    /**
+     * @brief Spreads large registration changes over several engine periods
+     *
+     * When a stop is drawn while keys are held, the engine starts the pipes of its ranks for all these keys
+     * in the next period, and the attack part of their wavetables is the most expensive to render. Drawing
+     * many stops at once (a whole division through setStopActivationBitmask, or tutti after a general cancel)
+     * thus makes for a single period far more expensive than the steady state.<br />
+     * The thread delivering stop changes to the model calls acquire before each change. At most
+     * changesPerPeriod changes are let through per engine period; beyond, acquire waits until the audio
+     * side reports the next period with periodRendered. If no period is rendered for two period durations,
+     * as when the audio output is stopped, the next changes are let through anyway. The pipes themselves
+     * start and stop with the attack and release of their wavetables as usual, just in successive periods.
+     */
+    class AeolusRegistrationStager {
+    public:
+        /** Activity counters */
+        struct Statistics {
+            /** Stop changes let through */
+            uint64_t changes = 0;
+            /** Stop changes that had to wait for a later period */
+            uint64_t deferredChanges = 0;
+            /** Largest number of periods a single burst of changes was spread over */
+            uint64_t worstSpreadPeriods = 0;
+        };
+
+        /**
+         * @param periodSeconds Duration of an engine period, in seconds
+         * @param changesPerPeriod Initial limit of stop changes per period, 0 for no limit
+         */
+        AeolusRegistrationStager(double periodSeconds, int changesPerPeriod);
+
+        /**
+         * Limit the stop changes per period, from any thread
+         * @param changesPerPeriod Maximum number of stop changes per period, 0 for no limit
+         */
+        void setChangesPerPeriod(int changesPerPeriod);
+
+        /** Maximum number of stop changes per period, 0 for no limit */
+        int changesPerPeriod() const { return _changesPerPeriod.load(std::memory_order_relaxed); }
+
+        /**
+         * Audio side: an engine period has been rendered. Lock-free and wait-free.
+         */
+        void periodRendered() { _periods.fetch_add(1, std::memory_order_release); }
+
+        /**
+         * Delivery side: wait, if needed, until the next stop change may go to the model. Must always be
+         * called from the same thread.
+         */
+        void acquire();
+
+        /**
+         * Read the counters, from any thread
+         * @return Copy of the counters
+         */
+        Statistics statistics() const;
+
+    private:
+        double _periodSeconds;
+        std::atomic<int> _changesPerPeriod;
+        std::atomic<uint64_t> _periods{0};
+
+        // Delivery thread only
+        uint64_t _windowPeriod = ~0ull;
+        int _windowChanges = 0;
+        uint64_t _burstPeriods = 0;
+
+        std::atomic<uint64_t> _changes{0};
+        std::atomic<uint64_t> _deferredChanges{0};
+        std::atomic<uint64_t> _worstSpreadPeriods{0};
+    };
+}
+
+#endif //MIDI_SYNTH_AEOLUSREGISTRATIONSTAGER_H
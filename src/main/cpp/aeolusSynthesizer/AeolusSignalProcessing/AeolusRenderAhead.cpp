@@ -0,0 +1,140 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cerrno>
+#include <ctime>
+#include "AeolusRenderAhead.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace Aeolussynthesizer {
+
+    AeolusRenderAhead::AeolusRenderAhead(int channels, int periodFrames, RenderPeriod render, void *context)
+            : _ring(channels, periodFrames, maxLookAhead),
+              _channels(channels),
+              _render(render),
+              _context(context) {
+        sem_init(&_wake, 0, 0);
+    }
+
+    AeolusRenderAhead::~AeolusRenderAhead() {
+        setLookAhead(0);
+        sem_destroy(&_wake);
+    }
+
+    void AeolusRenderAhead::setLookAhead(int periods) {
+        if (periods < 0) periods = 0;
+        if (periods > maxLookAhead) periods = maxLookAhead;
+        _lookAhead.store(periods, std::memory_order_relaxed);
+
+        if (periods > 0) {
+            // Start a synthesis thread unless one is running. While draining, the callback may switch
+            // to DIRECT at the same time, hence the retry. A previous thread has exited by then, its
+            // last action being the switch to DRAINING; the ring content remains valid.
+            int state = _state.load();
+            while (state == DIRECT || state == DRAINING) {
+                if (_state.compare_exchange_weak(state, STARTING)) {
+                    if (_thread.joinable()) _thread.join();
+                    _thread = std::thread(&AeolusRenderAhead::threadMain, this);
+                    break;
+                }
+            }
+            sem_post(&_wake);
+        } else {
+            int state = _state.load();
+            if (state == STARTING || state == AHEAD) {
+                _state.store(STOPPING);
+                sem_post(&_wake);
+            }
+            if (_thread.joinable()) _thread.join();
+        }
+    }
+
+    bool AeolusRenderAhead::serving() {
+        switch (_state.load(std::memory_order_acquire)) {
+            case DIRECT:
+                return false;
+            case STARTING: {
+                // Still the only thread rendering: the period played now and the pre-fill go through
+                // the ring, so the synthesis thread takes over with prefillPeriods in hand
+                while (_ring.fill() < 1 + prefillPeriods) renderIntoRing();
+                int expected = STARTING;
+                _state.compare_exchange_strong(expected, AHEAD, std::memory_order_acq_rel);
+                sem_post(&_wake);
+                return true;
+            }
+            case DRAINING:
+                if (_ring.fill() == 0) {
+                    int expected = DRAINING;
+                    if (_state.compare_exchange_strong(expected, DIRECT, std::memory_order_acq_rel)) return false;
+                }
+                return true;
+            default:
+                return true;
+        }
+    }
+
+    bool AeolusRenderAhead::read(float *const *channels) {
+        if (!_ring.read(channels)) {
+            _underruns.fetch_add(1, std::memory_order_relaxed);
+            sem_post(&_wake);
+            return false;
+        }
+        // Tell the synthesis thread there is room again; sem_post does not block
+        sem_post(&_wake);
+        return true;
+    }
+
+    void AeolusRenderAhead::threadMain() {
+#ifdef __linux__
+        sched_param param{};
+        param.sched_priority = sched_get_priority_min(SCHED_FIFO) + 2;
+        pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+#endif
+        for (;;) {
+            int state = _state.load(std::memory_order_acquire);
+            if (state == STOPPING) break;
+
+            if (state == AHEAD && _ring.fill() < _lookAhead.load(std::memory_order_relaxed)) {
+                renderIntoRing();
+                continue;
+            }
+
+            // Wait for the callback to take a period or hand over, with a timeout as safety net
+            timespec deadline{};
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += 5000000;
+            if (deadline.tv_nsec >= 1000000000) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000;
+            }
+            while (sem_timedwait(&_wake, &deadline) == -1 && errno == EINTR) {}
+        }
+
+        _state.store(DRAINING, std::memory_order_release);
+    }
+
+    void AeolusRenderAhead::renderIntoRing() {
+        float *channels[8];
+        for (int c = 0; c < _channels && c < 8; c++) channels[c] = _ring.writeChannel(c);
+        _render(_context, channels);
+        _ring.commitWrite();
+    }
+}
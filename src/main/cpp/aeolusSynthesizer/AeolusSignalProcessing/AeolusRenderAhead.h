@@ -0,0 +1,127 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIDI_SYNTH_AEOLUSRENDERAHEAD_H
+#define MIDI_SYNTH_AEOLUSRENDERAHEAD_H
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <semaphore.h>
+#include "AeolusAudioRing.h"
+
+namespace Aeolussynthesizer {
+    /**
+     * @brief Renders engine periods ahead of time on a dedicated thread
+     *
+     * In render-ahead mode, a real-time synthesis thread keeps an AeolusAudioRing filled up to the
+     * look-ahead depth, and the audio callback only copies periods out of the ring. This adds the
+     * look-ahead (in periods) to the output latency, in exchange for tolerating scheduling jitter of
+     * the callback thread up to that amount.<br />
+     * Exactly one of the two threads renders at any time. When render-ahead is turned on, the
+     * synthesis thread waits until the callback has handed over (see serving()). The callback keeps
+     * rendering until then, and at the hand-over it renders the period it plays plus prefillPeriods
+     * more into the ring, so the synthesis thread starts with periods in hand rather than from an
+     * empty ring. When render-ahead is turned off, the callback serves what is left in the ring
+     * before it renders on its own again.
+     */
+    class AeolusRenderAhead {
+    public:
+        /**
+         * Render one engine period
+         * @param context As given to the constructor
+         * @param channels One pointer per channel, to one period of frames each
+         */
+        typedef void (*RenderPeriod)(void *context, float *const *channels);
+
+        /** Largest supported look-ahead, in periods */
+        static constexpr int maxLookAhead = 32;
+
+        /** Periods rendered ahead by the callback at the hand-over to the synthesis thread */
+        static constexpr int prefillPeriods = 1;
+
+        /**
+         * @param channels Number of planar channels
+         * @param periodFrames Frames per engine period
+         * @param render Renders one period, called on the synthesis thread
+         * @param context Passed to render
+         */
+        AeolusRenderAhead(int channels, int periodFrames, RenderPeriod render, void *context);
+
+        ~AeolusRenderAhead();
+
+        /**
+         * Set the look-ahead, from any thread but the audio and synthesis threads. Starting and
+         * stopping the synthesis thread happen here; changing a non-zero depth takes effect at once.
+         * @param periods Number of periods to render ahead, 0 to render in the callback again
+         */
+        void setLookAhead(int periods);
+
+        /** Look-ahead in periods, 0 when off */
+        int lookAhead() const { return _lookAhead.load(std::memory_order_relaxed); }
+
+        /**
+         * Callback: should the next period come from the ring (true) or be rendered by the callback
+         * (false)? Also carries out the hand-over between the threads.
+         */
+        bool serving();
+
+        /**
+         * Callback: copy the next period out of the ring
+         * @param channels One pointer per channel, to one period of frames each
+         * @return False on underrun (the ring is empty); the caller then outputs silence
+         */
+        bool read(float *const *channels);
+
+        /** Periods currently rendered ahead, from any thread */
+        int bufferedPeriods() const { return _ring.fill(); }
+
+        /** Number of periods the callback found the ring empty, from any thread */
+        uint64_t underruns() const { return _underruns.load(std::memory_order_relaxed); }
+
+    private:
+        enum State {
+            /** The callback renders */
+            DIRECT,
+            /** Render-ahead requested, waiting for the callback to hand over */
+            STARTING,
+            /** The synthesis thread renders */
+            AHEAD,
+            /** Render-ahead being turned off, the synthesis thread finishes its period */
+            STOPPING,
+            /** The synthesis thread is done, the callback empties the ring */
+            DRAINING
+        };
+
+        void threadMain();
+
+        // Render one period into the slot at the write position and commit it, by the rendering thread
+        void renderIntoRing();
+
+        AeolusAudioRing _ring;
+        int _channels;
+        RenderPeriod _render;
+        void *_context;
+        std::atomic<int> _state{DIRECT};
+        std::atomic<int> _lookAhead{0};
+        std::atomic<uint64_t> _underruns{0};
+        sem_t _wake;
+        std::thread _thread;
+    };
+}
+
+#endif //MIDI_SYNTH_AEOLUSRENDERAHEAD_H
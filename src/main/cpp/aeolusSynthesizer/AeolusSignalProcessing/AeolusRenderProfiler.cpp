@@ -0,0 +1,170 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <thread>
+#include "AeolusRenderProfiler.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace Aeolussynthesizer {
+
+    AeolusRenderProfiler::AeolusRenderProfiler() {
+        _samples.resize(sampleCapacity);
+    }
+
+    uint64_t AeolusRenderProfiler::readCycleCounter() {
+#if defined(__aarch64__)
+        uint64_t value;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+        return value;
+#elif defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    double AeolusRenderProfiler::counterTicksPerSecond() {
+#if defined(__aarch64__)
+        uint64_t frequency;
+        asm volatile("mrs %0, cntfrq_el0" : "=r"(frequency));
+        return (double) frequency;
+#elif defined(__x86_64__) || defined(__i386__)
+        static const double frequency = [] {
+            auto start = std::chrono::steady_clock::now();
+            uint64_t ticks = readCycleCounter();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            ticks = readCycleCounter() - ticks;
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            return (double) ticks / seconds;
+        }();
+        return frequency;
+#else
+        return 1e9;
+#endif
+    }
+
+    void AeolusRenderProfiler::setEnabled(bool enabled) {
+        _enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    void AeolusRenderProfiler::setRegistration(const uint64_t *stopMasks, int ndivisions) {
+        uint32_t sequence = _registrationSequence.load(std::memory_order_relaxed) + 1;
+        Registration &r = _registrations[sequence % registrationCapacity];
+        r.ndivisions = std::min(ndivisions, maxDivisions);
+        for (int i = 0; i < maxDivisions; i++) {
+            r.stopMasks[i] = i < r.ndivisions ? stopMasks[i] : 0;
+        }
+        _registrationSequence.store(sequence, std::memory_order_release);
+    }
+
+    void AeolusRenderProfiler::beginPeriod() {
+        _lastTicks = readCycleCounter();
+    }
+
+    void AeolusRenderProfiler::endStage(Stage stage) {
+        uint64_t now = readCycleCounter();
+        _current.ticks[stage] = (uint32_t) (now - _lastTicks);
+        _lastTicks = now;
+    }
+
+    void AeolusRenderProfiler::endPeriod() {
+        _current.registration = _registrationSequence.load(std::memory_order_acquire);
+        uint64_t written = _samplesWritten.load(std::memory_order_relaxed);
+        _samples[written % sampleCapacity] = _current;
+        _samplesWritten.store(written + 1, std::memory_order_release);
+    }
+
+    uint64_t AeolusRenderProfiler::summarize(std::vector<RegistrationProfile> &registrations,
+                                             std::vector<StopCost> &stopCosts) const {
+        registrations.clear();
+        stopCosts.clear();
+
+        // The audio thread may be overwriting the oldest records while we read, leave a margin
+        const uint64_t margin = 64;
+        uint64_t written = _samplesWritten.load(std::memory_order_acquire);
+        uint64_t first = written > sampleCapacity - margin ? written - (sampleCapacity - margin) : 0;
+        uint32_t latestRegistration = _registrationSequence.load(std::memory_order_acquire);
+
+        std::map<uint32_t, RegistrationProfile> profiles;
+        uint64_t periods = 0;
+        for (uint64_t i = first; i < written; i++) {
+            const Sample &sample = _samples[i % sampleCapacity];
+            if (latestRegistration - sample.registration >= registrationCapacity) continue; // forgotten
+            RegistrationProfile &p = profiles[sample.registration];
+            p.periods++;
+            for (int s = 0; s < n_stages; s++) p.meanTicks[s] += sample.ticks[s];
+            p.maxSynthTicks = std::max(p.maxSynthTicks, sample.ticks[SYNTH]);
+            periods++;
+        }
+
+        for (auto &entry: profiles) {
+            RegistrationProfile &p = entry.second;
+            const Registration &r = _registrations[entry.first % registrationCapacity];
+            p.ndivisions = r.ndivisions;
+            std::copy(r.stopMasks, r.stopMasks + maxDivisions, p.stopMasks);
+            for (double &ticks: p.meanTicks) ticks /= (double) p.periods;
+            registrations.push_back(p);
+        }
+
+        // Registrations differing by a single stop give an estimate of the cost of that stop
+        std::map<std::pair<int, int>, StopCost> costs;
+        for (const RegistrationProfile &with: registrations) {
+            for (const RegistrationProfile &without: registrations) {
+                if (with.ndivisions != without.ndivisions) continue;
+                int division = -1;
+                uint64_t difference = 0;
+                int differing = 0;
+                for (int d = 0; d < with.ndivisions; d++) {
+                    if (with.stopMasks[d] != without.stopMasks[d]) {
+                        division = d;
+                        difference = with.stopMasks[d] ^ without.stopMasks[d];
+                        differing++;
+                    }
+                }
+                if (differing != 1 || (difference & (difference - 1)) != 0) continue;
+                if ((with.stopMasks[division] & difference) == 0) continue; // stop added in "without"
+                int stop = 0;
+                while (((difference >> stop) & 1) == 0) stop++;
+                StopCost &c = costs[{division, stop}];
+                c.division = division;
+                c.stop = stop;
+                c.meanTicks += with.meanTicks[SYNTH] - without.meanTicks[SYNTH];
+                c.comparisons++;
+            }
+        }
+        for (auto &entry: costs) {
+            entry.second.meanTicks /= entry.second.comparisons;
+            stopCosts.push_back(entry.second);
+        }
+
+        std::sort(registrations.begin(), registrations.end(),
+                  [](const RegistrationProfile &a, const RegistrationProfile &b) {
+                      return a.meanTicks[SYNTH] > b.meanTicks[SYNTH];
+                  });
+        std::sort(stopCosts.begin(), stopCosts.end(),
+                  [](const StopCost &a, const StopCost &b) { return a.meanTicks > b.meanTicks; });
+        return periods;
+    }
+
+}
@@ -0,0 +1,158 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIDI_SYNTH_AEOLUSRENDERPROFILER_H
+#define MIDI_SYNTH_AEOLUSRENDERPROFILER_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace Aeolussynthesizer {
+    /**
+     * @brief Opt-in profiler attributing the render time of each engine period to its processing stages
+     *
+     * For every engine period, the audio thread records the cycle counter (CPU timer) ticks spent in
+     * the stages of the render path: note queue processing, command queue processing, key state
+     * propagation (proc_keys1 and proc_keys2), and synthesis (proc_synth, which drives the divisions,
+     * the audio sections and the reverb). Each record is tagged with the registration, that is the set
+     * of active stops, in effect at that time. The records go to a ring buffer preallocated at
+     * construction, so recording neither allocates nor locks.<br />
+     * The registrations are provided by the control thread whenever the stops change. The summary
+     * aggregates the records per registration, and estimates the cost of individual stops by comparing
+     * registrations that differ by exactly one stop.<br />
+     * Recording is disabled by default; when disabled, the audio thread only checks a flag per period.
+     */
+    class AeolusRenderProfiler {
+    public:
+        /** Stages of the render path */
+        enum Stage {
+            NOTE_QUEUE,
+            COMMAND_QUEUE,
+            KEYS,
+            SYNTH,
+            n_stages
+        };
+
+        /** Number of engine periods kept in the ring buffer */
+        static constexpr int sampleCapacity = 4096;
+        /** Number of registrations remembered */
+        static constexpr int registrationCapacity = 64;
+        /** Maximum number of divisions described by a registration */
+        static constexpr int maxDivisions = 8;
+
+        /** Aggregated timing of the periods rendered with a given registration */
+        struct RegistrationProfile {
+            /** Stop activation bitmask per division, as in AeolusSynthesizer::getStopActivationBitmask */
+            uint64_t stopMasks[maxDivisions] = {};
+            /** Number of divisions described in stopMasks */
+            int ndivisions = 0;
+            /** Number of periods recorded with this registration */
+            uint64_t periods = 0;
+            /** Mean ticks per period, by stage */
+            double meanTicks[n_stages] = {};
+            /** Largest number of ticks spent in a single period in the SYNTH stage */
+            uint32_t maxSynthTicks = 0;
+        };
+
+        /** Estimated cost of a single stop */
+        struct StopCost {
+            int division = 0;
+            int stop = 0;
+            /** Mean increase in SYNTH ticks per period when the stop is added */
+            double meanTicks = 0;
+            /** Number of registration pairs the estimate is based on */
+            int comparisons = 0;
+        };
+
+        AeolusRenderProfiler();
+
+        /**
+         * Read the cycle counter. On arm64, this is the virtual timer of the generic timer (constant
+         * frequency, readable from user space), on x86 the time stamp counter; elsewhere, nanoseconds
+         * of the steady clock.
+         * @return Current counter value
+         */
+        static uint64_t readCycleCounter();
+
+        /**
+         * Frequency of the cycle counter. Measured once on the first call on x86, which takes a few
+         * milliseconds; do not call from the audio thread.
+         * @return Counter ticks per second
+         */
+        static double counterTicksPerSecond();
+
+        /**
+         * Enable or disable recording. Can be called from any thread.
+         * @param enabled True to record
+         */
+        void setEnabled(bool enabled);
+
+        /** Is recording enabled? */
+        bool isEnabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+        /**
+         * Publish the registration in effect from now on. To be called from the control thread only.
+         * @param stopMasks Stop activation bitmask per division
+         * @param ndivisions Number of divisions (entries in stopMasks)
+         */
+        void setRegistration(const uint64_t *stopMasks, int ndivisions);
+
+        /** Start recording a period. Audio thread only. */
+        void beginPeriod();
+
+        /**
+         * The given stage just completed. Audio thread only.
+         * @param stage The stage that completed
+         */
+        void endStage(Stage stage);
+
+        /** The period is complete, store the record. Audio thread only. */
+        void endPeriod();
+
+        /**
+         * Aggregate the records in the ring buffer. To be called from the control thread only.
+         * @param registrations Per registration timing, sorted by decreasing mean SYNTH ticks
+         * @param stopCosts Estimated cost of individual stops, sorted by decreasing cost
+         * @return Number of periods aggregated
+         */
+        uint64_t summarize(std::vector<RegistrationProfile> &registrations,
+                           std::vector<StopCost> &stopCosts) const;
+
+    private:
+        struct Sample {
+            uint32_t ticks[n_stages];
+            uint32_t registration;
+        };
+
+        struct Registration {
+            uint64_t stopMasks[maxDivisions];
+            int ndivisions;
+        };
+
+        std::atomic<bool> _enabled{false};
+        std::vector<Sample> _samples;
+        std::atomic<uint64_t> _samplesWritten{0};
+        Sample _current{};
+        uint64_t _lastTicks = 0;
+
+        Registration _registrations[registrationCapacity]{};
+        std::atomic<uint32_t> _registrationSequence{0};
+    };
+}
+
+#endif //MIDI_SYNTH_AEOLUSRENDERPROFILER_H
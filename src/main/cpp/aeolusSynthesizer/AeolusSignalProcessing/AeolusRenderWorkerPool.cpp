@@ -0,0 +1,142 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include "AeolusRenderWorkerPool.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace Aeolussynthesizer {
+
+    namespace {
+        inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+            _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+            __asm__ __volatile__("yield");
+#endif
+        }
+
+        // Pin the calling thread to a core and ask for real-time scheduling, both on a best effort basis
+        void configureWorkerThread(int core) {
+#ifdef __linux__
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(core, &cpus);
+            sched_setaffinity(0, sizeof(cpus), &cpus);
+
+            sched_param param{};
+            param.sched_priority = sched_get_priority_min(SCHED_FIFO) + 1;
+            pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+#else
+            (void) core;
+#endif
+        }
+    }
+
+    AeolusRenderWorkerPool::AeolusRenderWorkerPool(int workers) {
+        sem_init(&_wake, 0, 0);
+        int cores = (int) std::thread::hardware_concurrency();
+        if (workers <= 0) workers = cores > 1 ? cores - 1 : 0;
+        _threads.reserve(workers);
+        for (int i = 0; i < workers; i++) _threads.emplace_back(&AeolusRenderWorkerPool::workerMain, this, i);
+    }
+
+    AeolusRenderWorkerPool::~AeolusRenderWorkerPool() {
+        _exit.store(true, std::memory_order_release);
+        for (size_t i = 0; i < _threads.size(); i++) sem_post(&_wake);
+        for (std::thread &t: _threads) t.join();
+        sem_destroy(&_wake);
+    }
+
+    void AeolusRenderWorkerPool::run(Job job, void *context, int count) {
+        if (count <= 0) return;
+        if (_fallbackRemaining > 0 || _threads.empty()) {
+            if (_fallbackRemaining > 0) _fallbackRemaining--;
+            for (int i = 0; i < count; i++) job(context, i);
+            return;
+        }
+
+        uint32_t generation = _generation.load(std::memory_order_relaxed) + 1;
+        _job = job;
+        _context = context;
+        _count.store(count, std::memory_order_relaxed);
+        _pending.store(count, std::memory_order_relaxed);
+        _ticket.store((uint64_t) generation << 32, std::memory_order_relaxed);
+        // Publishes the job description and counters above to the workers
+        _generation.store(generation, std::memory_order_release);
+
+        // The calling thread takes one job, wake up workers for the others
+        int wake = std::min(count - 1, workers());
+        for (int i = 0; i < wake; i++) sem_post(&_wake);
+
+        work(generation);
+        if (_pending.load(std::memory_order_acquire) == 0) return;
+
+        // Only jobs started by a worker are left
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::nanoseconds(lateWaitNanoseconds);
+        while (_pending.load(std::memory_order_acquire) > 0) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                _lateRuns.fetch_add(1, std::memory_order_relaxed);
+                _fallbackRemaining = fallbackRuns;
+                // The job cannot be abandoned, it writes to the section buffers the caller reads next:
+                // this wait lasts as long as the worker is preempted
+                while (_pending.load(std::memory_order_acquire) > 0) std::this_thread::yield();
+                return;
+            }
+            cpuRelax();
+        }
+    }
+
+    void AeolusRenderWorkerPool::work(uint32_t generation) {
+        uint64_t ticket = _ticket.load(std::memory_order_acquire);
+        for (;;) {
+            // A ticket of an older or newer generation means that this generation has been
+            // completed already
+            if ((uint32_t) (ticket >> 32) != generation) return;
+            int index = (int) (uint32_t) ticket;
+            if (index >= _count.load(std::memory_order_relaxed)) return;
+            if (!_ticket.compare_exchange_weak(ticket, ticket + 1, std::memory_order_acq_rel)) continue;
+
+            _job(_context, index);
+            _pending.fetch_sub(1, std::memory_order_acq_rel);
+            ticket = _ticket.load(std::memory_order_acquire);
+        }
+    }
+
+    void AeolusRenderWorkerPool::workerMain(int index) {
+        int cores = (int) std::thread::hardware_concurrency();
+        // Core 0 is left to the audio thread
+        if (cores > 1) configureWorkerThread(1 + index % (cores - 1));
+
+        for (;;) {
+            while (sem_wait(&_wake) == -1 && errno == EINTR) {}
+            if (_exit.load(std::memory_order_acquire)) return;
+            // A worker woken up after the audio thread has completed the generation finds no job left
+            work(_generation.load(std::memory_order_acquire));
+        }
+    }
+}
@@ -0,0 +1,108 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIDI_SYNTH_AEOLUSRENDERWORKERPOOL_H
+#define MIDI_SYNTH_AEOLUSRENDERWORKERPOOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <semaphore.h>
+#include <thread>
+#include <vector>
+
+namespace Aeolussynthesizer {
+
+    /**
+     * @brief Fixed pool of worker threads sharing the rendering of an engine period with the audio thread
+     *
+     * For each period, the audio thread hands a number of independent jobs to run(); the jobs are claimed
+     * one by one by the workers and by the audio thread itself, and run() returns once all of them have
+     * completed. Claiming and completion go through atomic counters only, so the audio thread never blocks
+     * on a lock. Jobs that no worker has claimed yet are taken back by the audio thread, so a worker that
+     * wakes up late only reduces the parallelism.<br />
+     * A job that a worker has started cannot be taken back, though: the job writes to state that the caller
+     * reads once run() returns, so run() has to wait for it to complete. If that worker is preempted, this
+     * wait is not bounded and the period may miss its deadline. The pool only limits how often this can
+     * happen: when the wait exceeds lateWaitNanoseconds, the run is counted as late, still waits for the job
+     * to complete, and the following fallbackRuns runs are rendered entirely on the calling thread, without
+     * the workers.<br />
+     * Workers are pinned to their own core and ask for real-time scheduling (which may be refused, in which
+     * case they run with normal priority). Between periods, they sleep on a semaphore that run() posts
+     * for as many workers as there are jobs to share.
+     */
+    class AeolusRenderWorkerPool {
+    public:
+        /** A job: the index runs from 0 to the count given to run() */
+        typedef void (*Job)(void *context, int index);
+
+        /** Wait for started jobs beyond which a run is late; not a bound, the run waits on */
+        static constexpr int64_t lateWaitNanoseconds = 200000;
+
+        /** Number of runs on the calling thread only after a late run */
+        static constexpr int fallbackRuns = 2000;
+
+        /**
+         * @param workers Number of worker threads; 0 for one less than the number of cores
+         */
+        explicit AeolusRenderWorkerPool(int workers = 0);
+
+        ~AeolusRenderWorkerPool();
+
+        /** Number of worker threads, not counting the calling thread */
+        int workers() const { return (int) _threads.size(); }
+
+        /**
+         * Run jobs 0 to count-1 in parallel and return when all are done. The order of execution is
+         * unspecified; jobs must not depend on each other. Only one thread may call run at a time.
+         * @param job The job function
+         * @param context Passed to the job function
+         * @param count Number of jobs
+         */
+        void run(Job job, void *context, int count);
+
+        /** Number of runs that waited for a started job longer than lateWaitNanoseconds */
+        uint64_t lateRuns() const { return _lateRuns.load(std::memory_order_relaxed); }
+
+    private:
+        void workerMain(int index);
+
+        // Claim and run jobs of the given generation until none is left
+        void work(uint32_t generation);
+
+        std::vector<std::thread> _threads;
+
+        // Generation (high 32 bits) and next job index (low 32 bits)
+        std::atomic<uint64_t> _ticket{0};
+        std::atomic<uint32_t> _generation{0};
+        std::atomic<int> _pending{0};
+        // Read by late workers of a previous generation, whose claim then fails
+        std::atomic<int> _count{0};
+        // Only read after a successful claim, which cannot happen while run() rewrites them
+        Job _job = nullptr;
+        void *_context = nullptr;
+
+        // Remaining runs on the calling thread only, caller side only
+        int _fallbackRemaining = 0;
+        std::atomic<uint64_t> _lateRuns{0};
+
+        std::atomic<bool> _exit{false};
+        // Posted by run() for each worker to wake up
+        sem_t _wake;
+    };
+}
+
+#endif //MIDI_SYNTH_AEOLUSRENDERWORKERPOOL_H
@@ -0,0 +1,154 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "AeolusVarispeed.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace Aeolussynthesizer {
+
+    AeolusVarispeed::AeolusVarispeed(int channels, int periodFrames, double maxRatio, double drainRatio) :
+            _channels(channels), _periodFrames(periodFrames), _maxRatio(maxRatio), _drainRatio(drainRatio),
+            // Frames kept before the reading position and needed after it, the frames read in a
+            // period, and the period appended last
+            _capacity(4 + (int) (std::max(maxRatio, 2.0 * drainRatio - 1.0) * periodFrames) + 2 * periodFrames),
+            _buffer((size_t) channels * _capacity, 0.0f),
+            _scratch((size_t) channels * periodFrames, 0.0f) {
+    }
+
+    void AeolusVarispeed::setRatio(double ratio) {
+        _ratio.store(std::min(_maxRatio, std::max(1.0 / _maxRatio, ratio)), std::memory_order_relaxed);
+    }
+
+    void AeolusVarispeed::reset() {
+        _engaged = false;
+        _current = 1.0;
+    }
+
+    void AeolusVarispeed::append(int channels, Render render, void *context) {
+        const float *const *period = render(context);
+        for (int c = 0; c < channels; c++) {
+            memcpy(&_buffer[(size_t) c * _capacity + _frames], period[c], _periodFrames * sizeof(float));
+        }
+        _frames += _periodFrames;
+        _sourcePeriods.store(_sourcePeriods.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void AeolusVarispeed::interpolate(int n, int channels, Render render, void *context) {
+        int i = (int) _position;
+        while (i + 2 >= _frames) append(channels, render, context);
+        float t = (float) (_position - i);
+        for (int c = 0; c < channels; c++) {
+            const float *x = &_buffer[(size_t) c * _capacity + i - 1];
+            // 4-point, 3rd order Hermite
+            float c1 = 0.5f * (x[2] - x[0]);
+            float c2 = x[0] - 2.5f * x[1] + 2.0f * x[2] - 0.5f * x[3];
+            float c3 = 0.5f * (x[3] - x[0]) + 1.5f * (x[1] - x[2]);
+            _scratch[(size_t) c * _periodFrames + n] = ((c3 * t + c2) * t + c1) * t + x[1];
+        }
+    }
+
+    void AeolusVarispeed::finishDrain(double excess, int channels, Render render, void *context) {
+        // The last two frames are copied, the interpolation needs no frame beyond them
+        const int interpolated = _periodFrames - 2;
+        // Frame following the interpolated ones, the source periods end right after the copied frames
+        const double end = _position + excess + interpolated;
+        // The rate moves linearly from start to exactly 1 at the last interpolated frame, covering
+        // excess + interpolated frames in total
+        const double start = 1.0 + 2.0 * excess / (interpolated - 1);
+        const double step = (1.0 - start) / interpolated;
+        for (int n = 0; n < interpolated; n++) {
+            interpolate(n, channels, render, context);
+            _position += start + step * (n + 1);
+        }
+        // Only rounding separates the reading position from the frame
+        int i = (int) std::lround(end);
+        for (int n = interpolated; n < _periodFrames; n++, i++) {
+            while (i >= _frames) append(channels, render, context);
+            for (int c = 0; c < channels; c++) {
+                _scratch[(size_t) c * _periodFrames + n] = _buffer[(size_t) c * _capacity + i];
+            }
+        }
+        // Passed through from the next period on, as if it had never been resampled
+        for (int c = 0; c < channels; c++) {
+            _buffer[(size_t) c * _capacity] = _scratch[(size_t) c * _periodFrames + _periodFrames - 1];
+        }
+        _engaged = false;
+        _current = 1.0;
+    }
+
+    void AeolusVarispeed::process(float *const *output, int channels, Render render, void *context) {
+        channels = std::min(channels, _channels);
+        double target = _ratio.load(std::memory_order_relaxed);
+        if (!_engaged && target == 1.0) {
+            const float *const *period = render(context);
+            for (int c = 0; c < channels; c++) {
+                if (output[c] != period[c]) memcpy(output[c], period[c], _periodFrames * sizeof(float));
+                // The frame before the next output, for the interpolation if resampling starts then
+                _buffer[(size_t) c * _capacity] = period[c][_periodFrames - 1];
+            }
+            _sourcePeriods.store(_sourcePeriods.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+        }
+        if (!_engaged) {
+            // Continue from the last frame passed through
+            _engaged = true;
+            _frames = 1;
+            _position = 1.0;
+        }
+
+        const double drain = _drainRatio - 1.0;
+        if (target == 1.0 && std::fabs(_current - 1.0) <= drain + 1e-12) {
+            // Back at a rate of 1: the frames buffered beyond the reading position, less or more than
+            // a whole number of source periods
+            double buffered = _frames - _position;
+            double excess = buffered - _periodFrames * std::floor(buffered / _periodFrames + 0.5);
+            if (std::fabs(2.0 * excess / (_periodFrames - 3)) <= 2.0 * drain) {
+                finishDrain(excess, channels, render, context);
+                for (int c = 0; c < channels; c++) {
+                    memcpy(output[c], &_scratch[(size_t) c * _periodFrames], _periodFrames * sizeof(float));
+                }
+                return;
+            }
+            // Read faster to consume the excess, or slower for the next source period to make up for it
+            target = excess > 0.0 ? _drainRatio : 2.0 - _drainRatio;
+        }
+
+        double step = (target - _current) / _periodFrames;
+        for (int n = 0; n < _periodFrames; n++) {
+            interpolate(n, channels, render, context);
+            _position += _current + step * (n + 1);
+        }
+        _current = target;
+
+        // Keep the frame before the reading position
+        int drop = std::min(_frames, (int) _position - 1);
+        if (drop > 0) {
+            for (int c = 0; c < channels; c++) {
+                float *channel = &_buffer[(size_t) c * _capacity];
+                memmove(channel, channel + drop, (_frames - drop) * sizeof(float));
+            }
+            _frames -= drop;
+            _position -= drop;
+        }
+        for (int c = 0; c < channels; c++) {
+            memcpy(output[c], &_scratch[(size_t) c * _periodFrames], _periodFrames * sizeof(float));
+        }
+    }
+}
@@ -0,0 +1,121 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIDI_SYNTH_AEOLUSVARISPEED_H
+#define MIDI_SYNTH_AEOLUSVARISPEED_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace Aeolussynthesizer {
+
+    /**
+     * @brief Plays a source rendered by periods at a variable rate, shifting its pitch without recomputing it
+     *
+     * At a rate of 1, each period of the source is passed through as is. At other rates, the periods
+     * are collected in a buffer and read at the given rate with 4-point Hermite interpolation; periods
+     * of the source are rendered as the reading position needs them, i.e. slightly more or less often
+     * than output periods. The rate moves linearly to a new value over the next output period.<br />
+     * While resampling, the output lags the source by up to one period and a few frames. Once the rate
+     * is back to 1, the buffered frames are drained: they are read slightly faster or slower, by at most
+     * drainRatio, until the reading position falls on the start of a period of the source, which is
+     * then passed through again without skipping or repeating any part of a frame. reset returns to
+     * passing the source through at once, dropping the buffered frames, when that does not matter, e.g.
+     * after silence.<br />
+     * setRatio can be called from any thread, the other methods are for the audio side.
+     */
+    class AeolusVarispeed {
+    public:
+        /**
+         * Render one period of the source
+         * @return The channels of the period, valid until the next call
+         */
+        typedef const float *const *(*Render)(void *context);
+
+        /**
+         * @param channels Maximum number of channels
+         * @param periodFrames Frames per period, of the source and of the output
+         * @param maxRatio Highest rate used, higher rates are limited to it
+         * @param drainRatio Largest deviation from a rate of 1 while draining, e.g. 1.003 for 5 cents
+         */
+        AeolusVarispeed(int channels, int periodFrames, double maxRatio, double drainRatio);
+
+        /**
+         * Set the playback rate, taking effect over the next period
+         * @param ratio Frames of the source per output frame, 1 for the original pitch
+         */
+        void setRatio(double ratio);
+
+        /** Playback rate set, see setRatio */
+        double ratio() const { return _ratio.load(std::memory_order_relaxed); }
+
+        /** Is the source resampled, rather than passed through? Also while draining. */
+        bool engaged() const { return _engaged; }
+
+        /**
+         * Produce one period of output, rendering periods of the source as needed
+         * @param output Output channels; may be the channels returned by render
+         * @param channels Number of channels, the same from one call to the next
+         * @param render Renders a period of the source
+         * @param context Passed to render
+         */
+        void process(float *const *output, int channels, Render render, void *context);
+
+        /** Pass the source through again, dropping the buffered frames */
+        void reset();
+
+        /** Periods of the source rendered, which differs from the output periods while resampling */
+        uint64_t sourcePeriods() const { return _sourcePeriods.load(std::memory_order_relaxed); }
+
+    private:
+        /** Append a period of the source to the buffer */
+        void append(int channels, Render render, void *context);
+
+        /** Interpolate the output frame n at the reading position, appending source periods as needed */
+        void interpolate(int n, int channels, Render render, void *context);
+
+        /**
+         * Last period of the drain: interpolate up to a frame of the source, copy the following frames
+         * up to the end of a period of the source, and pass the source through from then on
+         * @param excess Frames to read beyond one period, positive or negative
+         */
+        void finishDrain(double excess, int channels, Render render, void *context);
+
+        const int _channels;
+        const int _periodFrames;
+        const double _maxRatio;
+        const double _drainRatio;
+        const int _capacity;
+
+        std::atomic<double> _ratio{1.0};
+        std::atomic<uint64_t> _sourcePeriods{0};
+
+        /** Rate at the end of the last period */
+        double _current = 1.0;
+        bool _engaged = false;
+        /** Source frames per channel, _capacity frames each; the first one is the frame before the last output */
+        std::vector<float> _buffer;
+        int _frames = 0;
+        /** Reading position in _buffer */
+        double _position = 0.0;
+        /** Output of the period, per channel */
+        std::vector<float> _scratch;
+    };
+}
+
+#endif //MIDI_SYNTH_AEOLUSVARISPEED_H
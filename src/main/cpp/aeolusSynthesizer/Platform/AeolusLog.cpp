@@ -0,0 +1,62 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include "AeolusLog.h"
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#endif
+
+namespace Aeolussynthesizer {
+
+    namespace {
+
+        void platformLogSink(LogLevel level, const char *tag, const char *message) {
+#ifdef __ANDROID__
+            int priority = ANDROID_LOG_INFO;
+            switch (level) {
+                case LogLevel::DEBUG: priority = ANDROID_LOG_DEBUG; break;
+                case LogLevel::INFO: priority = ANDROID_LOG_INFO; break;
+                case LogLevel::WARN: priority = ANDROID_LOG_WARN; break;
+                case LogLevel::ERROR: priority = ANDROID_LOG_ERROR; break;
+            }
+            __android_log_write(priority, tag, message);
+#else
+            static const char *const levelNames[] = {"D", "I", "W", "E"};
+            fprintf(stderr, "%s/%s: %s\n", levelNames[(int) level], tag, message);
+#endif
+        }
+
+        std::atomic<LogSink> currentSink{platformLogSink};
+    }
+
+    void aeolusLog(LogLevel level, const char *tag, const char *format, ...) {
+        char message[1024];
+        va_list arguments;
+        va_start(arguments, format);
+        vsnprintf(message, sizeof(message), format, arguments);
+        va_end(arguments);
+        currentSink.load()(level, tag, message);
+    }
+
+    void setLogSink(LogSink sink) {
+        currentSink.store(sink != nullptr ? sink : platformLogSink);
+    }
+}
@@ -0,0 +1,62 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIDI_SYNTH_AEOLUSLOG_H
+#define MIDI_SYNTH_AEOLUSLOG_H
+
+namespace Aeolussynthesizer {
+
+    /** @brief Severity of a log message */
+    enum class LogLevel {
+        DEBUG,
+        INFO,
+        WARN,
+        ERROR
+    };
+
+    /**
+     * @brief Receives formatted log messages
+     * @param level Severity of the message
+     * @param tag Component the message stems from
+     * @param message The formatted message
+     */
+    typedef void (*LogSink)(LogLevel level, const char *tag, const char *message);
+
+    /**
+     * @brief Log a printf-style message
+     *
+     * On Android, messages go to logcat, elsewhere to standard error, unless another sink has been
+     * installed with setLogSink. Formatting happens on the stack, but the sinks may block: do not call
+     * this from the audio thread.
+     * @param level Severity of the message
+     * @param tag Component the message stems from
+     * @param format printf format string
+     */
+    void aeolusLog(LogLevel level, const char *tag, const char *format, ...)
+#if defined(__GNUC__)
+            __attribute__((format(printf, 3, 4)))
+#endif
+            ;
+
+    /**
+     * @brief Replace the platform log sink, e.g. to capture messages in tests or tools
+     * @param sink The new sink, or nullptr to restore the platform default
+     */
+    void setLogSink(LogSink sink);
+}
+
+#endif //MIDI_SYNTH_AEOLUSLOG_H
@@ -0,0 +1,237 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "AeolusMappedSample.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Aeolussynthesizer {
+
+    namespace {
+        uint16_t get16(const uint8_t *p) {
+            return (uint16_t) (p[0] | (p[1] << 8));
+        }
+
+        uint32_t get32(const uint8_t *p) {
+            return get16(p) | ((uint32_t) get16(p + 2) << 16);
+        }
+
+        size_t pageSize() {
+            static const size_t page = (size_t) sysconf(_SC_PAGESIZE);
+            return page;
+        }
+    }
+
+    AeolusMappedSample::~AeolusMappedSample() {
+        if (_mapping != nullptr) {
+            // Also removes the lock on the attack
+            munmap(_mapping, _mappedBytes);
+        }
+    }
+
+    bool AeolusMappedSample::open(const std::string &path, double attackSeconds, std::string &error) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            error = "Cannot open " + path;
+            return false;
+        }
+        struct stat status{};
+        if (fstat(fd, &status) != 0 || status.st_size < 12) {
+            ::close(fd);
+            error = path + " is not a WAV file";
+            return false;
+        }
+        _mappedBytes = (size_t) status.st_size;
+        _mapping = mmap(nullptr, _mappedBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        // The mapping stays valid without the descriptor
+        ::close(fd);
+        if (_mapping == MAP_FAILED) {
+            _mapping = nullptr;
+            error = "Cannot map " + path;
+            return false;
+        }
+
+        const uint8_t *bytes = static_cast<const uint8_t *>(_mapping);
+        if (memcmp(bytes, "RIFF", 4) != 0 || memcmp(bytes + 8, "WAVE", 4) != 0) {
+            error = path + " is not a WAV file";
+            return false;
+        }
+        int formatTag = 0;
+        bool haveFormat = false;
+        size_t dataBytes = 0;
+        int64_t loopStart = 0, loopEnd = 0;
+        // Only the chunk headers are read here, the samples are paged in when needed
+        for (size_t pos = 12; pos + 8 <= _mappedBytes;) {
+            const uint8_t *chunk = bytes + pos;
+            size_t size = get32(chunk + 4);
+            size_t available = _mappedBytes - pos - 8;
+            if (size > available) size = available;
+            if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+                formatTag = get16(chunk + 8);
+                _channels = get16(chunk + 10);
+                _samplingRate = (int) get32(chunk + 12);
+                _bitsPerSample = get16(chunk + 22);
+                if (formatTag == 0xfffe && size >= 40) formatTag = get16(chunk + 32);
+                haveFormat = true;
+            } else if (memcmp(chunk, "data", 4) == 0) {
+                _data = chunk + 8;
+                dataBytes = size;
+            } else if (memcmp(chunk, "smpl", 4) == 0 && size >= 60 && get32(chunk + 8 + 28) > 0) {
+                // First loop; its end is the last frame played in the loop
+                loopStart = get32(chunk + 8 + 44);
+                loopEnd = (int64_t) get32(chunk + 8 + 48) + 1;
+            }
+            pos += 8 + size + (size & 1);
+        }
+        if (!haveFormat || _data == nullptr) {
+            error = path + ": no audio data";
+            return false;
+        }
+        _float = formatTag == 3;
+        if (!((formatTag == 1 && (_bitsPerSample == 16 || _bitsPerSample == 24 || _bitsPerSample == 32)) ||
+              (formatTag == 3 && _bitsPerSample == 32)) || _channels < 1 || _channels > 2 || _samplingRate <= 0) {
+            error = path + ": unsupported sample format";
+            return false;
+        }
+        _frameBytes = _channels * _bitsPerSample / 8;
+        _frames = (int64_t) (dataBytes / _frameBytes);
+        if (loopStart >= 0 && loopStart < loopEnd && loopEnd <= _frames) {
+            _loopStart = loopStart;
+            _loopEnd = loopEnd;
+        }
+        // At least up to the loop, but not beyond the first pass through it
+        _attackFrames = std::max(_loopStart, (int64_t) (attackSeconds * _samplingRate));
+        _attackFrames = std::min(_attackFrames, looped() ? _loopEnd : _frames);
+        return true;
+    }
+
+    bool AeolusMappedSample::makeAttackResident(uint64_t &pages) {
+        bool locked = false;
+        if (_attackFrames > 0) {
+            const size_t page = pageSize();
+            uintptr_t begin = (uintptr_t) _data & ~(uintptr_t) (page - 1);
+            uintptr_t end = (uintptr_t) (_data + _attackFrames * _frameBytes);
+            for (uintptr_t address = begin; address < end; address += page) {
+                (void) *reinterpret_cast<const volatile uint8_t *>(address);
+                pages++;
+            }
+            // Locking is refused beyond RLIMIT_MEMLOCK; the attack is then only resident until reclaimed
+            locked = mlock(reinterpret_cast<void *>(begin), end - begin) == 0;
+            if (locked) _lockedBytes = end - begin;
+        }
+        _attackResident.store(true, std::memory_order_release);
+        return locked;
+    }
+
+    uint64_t AeolusMappedSample::prefetch(int64_t from, int64_t to) const {
+        from = std::max((int64_t) 0, from);
+        to = std::min(_frames, to);
+        if (from >= to) return 0;
+        const size_t page = pageSize();
+        uintptr_t begin = (uintptr_t) (_data + from * _frameBytes) & ~(uintptr_t) (page - 1);
+        uintptr_t end = (uintptr_t) (_data + to * _frameBytes);
+        size_t pages = (end - begin + page - 1) / page;
+        std::vector<unsigned char> residency(pages, 0);
+        // mincore is only a hint: without it, every page is read, which costs nothing when resident
+        mincore(reinterpret_cast<void *>(begin), end - begin, residency.data());
+        uint64_t faultedIn = 0;
+        for (size_t p = 0; p < pages; p++) {
+            if ((residency[p] & 1u) == 0) {
+                (void) *reinterpret_cast<const volatile uint8_t *>(begin + p * page);
+                faultedIn++;
+            }
+        }
+        return faultedIn;
+    }
+
+    inline float AeolusMappedSample::sampleAt(int64_t frame, int c) const {
+        if (frame >= _frames) return 0.0f;
+        const uint8_t *p = _data + frame * _frameBytes + c * (_bitsPerSample / 8);
+        if (_bitsPerSample == 16) {
+            int16_t v;
+            memcpy(&v, p, sizeof(v));
+            return v * (1.0f / 32768.0f);
+        }
+        if (_bitsPerSample == 24) {
+            int32_t v = (int32_t) ((uint32_t) p[0] << 8 | (uint32_t) p[1] << 16 | (uint32_t) p[2] << 24);
+            return (float) (v >> 8) * (1.0f / 8388608.0f);
+        }
+        if (_float) {
+            float v;
+            memcpy(&v, p, sizeof(v));
+            return v;
+        }
+        int32_t v;
+        memcpy(&v, p, sizeof(v));
+        return (float) ((double) v * (1.0 / 2147483648.0));
+    }
+
+    void AeolusMappedSample::mix(double &position, double increment, float gain, float gainStep,
+                                 float *left, float *right, int frames) const {
+        const double loopFrames = (double) (_loopEnd - _loopStart);
+        const bool stereo = _channels == 2;
+        // Mono recordings sound in the middle, at equal power, and stereo recordings are folded
+        // down to a mono output at equal power
+        const float monoGain = 0.70710678f;
+        if (right == nullptr) {
+            for (int n = 0; n < frames; n++) {
+                int64_t i = (int64_t) position;
+                float f = (float) (position - (double) i);
+                int64_t j = next(i);
+                float g = gain + n * gainStep;
+                float a = sampleAt(i, 0), b = sampleAt(j, 0);
+                float v = a + (b - a) * f;
+                if (stereo) {
+                    a = sampleAt(i, 1);
+                    b = sampleAt(j, 1);
+                    v = monoGain * (v + a + (b - a) * f);
+                }
+                left[n] += g * v;
+                position += increment;
+                if (loopFrames > 0.0 && position >= (double) _loopEnd) position -= loopFrames;
+            }
+            return;
+        }
+        for (int n = 0; n < frames; n++) {
+            int64_t i = (int64_t) position;
+            float f = (float) (position - (double) i);
+            int64_t j = next(i);
+            float g = gain + n * gainStep;
+            if (stereo) {
+                float a = sampleAt(i, 0), b = sampleAt(j, 0);
+                left[n] += g * (a + (b - a) * f);
+                a = sampleAt(i, 1);
+                b = sampleAt(j, 1);
+                right[n] += g * (a + (b - a) * f);
+            } else {
+                float a = sampleAt(i, 0), b = sampleAt(j, 0);
+                float v = monoGain * g * (a + (b - a) * f);
+                left[n] += v;
+                right[n] += v;
+            }
+            position += increment;
+            if (loopFrames > 0.0 && position >= (double) _loopEnd) position -= loopFrames;
+        }
+    }
+}
@@ -0,0 +1,145 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIDI_SYNTH_AEOLUSMAPPEDSAMPLE_H
+#define MIDI_SYNTH_AEOLUSMAPPEDSAMPLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Aeolussynthesizer {
+
+    /**
+     * @brief Recording of a pipe, played directly from a memory-mapped WAV file
+     *
+     * The file (16 or 24 bit integer or 32 bit float, mono or stereo) is mapped read-only rather than read,
+     * so that it only takes memory for the pages actually in use, which the system can reclaim when they
+     * are no longer needed. The first sustain loop of the 'smpl' chunk, when present, splits the recording
+     * into the attack, before the loop, and the sustain loop, repeated while the key is held.<br />
+     * Reading a page that is not resident waits for the storage, which the audio thread must not do.
+     * The attack can therefore be made resident ahead of time with makeAttackResident, and other ranges
+     * with prefetch, both from a background thread (see AeolusSampledRanks); mix only reads the mapping.
+     */
+    class AeolusMappedSample {
+    public:
+        AeolusMappedSample() = default;
+
+        AeolusMappedSample(const AeolusMappedSample &) = delete;
+
+        AeolusMappedSample &operator=(const AeolusMappedSample &) = delete;
+
+        /** Unmaps the file, after unlocking the attack */
+        ~AeolusMappedSample();
+
+        /**
+         * Map a file
+         * @param path Path of the WAV file
+         * @param attackSeconds Minimum length of the attack, kept resident, extended up to the sustain loop
+         * @param error Description of the problem if mapping fails
+         * @return True on success
+         */
+        bool open(const std::string &path, double attackSeconds, std::string &error);
+
+        /** Sampling rate of the recording in Hz */
+        int samplingRate() const { return _samplingRate; }
+
+        /** Number of channels, 1 or 2 */
+        int channels() const { return _channels; }
+
+        /** Number of frames */
+        int64_t frames() const { return _frames; }
+
+        /** Does the recording have a sustain loop? */
+        bool looped() const { return _loopEnd > _loopStart; }
+
+        /** First frame of the sustain loop */
+        int64_t loopStart() const { return _loopStart; }
+
+        /** Frame after the sustain loop */
+        int64_t loopEnd() const { return _loopEnd; }
+
+        /** Frames of the attack, kept resident; never beyond the end of the sustain loop */
+        int64_t attackFrames() const { return _attackFrames; }
+
+        /** Bytes mapped */
+        size_t mappedBytes() const { return _mappedBytes; }
+
+        /**
+         * Bring the attack into memory, and lock it there if the system allows. Call once, from a
+         * background thread.
+         * @param pages Incremented by the number of pages touched
+         * @return True if the attack could be locked
+         */
+        bool makeAttackResident(uint64_t &pages);
+
+        /** Is the attack in memory, i.e. has makeAttackResident completed? */
+        bool attackResident() const { return _attackResident.load(std::memory_order_acquire); }
+
+        /** Bytes of the attack locked in memory */
+        size_t lockedBytes() const { return _lockedBytes; }
+
+        /**
+         * Bring frames [from, to) into memory, by reading one byte of each page that is not resident
+         * @return The number of pages read in
+         */
+        uint64_t prefetch(int64_t from, int64_t to) const;
+
+        /**
+         * Add frames, interpolated linearly, to a stereo or mono output. Reads frames floor(position) up to
+         * floor(position + (frames-1)*increment) + 1, wrapping around the sustain loop when there is one,
+         * which must be resident; frames beyond the end of an unlooped recording read as silence.
+         * @param position Position in the recording, in frames, updated
+         * @param increment Frames of the recording per output frame
+         * @param gain Gain at the first output frame
+         * @param gainStep Change of the gain per output frame
+         * @param left Left output, or the mono output
+         * @param right Right output, nullptr for a mono output
+         * @param frames Number of output frames
+         */
+        void mix(double &position, double increment, float gain, float gainStep,
+                 float *left, float *right, int frames) const;
+
+    private:
+        /** Sample of channel c at frame, as float */
+        inline float sampleAt(int64_t frame, int c) const;
+
+        /** Frame following frame, wrapping around the sustain loop */
+        inline int64_t next(int64_t frame) const {
+            return frame + 1 == _loopEnd ? _loopStart : frame + 1;
+        }
+
+        void *_mapping = nullptr;
+        size_t _mappedBytes = 0;
+        const uint8_t *_data = nullptr;
+        int _samplingRate = 0;
+        int _channels = 0;
+        /** 16, 24 or 32 */
+        int _bitsPerSample = 0;
+        bool _float = false;
+        int _frameBytes = 0;
+        int64_t _frames = 0;
+        int64_t _loopStart = 0;
+        int64_t _loopEnd = 0;
+        int64_t _attackFrames = 0;
+        size_t _lockedBytes = 0;
+        std::atomic<bool> _attackResident{false};
+    };
+}
+
+#endif //MIDI_SYNTH_AEOLUSMAPPEDSAMPLE_H
@@ -0,0 +1,364 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "AeolusMemoryWarmer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace Aeolussynthesizer {
+
+#if defined(__linux__)
+    namespace {
+
+        typedef std::vector<std::pair<uintptr_t, size_t>> Ranges;
+
+        /**
+         * Private anonymous readable and writable mappings of the process, by address, which is where the
+         * engine keeps its wavetables. The thread stacks and the Java heap are left out.
+         */
+        std::vector<std::pair<uintptr_t, size_t>> anonymousMappings() {
+            std::vector<std::pair<uintptr_t, size_t>> mappings;
+            FILE *maps = fopen("/proc/self/maps", "r");
+            if (maps == nullptr) {
+                return mappings;
+            }
+            char line[512];
+            while (fgets(line, sizeof(line), maps) != nullptr) {
+                unsigned long start = 0, end = 0, offset = 0, inode = 0;
+                char permissions[8] = {0};
+                char device[16] = {0};
+                int pathStart = 0;
+                if (sscanf(line, "%lx-%lx %7s %lx %15s %lu %n", &start, &end, permissions, &offset, device,
+                           &inode, &pathStart) < 6) {
+                    continue;
+                }
+                if (permissions[0] != 'r' || permissions[1] != 'w' || permissions[3] != 'p' || inode != 0) {
+                    continue;
+                }
+                const char *path = pathStart > 0 ? line + pathStart : "";
+                bool anonymous = path[0] == '\n' || path[0] == '\0' ||
+                                 strncmp(path, "[heap]", 6) == 0 ||
+                                 strncmp(path, "[anon:", 6) == 0;
+                if (!anonymous || strncmp(path, "[anon:stack", 11) == 0 || strncmp(path, "[anon:dalvik", 12) == 0) {
+                    continue;
+                }
+                if (end > start) {
+                    mappings.emplace_back(static_cast<uintptr_t>(start), static_cast<size_t>(end - start));
+                }
+            }
+            fclose(maps);
+            return mappings;
+        }
+
+        /**
+         * Parts of the ranges in after that are not covered by any range in before, both sorted by address;
+         * a mapping that has grown (such as the heap) contributes the part it has grown by
+         */
+        Ranges addedRanges(const Ranges &before, const Ranges &after) {
+            Ranges added;
+            for (const auto &range: after) {
+                uintptr_t start = range.first;
+                uintptr_t end = range.first + range.second;
+                for (const auto &old: before) {
+                    uintptr_t oldStart = old.first;
+                    uintptr_t oldEnd = old.first + old.second;
+                    if (oldEnd <= start || oldStart >= end) {
+                        continue;
+                    }
+                    if (oldStart > start) {
+                        added.emplace_back(start, static_cast<size_t>(oldStart - start));
+                    }
+                    start = std::max(start, oldEnd);
+                }
+                if (end > start) {
+                    added.emplace_back(start, static_cast<size_t>(end - start));
+                }
+            }
+            return added;
+        }
+
+        /**
+         * Reads one byte at address through the kernel, so that a page unmapped in the meantime
+         * yields an error instead of a segmentation fault
+         */
+        class SafeReader {
+        public:
+            SafeReader() : _memory(-1), _useVmReadv(true) {}
+
+            ~SafeReader() {
+                if (_memory >= 0) {
+                    close(_memory);
+                }
+            }
+
+            bool touch(uintptr_t address) {
+                char byte;
+                if (_useVmReadv) {
+                    struct iovec local = {&byte, 1};
+                    struct iovec remote = {reinterpret_cast<void *>(address), 1};
+                    ssize_t n = process_vm_readv(getpid(), &local, 1, &remote, 1, 0);
+                    if (n == 1) {
+                        return true;
+                    }
+                    if (errno != ENOSYS && errno != EPERM) {
+                        return false;
+                    }
+                    // Not available (e.g. seccomp filter): fall back to /proc/self/mem
+                    _useVmReadv = false;
+                    _memory = open("/proc/self/mem", O_RDONLY | O_CLOEXEC);
+                }
+                if (_memory < 0) {
+                    return false;
+                }
+                return pread(_memory, &byte, 1, static_cast<off_t>(address)) == 1;
+            }
+
+        private:
+            int _memory;
+            bool _useVmReadv;
+        };
+
+        void threadFaults(uint64_t &minor, uint64_t &major) {
+            struct rusage usage{};
+#if defined(RUSAGE_THREAD)
+            getrusage(RUSAGE_THREAD, &usage);
+#else
+            getrusage(RUSAGE_SELF, &usage);
+#endif
+            minor = static_cast<uint64_t>(usage.ru_minflt);
+            major = static_cast<uint64_t>(usage.ru_majflt);
+        }
+    }
+#endif
+
+    AeolusMemoryWarmer::AeolusMemoryWarmer(Deliver deliver, void *context) :
+            _deliver(deliver), _context(context) {
+        _thread = std::thread(&AeolusMemoryWarmer::run, this);
+    }
+
+    AeolusMemoryWarmer::~AeolusMemoryWarmer() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _quit = true;
+            _pending.clear();
+        }
+        _wake.notify_one();
+        if (_thread.joinable()) {
+            _thread.join();
+        }
+        std::lock_guard<std::mutex> lock(_warmUpMutex);
+        unlockAll();
+    }
+
+    void AeolusMemoryWarmer::submit(const StopChange &change) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _pending.push_back(change);
+        }
+        _wake.notify_one();
+    }
+
+    void AeolusMemoryWarmer::setEnabled(bool enabled) {
+        _enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    void AeolusMemoryWarmer::setLocking(bool locking) {
+        _locking.store(locking, std::memory_order_relaxed);
+        if (!locking) {
+            std::lock_guard<std::mutex> lock(_warmUpMutex);
+            unlockAll();
+        }
+    }
+
+    AeolusMemoryWarmer::Statistics AeolusMemoryWarmer::statistics() const {
+        Statistics s;
+        s.warmUps = _warmUps.load(std::memory_order_relaxed);
+        s.pagesScanned = _pagesScanned.load(std::memory_order_relaxed);
+        s.pagesFaultedIn = _pagesFaultedIn.load(std::memory_order_relaxed);
+        s.minorFaults = _minorFaults.load(std::memory_order_relaxed);
+        s.majorFaults = _majorFaults.load(std::memory_order_relaxed);
+        s.bytesLocked = _bytesLocked.load(std::memory_order_relaxed);
+        s.lockFailures = _lockFailures.load(std::memory_order_relaxed);
+        s.lastWarmUpMicroseconds = _lastWarmUpMicroseconds.load(std::memory_order_relaxed);
+        s.truncatedWarmUps = _truncatedWarmUps.load(std::memory_order_relaxed);
+        s.instrumentBytes = _instrumentBytes.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    void AeolusMemoryWarmer::recordMappingsBeforeLoad() {
+#if defined(__linux__)
+        std::lock_guard<std::mutex> lock(_warmUpMutex);
+        _beforeLoad = anonymousMappings();
+        _beforeLoadRecorded = true;
+#endif
+    }
+
+    void AeolusMemoryWarmer::recordLoadedMappings() {
+#if defined(__linux__)
+        std::lock_guard<std::mutex> lock(_warmUpMutex);
+        if (!_beforeLoadRecorded) {
+            return;
+        }
+        // Locked ranges may no longer be instrument memory, they are locked again at the next warm-up
+        unlockAll();
+        _instrument = addedRanges(_beforeLoad, anonymousMappings());
+        uint64_t bytes = 0;
+        for (const auto &range: _instrument) {
+            bytes += range.second;
+        }
+        _instrumentBytes.store(bytes, std::memory_order_relaxed);
+#endif
+    }
+
+    void AeolusMemoryWarmer::warmUpNow() {
+        warmUp();
+    }
+
+    void AeolusMemoryWarmer::run() {
+        std::vector<StopChange> batch;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wake.wait(lock, [this] { return _quit || !_pending.empty(); });
+                if (_quit) {
+                    return;
+                }
+                batch.assign(_pending.begin(), _pending.end());
+                _pending.clear();
+            }
+            bool activates = false;
+            for (const StopChange &change: batch) {
+                activates = activates || change.activate;
+            }
+            if (activates && isEnabled()) {
+                warmUp();
+            }
+            for (const StopChange &change: batch) {
+                _deliver(_context, change);
+            }
+            batch.clear();
+        }
+    }
+
+    void AeolusMemoryWarmer::warmUp() {
+#if defined(__linux__)
+        std::lock_guard<std::mutex> lock(_warmUpMutex);
+        auto started = std::chrono::steady_clock::now();
+        auto deadline = started + std::chrono::microseconds(warmUpBudgetMicroseconds);
+        const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        // Pages looked up with one mincore call, between two checks of the time
+        const size_t chunkPages = 256;
+        uint64_t minorBefore, majorBefore;
+        threadFaults(minorBefore, majorBefore);
+
+        SafeReader reader;
+        std::vector<unsigned char> residency(chunkPages);
+        uint64_t scanned = 0, faultedIn = 0;
+        bool truncated = false;
+        for (const auto &range: _instrument) {
+            uintptr_t end = range.first + range.second;
+            for (uintptr_t chunk = range.first; chunk < end && !truncated; chunk += chunkPages * page) {
+                size_t bytes = std::min(chunkPages * page, static_cast<size_t>(end - chunk));
+                size_t pages = (bytes + page - 1) / page;
+                if (mincore(reinterpret_cast<void *>(chunk), bytes, residency.data()) != 0) {
+                    // No longer mapped
+                    continue;
+                }
+                scanned += pages;
+                for (size_t p = 0; p < pages && !truncated; p++) {
+                    if ((residency[p] & 1u) != 0) {
+                        continue;
+                    }
+                    if (reader.touch(chunk + p * page)) {
+                        faultedIn++;
+                    }
+                    // Faults may be slow (read from storage), check the time after each
+                    truncated = std::chrono::steady_clock::now() > deadline;
+                }
+                truncated = truncated || std::chrono::steady_clock::now() > deadline;
+            }
+            if (truncated) {
+                break;
+            }
+        }
+        if (truncated) {
+            _truncatedWarmUps.fetch_add(1, std::memory_order_relaxed);
+        } else if (_locking.load(std::memory_order_relaxed)) {
+            // Left for a later warm-up when out of time: locking faults in the whole range
+            lockMappings(_instrument);
+        }
+
+        uint64_t minorAfter, majorAfter;
+        threadFaults(minorAfter, majorAfter);
+        _minorFaults.fetch_add(minorAfter - minorBefore, std::memory_order_relaxed);
+        _majorFaults.fetch_add(majorAfter - majorBefore, std::memory_order_relaxed);
+        _pagesScanned.fetch_add(scanned, std::memory_order_relaxed);
+        _pagesFaultedIn.fetch_add(faultedIn, std::memory_order_relaxed);
+        _lastWarmUpMicroseconds.store(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - started).count()), std::memory_order_relaxed);
+#endif
+        _warmUps.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void AeolusMemoryWarmer::lockMappings(const std::vector<std::pair<uintptr_t, size_t>> &mappings) {
+#if defined(__linux__)
+        for (const auto &mapping: mappings) {
+            if (mapping.second < lockMinimumBytes) {
+                continue;
+            }
+            bool known = false;
+            for (const auto &locked: _locked) {
+                known = known || locked == mapping;
+            }
+            if (known) {
+                continue;
+            }
+            if (mlock(reinterpret_cast<void *>(mapping.first), mapping.second) == 0) {
+                _locked.push_back(mapping);
+                _bytesLocked.fetch_add(mapping.second, std::memory_order_relaxed);
+            } else {
+                _lockFailures.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+#else
+        (void) mappings;
+#endif
+    }
+
+    void AeolusMemoryWarmer::unlockAll() {
+#if defined(__linux__)
+        for (const auto &locked: _locked) {
+            // Fails harmlessly if the range has been unmapped in the meantime
+            munlock(reinterpret_cast<void *>(locked.first), locked.second);
+        }
+#endif
+        _locked.clear();
+        _bytesLocked.store(0, std::memory_order_relaxed);
+    }
+}
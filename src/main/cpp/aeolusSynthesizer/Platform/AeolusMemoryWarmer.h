@@ -0,0 +1,199 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIDI_SYNTH_AEOLUSMEMORYWARMER_H
+#define MIDI_SYNTH_AEOLUSMEMORYWARMER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Aeolussynthesizer {
+
+    /**
+     * @brief Brings the instrument memory back into RAM before stop activations reach the audio thread
+     *
+     * The wavetables of all ranks are computed or loaded when the instrument is set up, but the pages of
+     * ranks that have not sounded for a while may since have been reclaimed by the system (compressed or
+     * swapped out). The first notes on such a stop then take page faults inside the audio callback.<br />
+     * Stop changes are therefore passed through this class: a background thread first looks up, with
+     * mincore, which pages of the instrument memory are not resident, reads one byte of each of them to
+     * fault them in, and only then delivers the changes in the order they were submitted. Reading goes
+     * through the kernel (process_vm_readv, or /proc/self/mem), so that memory unmapped by another thread
+     * in the meantime is skipped rather than crashing. Deactivations alone are delivered without warm-up,
+     * but never overtake earlier activations.<br />
+     * The engine allocates the wavetables itself, so their addresses are not known here. The instrument
+     * memory is taken to be the private anonymous memory that appears while the instrument loads: the
+     * mappings are recorded before loading (recordMappingsBeforeLoad) and once loaded (recordLoadedMappings),
+     * and only the ranges added in between are warmed up. Without both records, nothing is warmed up.
+     * Wavetables recomputed later, e.g. on retuning, may lie outside these ranges. A warm-up stops after
+     * warmUpBudgetMicroseconds, so that it never holds activations back for longer.<br />
+     * Optionally, the large ranges are also locked in memory (mlock), which the system may refuse beyond
+     * the RLIMIT_MEMLOCK limit of the process; refusals are counted. On platforms other than Linux and
+     * Android, the changes are delivered right away.
+     */
+    class AeolusMemoryWarmer {
+    public:
+        /** Stop change, delivered after warm-up */
+        struct StopChange {
+            int division;
+            int stop;
+            bool activate;
+        };
+
+        /** Delivery of a stop change, on the warm-up thread */
+        typedef void (*Deliver)(void *context, const StopChange &change);
+
+        /** Activity counters */
+        struct Statistics {
+            /** Number of warm-ups run */
+            uint64_t warmUps = 0;
+            /** Pages examined, over all warm-ups */
+            uint64_t pagesScanned = 0;
+            /** Pages found not resident and read in, over all warm-ups */
+            uint64_t pagesFaultedIn = 0;
+            /** Minor page faults taken by the warm-up thread while warming up */
+            uint64_t minorFaults = 0;
+            /** Major page faults (read from storage) taken by the warm-up thread while warming up */
+            uint64_t majorFaults = 0;
+            /** Bytes currently locked in memory */
+            uint64_t bytesLocked = 0;
+            /** Number of mappings the system refused to lock */
+            uint64_t lockFailures = 0;
+            /** Duration of the last warm-up, in microseconds */
+            uint64_t lastWarmUpMicroseconds = 0;
+            /** Number of warm-ups stopped at warmUpBudgetMicroseconds */
+            uint64_t truncatedWarmUps = 0;
+            /** Size of the instrument memory, as recorded while loading */
+            uint64_t instrumentBytes = 0;
+        };
+
+        /** Ranges of at least this size are locked when locking is on */
+        static constexpr size_t lockMinimumBytes = 1024 * 1024;
+
+        /** Longest warm-up; the pages not reached by then are left to fault in the audio callback */
+        static constexpr int64_t warmUpBudgetMicroseconds = 20000;
+
+        /**
+         * Start the warm-up thread
+         * @param deliver Called for each stop change, after warm-up
+         * @param context Passed to deliver
+         */
+        AeolusMemoryWarmer(Deliver deliver, void *context);
+
+        /** Stops the thread; stop changes not delivered yet are dropped */
+        ~AeolusMemoryWarmer();
+
+        /**
+         * Queue a stop change. Can be called from any thread except the audio thread.
+         * @param change The change
+         */
+        void submit(const StopChange &change);
+
+        /**
+         * Record the mappings of the process before the instrument is loaded. Call before the engine
+         * threads start.
+         */
+        void recordMappingsBeforeLoad();
+
+        /**
+         * Take the mappings that have appeared since recordMappingsBeforeLoad as the instrument memory.
+         * Can be called several times while loading, the last call counts.
+         */
+        void recordLoadedMappings();
+
+        /**
+         * Turn warm-up on or off (off by default). When off, stop changes are still delivered in order
+         * by the thread, without warm-up.
+         * @param enabled True to warm up before activations
+         */
+        void setEnabled(bool enabled);
+
+        /** Is warm-up on? */
+        bool isEnabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+        /**
+         * Lock the large ranges of the instrument memory at the next warm-up, or unlock them
+         * @param locking True to lock
+         */
+        void setLocking(bool locking);
+
+        /** Is locking on? */
+        bool isLocking() const { return _locking.load(std::memory_order_relaxed); }
+
+        /**
+         * Read the counters, from any thread
+         * @return Copy of the counters
+         */
+        Statistics statistics() const;
+
+        /**
+         * Run a warm-up on the calling thread, e.g. once the instrument is loaded
+         */
+        void warmUpNow();
+
+    private:
+        void run();
+
+        void warmUp();
+
+        void lockMappings(const std::vector<std::pair<uintptr_t, size_t>> &mappings);
+
+        void unlockAll();
+
+        Deliver _deliver;
+        void *_context;
+
+        std::atomic<bool> _enabled{false};
+        std::atomic<bool> _locking{false};
+
+        std::mutex _mutex;
+        std::condition_variable _wake;
+        std::deque<StopChange> _pending;
+        bool _quit = false;
+
+        /** Serializes warm-ups, the lock bookkeeping and the instrument memory records */
+        std::mutex _warmUpMutex;
+        std::vector<std::pair<uintptr_t, size_t>> _locked;
+        /** Mappings before loading, sorted by address */
+        std::vector<std::pair<uintptr_t, size_t>> _beforeLoad;
+        bool _beforeLoadRecorded = false;
+        /** Instrument memory: ranges mapped while loading */
+        std::vector<std::pair<uintptr_t, size_t>> _instrument;
+
+        std::atomic<uint64_t> _warmUps{0};
+        std::atomic<uint64_t> _pagesScanned{0};
+        std::atomic<uint64_t> _pagesFaultedIn{0};
+        std::atomic<uint64_t> _minorFaults{0};
+        std::atomic<uint64_t> _majorFaults{0};
+        std::atomic<uint64_t> _bytesLocked{0};
+        std::atomic<uint64_t> _lockFailures{0};
+        std::atomic<uint64_t> _lastWarmUpMicroseconds{0};
+        std::atomic<uint64_t> _truncatedWarmUps{0};
+        std::atomic<uint64_t> _instrumentBytes{0};
+
+        std::thread _thread;
+    };
+}
+
+#endif //MIDI_SYNTH_AEOLUSMEMORYWARMER_H
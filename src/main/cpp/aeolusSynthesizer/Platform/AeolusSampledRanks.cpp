@@ -0,0 +1,458 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "AeolusSampledRanks.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+
+#include "AeolusLog.h"
+
+namespace Aeolussynthesizer {
+
+    namespace {
+        template<typename T>
+        void add(std::atomic<T> &counter, T value) {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        const uint64_t readyFrames = ((uint64_t) 1 << 48) - 1;
+    }
+
+    AeolusSampledRanks::AeolusSampledRanks(int samplingRate, int periodFrames, double attackSeconds,
+                                           double lookaheadSeconds, double releaseSeconds, int voices) :
+            _samplingRate(samplingRate), _periodFrames(periodFrames), _attackSeconds(attackSeconds),
+            _lookaheadSeconds(lookaheadSeconds),
+            _releaseFrames(std::max(1, (int) (releaseSeconds * samplingRate))),
+            _voices(new Voice[voices]), _voiceCount(voices) {
+        sem_init(&_wake, 0, 0);
+    }
+
+    AeolusSampledRanks::~AeolusSampledRanks() {
+        if (_thread.joinable()) {
+            _quit.store(true, std::memory_order_release);
+            sem_post(&_wake);
+            _thread.join();
+        }
+        sem_destroy(&_wake);
+    }
+
+    int AeolusSampledRanks::load(const std::string &path, const std::string &stopsRoot) {
+        std::ifstream list(path);
+        if (!list) return 0;
+        std::string line;
+        while (std::getline(list, line)) {
+            std::istringstream words(line);
+            std::string command, directory;
+            int division = 0, stop = 0;
+            float gainDb = 0.0f;
+            if (!(words >> command) || command != "/sampled/rank") continue;
+            if (!(words >> division >> stop >> gainDb >> directory) || division < 1 || division > maxDivisions ||
+                stop < 1 || stop > 64) {
+                aeolusLog(LogLevel::WARN, "AeolusSampledRanks", "Invalid line in %s: %s", path.c_str(), line.c_str());
+                continue;
+            }
+            auto rank = std::make_unique<Rank>();
+            rank->directory = directory;
+            rank->division = division - 1;
+            rank->stop = stop - 1;
+            rank->gain = powf(10.0f, gainDb / 20.0f);
+            std::string error;
+            for (int key = 0; key < keys; key++) {
+                std::string base = stopsRoot + "/" + directory + "/" + std::to_string(key);
+                auto sustain = std::make_unique<AeolusMappedSample>();
+                if (!sustain->open(base + ".wav", _attackSeconds, error)) continue;
+                rank->sustain[key] = std::move(sustain);
+                rank->recordings++;
+                auto release = std::make_unique<AeolusMappedSample>();
+                if (release->open(base + "-release.wav", _attackSeconds, error)) {
+                    rank->release[key] = std::move(release);
+                    rank->recordings++;
+                }
+            }
+            if (rank->recordings == 0) {
+                aeolusLog(LogLevel::WARN, "AeolusSampledRanks", "No recordings in %s/%s",
+                          stopsRoot.c_str(), directory.c_str());
+                continue;
+            }
+            aeolusLog(LogLevel::INFO, "AeolusSampledRanks", "Rank %s on stop %d of division %d: %d recordings",
+                      directory.c_str(), stop, division, rank->recordings);
+            _ranks.push_back(std::move(rank));
+        }
+        _rankActive.assign(_ranks.size(), false);
+        _keyVoice.assign(_ranks.size(), std::vector<int16_t>(keys, noVoice));
+        if (!_ranks.empty()) _thread = std::thread(&AeolusSampledRanks::run, this);
+        return (int) _ranks.size();
+    }
+
+    std::string AeolusSampledRanks::rankSummary(int rank) const {
+        const Rank &r = *_ranks[rank];
+        char line[256];
+        snprintf(line, sizeof(line), "%s (division %d, stop %d): %d recordings, %llu underruns",
+                 r.directory.c_str(), r.division + 1, r.stop + 1, r.recordings,
+                 (unsigned long long) r.underruns.load(std::memory_order_relaxed));
+        return line;
+    }
+
+    void AeolusSampledRanks::setStops(int division, unsigned long stops) {
+        for (auto &rank: _ranks) {
+            if (rank->division == division) {
+                rank->active.store(rank->stop < 64 && ((stops >> rank->stop) & 1ul) != 0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void AeolusSampledRanks::setCoupledDivisions(unsigned divisions) {
+        _coupledDivisions.store(divisions, std::memory_order_relaxed);
+    }
+
+    void AeolusSampledRanks::noteOn(int key, unsigned divisions) {
+        if (_ranks.empty() || key < 0 || key >= keys) return;
+        std::lock_guard<std::mutex> lock(_eventMutex);
+        uint32_t written = _eventsWritten.load(std::memory_order_relaxed);
+        if (written - _eventsRead.load(std::memory_order_acquire) >= eventCapacity) return;
+        _events[written % eventCapacity] = (uint32_t) key | 0x80u | (divisions & 0xffu) << 8;
+        _eventsWritten.store(written + 1, std::memory_order_release);
+    }
+
+    void AeolusSampledRanks::noteOff(int key, unsigned divisions) {
+        if (_ranks.empty() || key < 0 || key >= keys) return;
+        std::lock_guard<std::mutex> lock(_eventMutex);
+        uint32_t written = _eventsWritten.load(std::memory_order_relaxed);
+        if (written - _eventsRead.load(std::memory_order_acquire) >= eventCapacity) return;
+        _events[written % eventCapacity] = (uint32_t) key | (divisions & 0xffu) << 8;
+        _eventsWritten.store(written + 1, std::memory_order_release);
+    }
+
+    void AeolusSampledRanks::setStreamingInBackground(bool background) {
+        _background.store(background, std::memory_order_relaxed);
+    }
+
+    bool AeolusSampledRanks::active() const {
+        return _sounding.load(std::memory_order_relaxed) > 0 ||
+               _eventsWritten.load(std::memory_order_acquire) != _eventsRead.load(std::memory_order_relaxed);
+    }
+
+    bool AeolusSampledRanks::processEvents() {
+        uint32_t read = _eventsRead.load(std::memory_order_relaxed);
+        uint32_t written = _eventsWritten.load(std::memory_order_acquire);
+        if (read == written) return false;
+        for (; read != written; read++) {
+            uint32_t event = _events[read % eventCapacity];
+            int key = (int) (event & 0x7fu);
+            bool on = (event & 0x80u) != 0;
+            for (int d = 0; d < maxDivisions; d++) {
+                if (((event >> (8 + d)) & 1u) == 0) continue;
+                uint8_t &held = _held[d][key];
+                if (on) {
+                    if (held < 255) held++;
+                } else if (held > 0) {
+                    held--;
+                }
+            }
+        }
+        _eventsRead.store(written, std::memory_order_release);
+        return true;
+    }
+
+    void AeolusSampledRanks::updatePipes() {
+        unsigned coupled = _coupledDivisions.load(std::memory_order_relaxed);
+        bool changed = processEvents() || coupled != _appliedCoupled;
+        _appliedCoupled = coupled;
+        for (size_t r = 0; r < _ranks.size(); r++) {
+            bool active = _ranks[r]->active.load(std::memory_order_relaxed);
+            changed = changed || active != _rankActive[r];
+            _rankActive[r] = active;
+        }
+        if (!changed) return;
+        for (size_t r = 0; r < _ranks.size(); r++) {
+            const Rank &rank = *_ranks[r];
+            bool reached = ((coupled >> rank.division) & 1u) != 0;
+            for (int key = 0; key < keys; key++) {
+                bool held = _held[rank.division][key] > 0;
+                // As for the polyphony ceiling, a coupler is assumed to bring every key to the division
+                for (int d = 0; reached && !held && d < maxDivisions; d++) held = _held[d][key] > 0;
+                bool sounds = _rankActive[r] && held && rank.sustain[key] != nullptr;
+                int16_t &voice = _keyVoice[r][key];
+                if (sounds && voice == noVoice) {
+                    startVoice((int) r, key);
+                } else if (!sounds && voice >= 0) {
+                    releaseVoice(voice);
+                    voice = noVoice;
+                } else if (!sounds) {
+                    voice = noVoice;
+                }
+            }
+        }
+    }
+
+    void AeolusSampledRanks::startVoice(int rank, int key) {
+        // A free voice, or else the oldest released one
+        int chosen = -1;
+        for (int v = 0; v < _voiceCount; v++) {
+            Voice &voice = _voices[v];
+            if (voice.rank < 0) {
+                chosen = v;
+                break;
+            }
+            if (voice.released && (chosen < 0 || voice.started < _voices[chosen].started)) chosen = v;
+        }
+        if (chosen < 0) {
+            add(_notesDropped, (uint64_t) 1);
+            return;
+        }
+        Voice &voice = _voices[chosen];
+        if (voice.rank < 0) add(_sounding, 1);
+        const AeolusMappedSample *sustain = _ranks[rank]->sustain[key].get();
+        const AeolusMappedSample *release = _ranks[rank]->release[key].get();
+        uint32_t generation = voice.generation.load(std::memory_order_relaxed) + 1;
+        // Everything the streaming thread reads is set up before the new generation is published
+        voice.main.ready.store(pack(generation, sustain->attackResident() ? sustain->attackFrames() : 0),
+                               std::memory_order_relaxed);
+        voice.main.distance.store(0, std::memory_order_relaxed);
+        voice.main.sample.store(sustain, std::memory_order_relaxed);
+        voice.main.position = 0.0;
+        voice.main.played = 0.0;
+        voice.main.gain = 1.0f;
+        voice.main.gainStep = 0.0f;
+        voice.release.ready.store(pack(generation, release != nullptr && release->attackResident() ?
+                                                   release->attackFrames() : 0), std::memory_order_relaxed);
+        voice.release.distance.store(0, std::memory_order_relaxed);
+        voice.release.sample.store(nullptr, std::memory_order_relaxed);
+        voice.pendingRelease.store(release, std::memory_order_relaxed);
+        voice.generation.store(generation, std::memory_order_release);
+        voice.rank = rank;
+        voice.key = key;
+        voice.released = false;
+        voice.started = _periods;
+        _keyVoice[rank][key] = (int16_t) chosen;
+        add(_notesStarted, (uint64_t) 1);
+        int sounding = _sounding.load(std::memory_order_relaxed);
+        if (sounding > _peakVoices.load(std::memory_order_relaxed)) {
+            _peakVoices.store(sounding, std::memory_order_relaxed);
+        }
+    }
+
+    void AeolusSampledRanks::releaseVoice(int v) {
+        Voice &voice = _voices[v];
+        voice.released = true;
+        voice.main.gainStep = -voice.main.gain / (float) _releaseFrames;
+        const AeolusMappedSample *release = voice.pendingRelease.load(std::memory_order_relaxed);
+        voice.pendingRelease.store(nullptr, std::memory_order_relaxed);
+        if (release == nullptr) return;
+        uint64_t ready = voice.release.ready.load(std::memory_order_acquire);
+        if ((int64_t) (ready & readyFrames) < _periodFrames * 2) {
+            // Not in memory in time: the pipe fades out without its release
+            add(_releaseUnderruns, (uint64_t) 1);
+            add(_ranks[voice.rank]->underruns, (uint64_t) 1);
+            return;
+        }
+        voice.release.position = 0.0;
+        voice.release.played = 0.0;
+        // Crossfade from the sustain
+        voice.release.gain = 0.0f;
+        voice.release.gainStep = 1.0f / (float) _releaseFrames;
+        voice.release.sample.store(release, std::memory_order_release);
+    }
+
+    bool AeolusSampledRanks::play(Voice &voice, Playhead &playhead, float gain, double pitch,
+                                  float *left, float *right) {
+        const AeolusMappedSample *sample = playhead.sample.load(std::memory_order_relaxed);
+        double increment = pitch * sample->samplingRate() / _samplingRate;
+        if (!sample->looped() && playhead.played >= (double) sample->frames()) return false;
+        // Frames read in this period; beyond the end of a recording without loop, there is nothing to read
+        double needed = playhead.played + increment * _periodFrames + 2.0;
+        if (!sample->looped()) needed = std::min(needed, (double) sample->frames());
+        uint64_t ready = playhead.ready.load(std::memory_order_acquire);
+        if ((double) (int64_t) (ready & readyFrames) < needed) {
+            add(_underruns, (uint64_t) 1);
+            add(_ranks[voice.rank]->underruns, (uint64_t) 1);
+            return true;
+        }
+        int frames = _periodFrames;
+        float gainStep = playhead.gainStep;
+        if (gainStep != 0.0f) {
+            // Fades end within the period
+            float end = playhead.gain + gainStep * frames;
+            if (end <= 0.0f) frames = std::max(0, std::min(frames, (int) (playhead.gain / -gainStep)));
+            if (end >= 1.0f) {
+                gainStep = (1.0f - playhead.gain) / frames;
+            }
+        }
+        sample->mix(playhead.position, increment, gain * playhead.gain, gain * gainStep, left, right, frames);
+        playhead.played += increment * frames;
+        playhead.gain = std::min(1.0f, playhead.gain + gainStep * frames);
+        if (playhead.gain >= 1.0f) playhead.gainStep = 0.0f;
+        playhead.distance.store((int64_t) playhead.played, std::memory_order_release);
+        if (frames < _periodFrames || playhead.gain <= 0.0f) return false;
+        return sample->looped() || playhead.played < (double) sample->frames();
+    }
+
+    void AeolusSampledRanks::render(const float *divisionGains, double pitch, float *left, float *right) {
+        if (_ranks.empty()) return;
+        updatePipes();
+        bool background = _background.load(std::memory_order_relaxed);
+        if (!background) streamVoices();
+        _periods++;
+        int sounding = 0;
+        for (int v = 0; v < _voiceCount; v++) {
+            Voice &voice = _voices[v];
+            if (voice.rank < 0) continue;
+            const Rank &rank = *_ranks[voice.rank];
+            float gain = rank.gain * divisionGains[rank.division];
+            if (voice.main.sample.load(std::memory_order_relaxed) != nullptr &&
+                !play(voice, voice.main, gain, pitch, left, right)) {
+                voice.main.sample.store(nullptr, std::memory_order_relaxed);
+            }
+            if (voice.release.sample.load(std::memory_order_relaxed) != nullptr &&
+                !play(voice, voice.release, gain, pitch, left, right)) {
+                voice.release.sample.store(nullptr, std::memory_order_relaxed);
+            }
+            if (voice.main.sample.load(std::memory_order_relaxed) == nullptr &&
+                voice.release.sample.load(std::memory_order_relaxed) == nullptr) {
+                // Ended by itself, e.g. a recording without loop: not started again until the key is released
+                if (!voice.released) _keyVoice[voice.rank][voice.key] = endedVoice;
+                voice.pendingRelease.store(nullptr, std::memory_order_relaxed);
+                voice.rank = -1;
+                continue;
+            }
+            sounding++;
+        }
+        _sounding.store(sounding, std::memory_order_relaxed);
+        if (sounding > 0 && background) sem_post(&_wake);
+    }
+
+    AeolusSampledRanks::Statistics AeolusSampledRanks::statistics() const {
+        Statistics s;
+        s.ranks = (int) _ranks.size();
+        for (const auto &rank: _ranks) {
+            s.recordings += rank->recordings;
+            for (int key = 0; key < keys; key++) {
+                for (const AeolusMappedSample *sample: {rank->sustain[key].get(), rank->release[key].get()}) {
+                    if (sample == nullptr) continue;
+                    s.bytesMapped += sample->mappedBytes();
+                }
+            }
+        }
+        s.attacksResident = _attacksResident.load(std::memory_order_acquire);
+        if (s.attacksResident) {
+            // Only written by the streaming thread before attacksResident is set
+            for (const auto &rank: _ranks) {
+                for (int key = 0; key < keys; key++) {
+                    if (rank->sustain[key] != nullptr) s.bytesLocked += rank->sustain[key]->lockedBytes();
+                    if (rank->release[key] != nullptr) s.bytesLocked += rank->release[key]->lockedBytes();
+                }
+            }
+        }
+        s.lockFailures = _lockFailures.load(std::memory_order_relaxed);
+        s.voices = _sounding.load(std::memory_order_relaxed);
+        s.peakVoices = _peakVoices.load(std::memory_order_relaxed);
+        s.notesStarted = _notesStarted.load(std::memory_order_relaxed);
+        s.notesDropped = _notesDropped.load(std::memory_order_relaxed);
+        s.pagesStreamed = _pagesStreamed.load(std::memory_order_relaxed);
+        s.underruns = _underruns.load(std::memory_order_relaxed);
+        s.releaseUnderruns = _releaseUnderruns.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    void AeolusSampledRanks::publishReady(Playhead &playhead, uint32_t generation, int64_t frames) {
+        uint64_t current = playhead.ready.load(std::memory_order_acquire);
+        while ((current >> 48) == (generation & 0xffffu) && (int64_t) (current & readyFrames) < frames) {
+            if (playhead.ready.compare_exchange_weak(current, pack(generation, frames), std::memory_order_acq_rel)) {
+                return;
+            }
+        }
+    }
+
+    void AeolusSampledRanks::stream(const AeolusMappedSample &sample, int64_t from, Playhead &playhead,
+                                    uint32_t generation) {
+        // In frames of the recording, whose sampling rate may differ from the output
+        const int64_t lookahead = (int64_t) (_lookaheadSeconds * sample.samplingRate());
+        int64_t to = from + lookahead;
+        uint64_t pages = 0;
+        if (!sample.looped() || to <= sample.loopEnd()) {
+            // One frame before, for the interpolation
+            pages += sample.prefetch(from - 1, to + 1);
+        } else {
+            // The distance played is a position in the loop once past its end
+            int64_t loopFrames = sample.loopEnd() - sample.loopStart();
+            int64_t position = from < sample.loopEnd() ? from :
+                               sample.loopStart() + (from - sample.loopStart()) % loopFrames;
+            int64_t remaining = lookahead;
+            pages += sample.prefetch(position - 1, std::min(sample.loopEnd(), position + remaining));
+            remaining -= sample.loopEnd() - position;
+            if (remaining > 0) {
+                pages += sample.prefetch(sample.loopStart(), sample.loopStart() + std::min(remaining, loopFrames));
+            }
+        }
+        add(_pagesStreamed, pages);
+        publishReady(playhead, generation, to);
+    }
+
+    void AeolusSampledRanks::streamVoices() {
+        for (int v = 0; v < _voiceCount; v++) {
+            Voice &voice = _voices[v];
+            uint32_t generation = voice.generation.load(std::memory_order_acquire);
+            const AeolusMappedSample *sample = voice.main.sample.load(std::memory_order_acquire);
+            if (sample != nullptr) {
+                stream(*sample, voice.main.distance.load(std::memory_order_acquire), voice.main, generation);
+            }
+            // The beginning of the release, while the key is held
+            sample = voice.pendingRelease.load(std::memory_order_acquire);
+            if (sample != nullptr) stream(*sample, 0, voice.release, generation);
+            sample = voice.release.sample.load(std::memory_order_acquire);
+            if (sample != nullptr) {
+                stream(*sample, voice.release.distance.load(std::memory_order_acquire), voice.release,
+                       generation);
+            }
+        }
+    }
+
+    void AeolusSampledRanks::run() {
+        // Attacks first, such that the pipes can start right away
+        uint64_t pages = 0;
+        for (const auto &rank: _ranks) {
+            for (int key = 0; key < keys && !_quit.load(std::memory_order_relaxed); key++) {
+                for (AeolusMappedSample *sample: {rank->sustain[key].get(), rank->release[key].get()}) {
+                    if (sample != nullptr && !sample->makeAttackResident(pages)) add(_lockFailures, (uint64_t) 1);
+                }
+            }
+        }
+        add(_pagesStreamed, pages);
+        _attacksResident.store(true, std::memory_order_release);
+
+        while (!_quit.load(std::memory_order_acquire)) {
+            if (_background.load(std::memory_order_relaxed)) streamVoices();
+            // Posted every period while pipes sound, with a timeout as safety net. Posts that piled up
+            // during the pass are dropped, the next one follows within a period.
+            while (sem_trywait(&_wake) == 0) {}
+            timespec deadline{};
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += 20000000;
+            if (deadline.tv_nsec >= 1000000000) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000;
+            }
+            while (sem_timedwait(&_wake, &deadline) == -1 && errno == EINTR) {}
+        }
+    }
+}
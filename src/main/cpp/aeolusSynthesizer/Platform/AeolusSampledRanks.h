@@ -0,0 +1,309 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIDI_SYNTH_AEOLUSSAMPLEDRANKS_H
+#define MIDI_SYNTH_AEOLUSSAMPLEDRANKS_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <semaphore.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AeolusMappedSample.h"
+
+namespace Aeolussynthesizer {
+
+    /**
+     * @brief Ranks of recorded pipes, played from memory-mapped WAV files next to the additive ranks
+     *
+     * The ranks are listed in a file of the instrument directory, one per line:
+     * <pre>
+     * /sampled/rank &lt;division, from 1&gt; &lt;stop, from 1&gt; &lt;gain in dB&gt; &lt;directory&gt;
+     * </pre>
+     * Each rank sounds with a stop of the instrument definition, as an additional rank of that stop, and
+     * has a recording per key in its directory (relative to the stops root): &lt;MIDI key&gt;.wav, the attack
+     * and sustain loop (see AeolusMappedSample), and optionally &lt;MIDI key&gt;-release.wav, played when the
+     * key is released. Without a release recording, the pipe fades out over releaseSeconds.<br />
+     * The recordings are mapped rather than read: the attacks, and the beginning of the release recordings,
+     * are brought into memory and locked there when the ranks are loaded, and a streaming thread reads the
+     * rest of each sounding recording lookaheadSeconds ahead of its playing position. The audio thread only
+     * plays what the streaming thread has reported as in memory, which it publishes per voice; a voice
+     * whose recording is not in memory in time is silent for the period, counted as an underrun, rather
+     * than waiting for the storage.<br />
+     * Notes and stop changes come from the control side (any thread except the audio thread), render
+     * is called by the audio thread.
+     */
+    class AeolusSampledRanks {
+    public:
+        /** Maximum number of divisions, as NDIVIS in the Aeolus engine */
+        static constexpr int maxDivisions = 8;
+
+        /** Number of MIDI keys */
+        static constexpr int keys = 128;
+
+        /** Counters, over all ranks */
+        struct Statistics {
+            /** Number of ranks loaded */
+            int ranks = 0;
+            /** Number of recordings mapped */
+            int recordings = 0;
+            /** Bytes of the recordings mapped */
+            uint64_t bytesMapped = 0;
+            /** Bytes of attacks locked in memory */
+            uint64_t bytesLocked = 0;
+            /** Recordings whose attack the system refused to lock */
+            uint64_t lockFailures = 0;
+            /** Have all attacks been brought into memory? */
+            bool attacksResident = false;
+            /** Voices sounding */
+            int voices = 0;
+            /** Most voices sounding at once */
+            int peakVoices = 0;
+            /** Pipes started */
+            uint64_t notesStarted = 0;
+            /** Pipes not started, because all voices were sounding */
+            uint64_t notesDropped = 0;
+            /** Pages read in ahead of need by the streaming thread */
+            uint64_t pagesStreamed = 0;
+            /** Periods in which a voice was silent, because its recording was not yet in memory */
+            uint64_t underruns = 0;
+            /** Releases without their release recording, because it was not yet in memory */
+            uint64_t releaseUnderruns = 0;
+        };
+
+        /**
+         * @param samplingRate Output sampling rate in Hz
+         * @param periodFrames Frames per call to render
+         * @param attackSeconds Minimum length of the attacks kept in memory
+         * @param lookaheadSeconds Recordings are read this far ahead of the playing position
+         * @param releaseSeconds Fade of pipes without a release recording, and crossfade into the release recording
+         * @param voices Maximum number of pipes sounding at once
+         */
+        AeolusSampledRanks(int samplingRate, int periodFrames, double attackSeconds, double lookaheadSeconds,
+                           double releaseSeconds, int voices);
+
+        /** Stops the streaming thread */
+        ~AeolusSampledRanks();
+
+        /**
+         * Load the ranks listed in a file and start the streaming thread, before render is first called.
+         * Ranks that cannot be loaded are logged and left out.
+         * @param path Path of the list of ranks; a missing file means no ranks
+         * @param stopsRoot Directory the rank directories are relative to
+         * @return The number of ranks loaded
+         */
+        int load(const std::string &path, const std::string &stopsRoot);
+
+        /** Number of ranks loaded */
+        int rankCount() const { return (int) _ranks.size(); }
+
+        /**
+         * Describe a rank
+         * @param rank Index of the rank
+         * @return Directory, division and stop, number of recordings and underruns
+         */
+        std::string rankSummary(int rank) const;
+
+        /**
+         * Set the active stops of a division; ranks bound to active stops sound for held keys
+         * @param division Index of the division
+         * @param stops Bitmask of the active stops
+         */
+        void setStops(int division, unsigned long stops);
+
+        /**
+         * Set the divisions reached by every note through active couplers
+         * @param divisions Bitmask of divisions
+         */
+        void setCoupledDivisions(unsigned divisions);
+
+        /**
+         * A key is pressed
+         * @param key MIDI key
+         * @param divisions Bitmask of the divisions the key is played on
+         */
+        void noteOn(int key, unsigned divisions);
+
+        /**
+         * A key is released
+         * @param key MIDI key
+         * @param divisions Bitmask of the divisions the key was played on
+         */
+        void noteOff(int key, unsigned divisions);
+
+        /**
+         * Stream the recordings on the background thread (the default), or on the audio thread before
+         * each period, for offline rendering, where the output must not depend on thread scheduling and
+         * waiting for the storage does no harm. The attacks are still brought into memory in the
+         * background.
+         * @param background True for the background thread
+         */
+        void setStreamingInBackground(bool background);
+
+        /** Are the recordings streamed on the background thread? */
+        bool isStreamingInBackground() const { return _background.load(std::memory_order_relaxed); }
+
+        /** Are notes waiting for the audio thread, or pipes sounding? */
+        bool active() const;
+
+        /**
+         * Play one period, on the audio thread
+         * @param divisionGains Gain of each division
+         * @param pitch Playback rate of all pipes, relative to the recordings, for fine tuning and pitch bend
+         * @param left Left output, or the mono output, added to
+         * @param right Right output, added to, nullptr for a mono output
+         */
+        void render(const float *divisionGains, double pitch, float *left, float *right);
+
+        /**
+         * Read the counters, from any thread
+         * @return Copy of the counters
+         */
+        Statistics statistics() const;
+
+    private:
+        /** Recordings of a rank, by key */
+        struct Rank {
+            std::string directory;
+            int division = 0;
+            int stop = 0;
+            float gain = 1.0f;
+            int recordings = 0;
+            std::unique_ptr<AeolusMappedSample> sustain[keys];
+            std::unique_ptr<AeolusMappedSample> release[keys];
+            std::atomic<bool> active{false};
+            std::atomic<uint64_t> underruns{0};
+        };
+
+        /** Position in a recording */
+        struct Playhead {
+            /** Recording played, nullptr when done */
+            std::atomic<const AeolusMappedSample *> sample{nullptr};
+            /** Frames of the recording played so far, published for the streaming thread */
+            std::atomic<int64_t> distance{0};
+            /**
+             * Distance up to which the recording is in memory, in the low 48 bits, and the generation of the
+             * voice it was established for in the high 16 bits
+             */
+            std::atomic<uint64_t> ready{0};
+            /** Position in the recording, for the audio thread */
+            double position = 0.0;
+            /** Distance, for the audio thread */
+            double played = 0.0;
+            /** Gain, and its change per frame */
+            float gain = 1.0f;
+            float gainStep = 0.0f;
+        };
+
+        /** A sounding pipe: its recording, then its release recording */
+        struct Voice {
+            /** Incremented by the audio thread when the voice is reused, after setting up the playheads */
+            std::atomic<uint32_t> generation{0};
+            /** Release recording to bring into memory while the key is held, nullptr otherwise */
+            std::atomic<const AeolusMappedSample *> pendingRelease{nullptr};
+            Playhead main;
+            Playhead release;
+            int rank = -1;
+            int key = -1;
+            bool released = false;
+            uint64_t started = 0;
+        };
+
+        static uint64_t pack(uint32_t generation, int64_t frames) {
+            return (uint64_t) (generation & 0xffffu) << 48 | (uint64_t) frames;
+        }
+
+        /** Apply the queued notes, on the audio thread; returns true if any */
+        bool processEvents();
+
+        /** Start or release pipes as required by the held keys and stops, on the audio thread */
+        void updatePipes();
+
+        /** Start a pipe, on the audio thread */
+        void startVoice(int rank, int key);
+
+        /** Release a pipe, on the audio thread */
+        void releaseVoice(int voice);
+
+        /** Play a playhead of a voice; false once the recording has ended */
+        bool play(Voice &voice, Playhead &playhead, float gain, double pitch, float *left, float *right);
+
+        /** Streaming thread */
+        void run();
+
+        /** Bring the sounding recordings into memory ahead of their playing position */
+        void streamVoices();
+
+        /** Bring a recording into memory, from a distance on, and report it to the voice */
+        void stream(const AeolusMappedSample &sample, int64_t from, Playhead &playhead, uint32_t generation);
+
+        /** Report a recording in memory up to a distance, unless the voice has been reused meanwhile */
+        static void publishReady(Playhead &playhead, uint32_t generation, int64_t frames);
+
+        const int _samplingRate;
+        const int _periodFrames;
+        const double _attackSeconds;
+        const double _lookaheadSeconds;
+        const int _releaseFrames;
+
+        std::vector<std::unique_ptr<Rank>> _ranks;
+
+        /** Queue of notes: key in bits 0-6, on in bit 7, divisions in bits 8-15 */
+        static constexpr uint32_t eventCapacity = 1024;
+        uint32_t _events[eventCapacity]{};
+        std::atomic<uint32_t> _eventsWritten{0};
+        std::atomic<uint32_t> _eventsRead{0};
+        /** Serializes the control threads writing to the queue */
+        std::mutex _eventMutex;
+
+        std::atomic<unsigned> _coupledDivisions{0};
+
+        /** State of the audio thread */
+        std::unique_ptr<Voice[]> _voices;
+        const int _voiceCount;
+        std::vector<bool> _rankActive;
+        /** Voice of each key of each rank, or one of the following */
+        std::vector<std::vector<int16_t>> _keyVoice;
+        static constexpr int16_t noVoice = -1;
+        /** The recording of the held key has ended */
+        static constexpr int16_t endedVoice = -2;
+        uint8_t _held[maxDivisions][keys]{};
+        unsigned _appliedCoupled = 0;
+        uint64_t _periods = 0;
+
+        std::atomic<int> _sounding{0};
+        std::atomic<int> _peakVoices{0};
+        std::atomic<uint64_t> _notesStarted{0};
+        std::atomic<uint64_t> _notesDropped{0};
+        std::atomic<uint64_t> _pagesStreamed{0};
+        std::atomic<uint64_t> _underruns{0};
+        std::atomic<uint64_t> _releaseUnderruns{0};
+        std::atomic<uint64_t> _lockFailures{0};
+        std::atomic<bool> _attacksResident{false};
+
+        std::atomic<bool> _background{true};
+        sem_t _wake;
+        std::atomic<bool> _quit{false};
+        std::thread _thread;
+    };
+}
+
+#endif //MIDI_SYNTH_AEOLUSSAMPLEDRANKS_H
@@ -0,0 +1,79 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <chrono>
+#include "HeadlessAudioSink.h"
+
+namespace Aeolussynthesizer {
+
+    HeadlessAudioSink::HeadlessAudioSink(synthesizerBase::AudioSource *source, int samplingRate, int channels,
+                                         int framesPerBurst, bool realTime)
+            : _source(source),
+              _samplingRate(samplingRate),
+              _channels(channels),
+              _framesPerBurst(framesPerBurst),
+              _realTime(realTime),
+              _burst((size_t) framesPerBurst * channels) {
+    }
+
+    HeadlessAudioSink::~HeadlessAudioSink() {
+        // Subclasses stop in their destructor already, as consume() is no longer available here
+        stop();
+    }
+
+    int32_t HeadlessAudioSink::play() {
+        if (_running.exchange(true)) return 0;
+        _thread = std::thread(&HeadlessAudioSink::run, this);
+        return 0;
+    }
+
+    void HeadlessAudioSink::stop() {
+        _running.store(false);
+        if (_thread.joinable()) _thread.join();
+    }
+
+    void HeadlessAudioSink::setAudioSource(synthesizerBase::AudioSource *source) {
+        _source.store(source);
+    }
+
+    void HeadlessAudioSink::run() {
+        using Clock = std::chrono::steady_clock;
+        auto burstDuration = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>((double) _framesPerBurst / _samplingRate));
+        auto nextBurst = Clock::now();
+
+        while (_running.load(std::memory_order_relaxed)) {
+            synthesizerBase::AudioSource *source = _source.load();
+            if (source != nullptr) {
+                source->onAudioReady(_burst.data(), _framesPerBurst, (oboe::ChannelCount) _channels);
+            } else {
+                std::fill(_burst.begin(), _burst.end(), 0.0f);
+            }
+            consume(_burst.data(), _framesPerBurst, _channels);
+            _bursts.fetch_add(1, std::memory_order_relaxed);
+
+            if (_realTime) {
+                nextBurst += burstDuration;
+                std::this_thread::sleep_until(nextBurst);
+            }
+        }
+
+        synthesizerBase::AudioSource *source = _source.load();
+        if (source != nullptr) source->onPlaybackStopped();
+    }
+}
@@ -0,0 +1,89 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIDI_SYNTH_HEADLESSAUDIOSINK_H
+#define MIDI_SYNTH_HEADLESSAUDIOSINK_H
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "../../SynthesizerBase/include/AudioPlayer.h"
+
+namespace Aeolussynthesizer {
+
+    /**
+     * @brief Audio player without audio device, for builds and tools that do not use oboe
+     *
+     * Like the OboeAudioPlayer, a HeadlessAudioSink calls its audio source back from a dedicated thread
+     * for bursts of interleaved float audio, here of a fixed size. Each burst is handed to consume(),
+     * which subclasses implement to discard or store the audio.<br />
+     * In real time mode, bursts are requested at the pace an audio device at the given sampling rate
+     * would, which makes the sink a stand-in for oboe when profiling the whole synthesizer; otherwise,
+     * bursts are requested back to back.
+     */
+    class HeadlessAudioSink : public synthesizerBase::AudioPlayer {
+    public:
+        /**
+         * @param source The audio source to call back
+         * @param samplingRate Sampling rate in Hz
+         * @param channels Number of interleaved channels
+         * @param framesPerBurst Number of frames requested per callback
+         * @param realTime Pace the callbacks like an audio device
+         */
+        HeadlessAudioSink(synthesizerBase::AudioSource *source, int samplingRate, int channels,
+                          int framesPerBurst, bool realTime);
+
+        ~HeadlessAudioSink() override;
+
+        /** Start the callback thread */
+        int32_t play() override;
+
+        /** Stop the callback thread and wait for it to finish */
+        void stop() override;
+
+        /** Change the audio source; takes effect with the next burst */
+        void setAudioSource(synthesizerBase::AudioSource *source) override;
+
+        /** Number of bursts rendered since construction */
+        uint64_t bursts() const { return _bursts.load(std::memory_order_relaxed); }
+
+    protected:
+        /**
+         * Receive a burst of audio, on the callback thread
+         * @param audioData frames*channels interleaved samples
+         * @param frames Number of frames
+         * @param channels Number of interleaved channels
+         */
+        virtual void consume(const float *audioData, int32_t frames, int channels) = 0;
+
+    private:
+        void run();
+
+        std::atomic<synthesizerBase::AudioSource *> _source;
+        int _samplingRate;
+        int _channels;
+        int _framesPerBurst;
+        bool _realTime;
+        std::vector<float> _burst;
+        std::atomic<bool> _running{false};
+        std::atomic<uint64_t> _bursts{0};
+        std::thread _thread;
+    };
+}
+
+#endif //MIDI_SYNTH_HEADLESSAUDIOSINK_H
@@ -0,0 +1,41 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIDI_SYNTH_NULLAUDIOSINK_H
+#define MIDI_SYNTH_NULLAUDIOSINK_H
+
+#include "HeadlessAudioSink.h"
+
+namespace Aeolussynthesizer {
+
+    /**
+     * @brief Headless audio player that renders and discards the audio
+     *
+     * This is the default audio output of AeolusSynthesizer in headless builds.
+     */
+    class NullAudioSink : public HeadlessAudioSink {
+    public:
+        using HeadlessAudioSink::HeadlessAudioSink;
+
+        ~NullAudioSink() override;
+
+    protected:
+        void consume(const float *audioData, int32_t frames, int channels) override;
+    };
+}
+
+#endif //MIDI_SYNTH_NULLAUDIOSINK_H
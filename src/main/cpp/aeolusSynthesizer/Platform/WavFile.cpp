@@ -0,0 +1,191 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstring>
+#include <vector>
+#include "WavFile.h"
+
+namespace Aeolussynthesizer {
+
+    namespace {
+        void put16(uint8_t *p, uint16_t v) {
+            p[0] = (uint8_t) v;
+            p[1] = (uint8_t) (v >> 8);
+        }
+
+        void put32(uint8_t *p, uint32_t v) {
+            put16(p, (uint16_t) v);
+            put16(p + 2, (uint16_t) (v >> 16));
+        }
+
+        uint16_t get16(const uint8_t *p) {
+            return (uint16_t) (p[0] | (p[1] << 8));
+        }
+
+        uint32_t get32(const uint8_t *p) {
+            return get16(p) | ((uint32_t) get16(p + 2) << 16);
+        }
+
+        int16_t toInt16(float x) {
+            x *= 32767.0f;
+            if (x > 32767.0f) x = 32767.0f;
+            if (x < -32768.0f) x = -32768.0f;
+            return (int16_t) (x < 0.0f ? x - 0.5f : x + 0.5f);
+        }
+    }
+
+    WavFileWriter::~WavFileWriter() {
+        close();
+    }
+
+    bool WavFileWriter::open(const std::string &path, int samplingRate, int channels, Format format) {
+        close();
+        _file = fopen(path.c_str(), "wb");
+        if (_file == nullptr) return false;
+        _samplingRate = samplingRate;
+        _channels = channels;
+        _format = format;
+        _frames = 0;
+        return writeHeader();
+    }
+
+    bool WavFileWriter::writeHeader() {
+        const int bytesPerSample = _format == FLOAT_32 ? 4 : 2;
+        const uint32_t dataBytes = (uint32_t) (_frames * _channels * bytesPerSample);
+        uint8_t header[44];
+        memcpy(header, "RIFF", 4);
+        put32(header + 4, 36 + dataBytes);
+        memcpy(header + 8, "WAVEfmt ", 8);
+        put32(header + 16, 16);
+        put16(header + 20, _format == FLOAT_32 ? 3 : 1);
+        put16(header + 22, (uint16_t) _channels);
+        put32(header + 24, (uint32_t) _samplingRate);
+        put32(header + 28, (uint32_t) (_samplingRate * _channels * bytesPerSample));
+        put16(header + 32, (uint16_t) (_channels * bytesPerSample));
+        put16(header + 34, (uint16_t) (8 * bytesPerSample));
+        memcpy(header + 36, "data", 4);
+        put32(header + 40, dataBytes);
+        return fseek(_file, 0, SEEK_SET) == 0 && fwrite(header, sizeof(header), 1, _file) == 1;
+    }
+
+    bool WavFileWriter::write(const float *data, int frames) {
+        if (_file == nullptr) return false;
+        size_t n = (size_t) frames * _channels;
+        size_t written;
+        if (_format == FLOAT_32) {
+            written = fwrite(data, sizeof(float), n, _file);
+        } else {
+            std::vector<int16_t> converted(n);
+            for (size_t i = 0; i < n; i++) converted[i] = toInt16(data[i]);
+            written = fwrite(converted.data(), sizeof(int16_t), n, _file);
+        }
+        _frames += frames;
+        return written == n;
+    }
+
+    bool WavFileWriter::write(const int16_t *data, int frames) {
+        if (_file == nullptr) return false;
+        size_t n = (size_t) frames * _channels;
+        size_t written;
+        if (_format == PCM_16) {
+            written = fwrite(data, sizeof(int16_t), n, _file);
+        } else {
+            std::vector<float> converted(n);
+            for (size_t i = 0; i < n; i++) converted[i] = data[i] / 32768.0f;
+            written = fwrite(converted.data(), sizeof(float), n, _file);
+        }
+        _frames += frames;
+        return written == n;
+    }
+
+    bool WavFileWriter::close() {
+        if (_file == nullptr) return true;
+        bool ok = writeHeader();
+        ok = (fclose(_file) == 0) && ok;
+        _file = nullptr;
+        return ok;
+    }
+
+    bool WavFileData::read(const std::string &path, std::string &error) {
+        samples.clear();
+        FILE *file = fopen(path.c_str(), "rb");
+        if (file == nullptr) {
+            error = "Cannot open " + path;
+            return false;
+        }
+        std::vector<uint8_t> bytes;
+        uint8_t block[65536];
+        size_t n;
+        while ((n = fread(block, 1, sizeof(block), file)) > 0) bytes.insert(bytes.end(), block, block + n);
+        fclose(file);
+
+        if (bytes.size() < 12 || memcmp(bytes.data(), "RIFF", 4) != 0 || memcmp(bytes.data() + 8, "WAVE", 4) != 0) {
+            error = path + " is not a WAV file";
+            return false;
+        }
+        int formatTag = 0;
+        int bitsPerSample = 0;
+        bool haveFormat = false;
+        // Walk the chunks, skipping those other than fmt and data
+        for (size_t pos = 12; pos + 8 <= bytes.size();) {
+            const uint8_t *chunk = bytes.data() + pos;
+            size_t size = get32(chunk + 4);
+            size_t available = bytes.size() - pos - 8;
+            if (size > available) size = available;
+            if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+                formatTag = get16(chunk + 8);
+                channels = get16(chunk + 10);
+                samplingRate = (int) get32(chunk + 12);
+                bitsPerSample = get16(chunk + 22);
+                // WAVE_FORMAT_EXTENSIBLE, as most multichannel and 24 bit files: the format is in the sub-format
+                if (formatTag == 0xfffe && size >= 40) formatTag = get16(chunk + 32);
+                haveFormat = true;
+            } else if (memcmp(chunk, "data", 4) == 0 && haveFormat) {
+                const uint8_t *data = chunk + 8;
+                if (formatTag == 1 && bitsPerSample == 16) {
+                    samples.resize(size / 2);
+                    for (size_t i = 0; i < samples.size(); i++) {
+                        samples[i] = (int16_t) get16(data + 2 * i) / 32768.0f;
+                    }
+                } else if (formatTag == 1 && bitsPerSample == 24) {
+                    samples.resize(size / 3);
+                    for (size_t i = 0; i < samples.size(); i++) {
+                        const uint8_t *p = data + 3 * i;
+                        int32_t v = (int32_t) ((uint32_t) p[0] << 8 | (uint32_t) p[1] << 16 | (uint32_t) p[2] << 24);
+                        samples[i] = (float) (v >> 8) / 8388608.0f;
+                    }
+                } else if (formatTag == 1 && bitsPerSample == 32) {
+                    samples.resize(size / 4);
+                    for (size_t i = 0; i < samples.size(); i++) {
+                        samples[i] = (float) ((double) (int32_t) get32(data + 4 * i) / 2147483648.0);
+                    }
+                } else if (formatTag == 3 && bitsPerSample == 32) {
+                    samples.resize(size / 4);
+                    memcpy(samples.data(), data, samples.size() * sizeof(float));
+                } else {
+                    error = path + ": unsupported sample format";
+                    return false;
+                }
+                return channels > 0;
+            }
+            pos += 8 + size + (size & 1);
+        }
+        error = path + ": no audio data";
+        return false;
+    }
+
+}
@@ -0,0 +1,117 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIDI_SYNTH_WAVFILE_H
+#define MIDI_SYNTH_WAVFILE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace Aeolussynthesizer {
+
+    /**
+     * @brief Minimal writer for RIFF/WAVE files with interleaved 16 bit integer or 32 bit float samples
+     *
+     * The header is written when opening and the chunk sizes are filled in when closing.
+     */
+    class WavFileWriter {
+    public:
+        /** Sample format of the file */
+        enum Format {
+            PCM_16,
+            FLOAT_32
+        };
+
+        ~WavFileWriter();
+
+        /**
+         * Create the file and write the header
+         * @param path Path of the file, overwritten if it exists
+         * @param samplingRate Sampling rate in Hz
+         * @param channels Number of interleaved channels
+         * @param format Sample format
+         * @return True on success
+         */
+        bool open(const std::string &path, int samplingRate, int channels, Format format);
+
+        /**
+         * Append interleaved float frames
+         * @param data frames*channels samples
+         * @param frames Number of frames
+         * @return True on success
+         */
+        bool write(const float *data, int frames);
+
+        /**
+         * Append interleaved 16 bit integer frames
+         * @param data frames*channels samples
+         * @param frames Number of frames
+         * @return True on success
+         */
+        bool write(const int16_t *data, int frames);
+
+        /**
+         * Complete the header and close the file
+         * @return True on success
+         */
+        bool close();
+
+        /** Sample format of the open file */
+        Format format() const { return _format; }
+
+        /** Number of frames written so far */
+        uint64_t frames() const { return _frames; }
+
+    private:
+        bool writeHeader();
+
+        FILE *_file = nullptr;
+        int _samplingRate = 0;
+        int _channels = 0;
+        Format _format = PCM_16;
+        uint64_t _frames = 0;
+    };
+
+    /**
+     * @brief Reads RIFF/WAVE files with 16, 24 or 32 bit integer or 32 bit float samples
+     *
+     * Reads the files written by WavFileWriter, and those of common recording tools, such as impulse
+     * responses (see AeolusSynthesizer::setConvolutionReverb), including WAVE_FORMAT_EXTENSIBLE headers.
+     * The whole file is read into memory as interleaved float samples.
+     */
+    struct WavFileData {
+        int samplingRate = 0;
+        int channels = 0;
+        /** Interleaved samples, scaled to -1..1 for integer files */
+        std::vector<float> samples;
+
+        /** Number of frames */
+        uint64_t frames() const { return channels > 0 ? samples.size() / channels : 0; }
+
+        /**
+         * Read a file, replacing the current content
+         * @param path Path of the file
+         * @param error Description of the problem if reading fails
+         * @return True on success
+         */
+        bool read(const std::string &path, std::string &error);
+    };
+}
+
+#endif //MIDI_SYNTH_WAVFILE_H
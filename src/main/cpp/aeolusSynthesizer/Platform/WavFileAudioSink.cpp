@@ -0,0 +1,37 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "WavFileAudioSink.h"
+
+namespace Aeolussynthesizer {
+
+    WavFileAudioSink::WavFileAudioSink(synthesizerBase::AudioSource *source, const std::string &path,
+                                       int samplingRate, int channels, int framesPerBurst, bool realTime,
+                                       WavFileWriter::Format format)
+            : HeadlessAudioSink(source, samplingRate, channels, framesPerBurst, realTime) {
+        _open = _writer.open(path, samplingRate, channels, format);
+    }
+
+    WavFileAudioSink::~WavFileAudioSink() {
+        stop();
+        if (_open) _writer.close();
+    }
+
+    void WavFileAudioSink::consume(const float *audioData, int32_t frames, int) {
+        if (_open) _writer.write(audioData, frames);
+    }
+}
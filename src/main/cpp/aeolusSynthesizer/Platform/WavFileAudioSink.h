@@ -0,0 +1,61 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIDI_SYNTH_WAVFILEAUDIOSINK_H
+#define MIDI_SYNTH_WAVFILEAUDIOSINK_H
+
+#include <string>
+#include "HeadlessAudioSink.h"
+#include "WavFile.h"
+
+namespace Aeolussynthesizer {
+
+    /**
+     * @brief Headless audio player that records the audio to a WAV file
+     *
+     * The file is created on construction and completed when the sink is destroyed.
+     */
+    class WavFileAudioSink : public HeadlessAudioSink {
+    public:
+        /**
+         * @param source The audio source to call back
+         * @param path Path of the WAV file
+         * @param samplingRate Sampling rate in Hz
+         * @param channels Number of interleaved channels
+         * @param framesPerBurst Number of frames requested per callback
+         * @param realTime Pace the callbacks like an audio device
+         * @param format Sample format of the file
+         */
+        WavFileAudioSink(synthesizerBase::AudioSource *source, const std::string &path, int samplingRate,
+                         int channels, int framesPerBurst, bool realTime,
+                         WavFileWriter::Format format = WavFileWriter::PCM_16);
+
+        ~WavFileAudioSink() override;
+
+        /** True if the file could be created */
+        bool isOpen() const { return _open; }
+
+    protected:
+        void consume(const float *audioData, int32_t frames, int channels) override;
+
+    private:
+        WavFileWriter _writer;
+        bool _open;
+    };
+}
+
+#endif //MIDI_SYNTH_WAVFILEAUDIOSINK_H
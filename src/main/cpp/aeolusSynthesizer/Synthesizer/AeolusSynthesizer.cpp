@@ -5,8 +5,22 @@
 
 
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <dirent.h>
+#include <strings.h>
 #include "include/AeolusSynthesizer.h"
+#ifdef AEOLUS_HEADLESS
+#include "../Platform/NullAudioSink.h"
+#else
 #include "../../SynthesizerBase/include/OboeAudioPlayer.h"
+#endif
+#include "../Platform/AeolusLog.h"
+#include "../Platform/WavFile.h"
 #include "../UserInterface/android_aeolus_user_interface.h"
 #include "../MidiInterface/MidiAndoidAeolus.h"
 
@@ -14,34 +28,69 @@
 namespace Aeolussynthesizer {
 
     AeolusSynthesizer::AeolusSynthesizer( Lfq_u32 *qnote, Lfq_u32 *qcomm,Lfq_u8* qmidi,
-                                         const char *stopsPath)
+                                         const char *stopsPath, bool withAudioOutput)
                                          : AeolusAudio("AeolusAudio", qnote, qcomm),
+                                           _periodBuffer(max_output_channels, PERIOD),
+                                           _renderAhead(max_output_channels, PERIOD, renderAheadPeriod, this),
+                                           _divisionActivity((int) (idle_division_release_seconds*synthesizerBase::samplingRate/PERIOD),
+                                                             zero_gain_fade_periods),
+                                           _registrationStager((double) PERIOD/synthesizerBase::samplingRate,
+                                                               registration_changes_per_period),
+                                           _budgetGovernor(1e9*PERIOD/synthesizerBase::samplingRate,
+                                                           (int) (budget_recover_hold_seconds*synthesizerBase::samplingRate/PERIOD)),
+                                           _polyphonyLimiter(releaseStolenNote, this,
+                                                             (int) (polyphony_release_seconds*synthesizerBase::samplingRate/PERIOD)),
+                                           _idleDetector(idle_silence_threshold,
+                                                         (int) (idle_hold_seconds*synthesizerBase::samplingRate/PERIOD)),
+                                           _convolutionReverb(synthesizerBase::samplingRate, PERIOD,
+                                                              convolution_tail_block_frames, reverb_fade_periods),
+                                           _sampledRanks(synthesizerBase::samplingRate, PERIOD, sampled_attack_seconds,
+                                                         sampled_lookahead_seconds, sampled_release_seconds, sampled_voices),
+                                           _varispeed(max_output_channels, PERIOD, pow(2.0, pitch_offset_max_cents/1200.0),
+                                                      pow(2.0, varispeed_drain_cents/1200.0)),
                                            _ui{std::make_unique<android_aeolus_user_interface>()},
                                            _qmidi(qmidi),
                                            stop_directory("stops/stops"),
                                            instrument_directory("stops/Aeolus"),
                                            wave_directory("waves"),
+                                           impulse_directory("impulses"),
                                            _midiInterface{std::make_unique<MidiAndroidAeolus>(qnote, qmidi, midimap(), "Aeolus Midi")}
                                            {
 
          setStopsPath(stopsPath);
+        _definitionDivisions=readDivisionSections();
+        _sampledRanks.load(std::string(_stopsPath) + "/" + instrument_directory + "/sampled", _stopsPath);
+        // Chosen once here rather than at the first audio callback
+        aeolusLog(LogLevel::INFO, "AeolusSynthesizer", "Using %s audio kernels",
+                  AeolusKernels::isaName(AeolusKernels::active().isa));
 
 
         _defaultOscillator = std::make_unique<Aeolussynthesizer::AeolusOscillator>(this);
         _fsamp=synthesizerBase::samplingRate; // Defined from the synthesizer base clase
-        _audioPlayer =
-                std::make_unique<synthesizerBase::OboeAudioPlayer>(_defaultOscillator.get(),
-                                                                   synthesizerBase::samplingRate);
+#ifdef AEOLUS_HEADLESS
+        if(withAudioOutput) {
+            _audioPlayer =
+                    std::make_unique<NullAudioSink>(_defaultOscillator.get(), synthesizerBase::samplingRate,
+                                                    max_output_channels, headless_frames_per_burst, true);
+        }
+        _nplay=max_output_channels;
+#else
+        if(withAudioOutput) {
+            _audioPlayer =
+                    std::make_unique<synthesizerBase::OboeAudioPlayer>(_defaultOscillator.get(),
+                                                                       synthesizerBase::samplingRate);
+        }
         _nplay=synthesizerBase::OboeAudioPlayer::defaultChannels;
-        if(_nplay>2)
+#endif
+        if(_nplay>max_output_channels)
         {
-            _nplay=2;
+            _nplay=max_output_channels;
         }
-        _fsize=synthesizerBase::OboeAudioPlayer::defaultFrameSize;
+        // The engine always renders whole periods, independently of the burst size requested
+        // by oboe, which is served from _periodBuffer in fillAudioBuffer
+        _fsize=PERIOD;
 
-        // Normally, the audio buffer size should not change anymore, we should be able to allocate
-        // it already at this point of time
-        allocateOutputBuffer();
+        for (int i = 0; i < _nplay; i++) _outbuf [i] = _periodBuffer.channel(i);
 
 
 
@@ -59,6 +108,9 @@ namespace Aeolussynthesizer {
         const char *full_instrument_directory = s_inst.c_str();
         const char *full_wave_directory = s_wave.c_str();
 
+        // The instrument memory warmed up before stop activations is what the engine maps while loading
+        _memoryWarmer = std::make_unique<AeolusMemoryWarmer>(deliverStopChange, this);
+        _memoryWarmer->recordMappingsBeforeLoad();
         model = new Model(qcomm, _qmidi, _midimap, "aeolus",
                           full_stop_directory,
                           full_instrument_directory, full_wave_directory, false);
@@ -84,6 +136,7 @@ namespace Aeolussynthesizer {
 
         }
         slave->thr_start(SCHED_OTHER, 0, 0);
+        static_cast<android_aeolus_user_interface *>(_ui.get())->setStopsListener(onStopsUpdated, this);
         _ui->thr_start(SCHED_OTHER, 0, 0);
         _midiInterface->open_midi (); // no thread is really required since this will be called
         AeolusSynthesizer::start(); // After the midi level, transmit audio information
@@ -99,15 +152,18 @@ namespace Aeolussynthesizer {
     //_defaultOscillator->onAudioConnected();}
 
     AeolusSynthesizer::~AeolusSynthesizer(){
+        // Stop changes still waiting for warm-up are dropped
+        _memoryWarmer = nullptr;
         _audioPlayer = nullptr;
+        // The synthesis thread uses the engine, stop it while everything is still there
+        _renderAhead.setLookAhead(0);
         _defaultOscillator = nullptr;
-        for (int i = 0; i < _nplay; i++) delete[] _outbuf [i];
         delete[] _stopsPath;
     }
 
 
    void  AeolusSynthesizer::play() {
-        if(!isPlaying) {
+        if(!isPlaying && _audioPlayer != nullptr) {
             std::lock_guard<std::mutex> lock(_mutex);
             _audioPlayer->play();
             isPlaying=true;
@@ -116,7 +172,7 @@ namespace Aeolussynthesizer {
     }
 
    void  AeolusSynthesizer::stop() {
-        if(isPlaying) {
+        if(isPlaying && _audioPlayer != nullptr) {
             std::lock_guard<std::mutex> lock(_mutex);
             _audioPlayer->stop();
             isPlaying=false;
@@ -136,13 +192,20 @@ namespace Aeolussynthesizer {
     }
 
     void AeolusSynthesizer::useDefaultOscillator(){
+        if(_audioPlayer == nullptr) return;
         _audioPlayer->setAudioSource(_defaultOscillator.get());
 
     }
 
+    void AeolusSynthesizer::setAudioPlayer(std::unique_ptr<synthesizerBase::AudioPlayer> audioPlayer) {
+        stop();
+        std::lock_guard<std::mutex> lock(_mutex);
+        _audioPlayer = std::move(audioPlayer);
+    }
+
     void AeolusSynthesizer::setVolume(float volume)
     {
-
+        _outputStage.setGain(volume);
     }
 
 
@@ -171,67 +234,612 @@ namespace Aeolussynthesizer {
 
     void AeolusSynthesizer::fillAudioBuffer(float *audioData, int32_t framesCount,
                                             oboe::ChannelCount channelCount) {
+        if(framesCount != _stream.framesCount || channelCount != _stream.channelCount)
+        {
+            // First callback, or the stream has been reconfigured
+            _stream.fill=selectStreamFiller(framesCount, channelCount);
+            _stream.framesCount=framesCount;
+            _stream.channelCount=channelCount;
+        }
+        (this->*_stream.fill)(audioData, framesCount, channelCount);
+    }
 
+    template<int Channels, int Frames>
+    AeolusSynthesizer::StreamFiller AeolusSynthesizer::wholePeriodFiller() {
+        if(Frames % PERIOD != 0 || Frames < PERIOD)
+        {
+            return &AeolusSynthesizer::fillInterleavedBuffer;
+        }
+        return &AeolusSynthesizer::fillWholePeriods<Channels, Frames>;
+    }
 
-        if((framesCount ==0) | (channelCount ==0)) return;
+    template<int Channels>
+    AeolusSynthesizer::StreamFiller AeolusSynthesizer::selectStreamFiller(int32_t framesCount) {
+        switch(framesCount)
+        {
+            case 64: return wholePeriodFiller<Channels, 64>();
+            case 128: return wholePeriodFiller<Channels, 128>();
+            case 192: return wholePeriodFiller<Channels, 192>();
+            case 256: return wholePeriodFiller<Channels, 256>();
+            default: return &AeolusSynthesizer::fillInterleavedBuffer;
+        }
+    }
+
+    AeolusSynthesizer::StreamFiller AeolusSynthesizer::selectStreamFiller(int32_t framesCount, int32_t channelCount) {
+        if(_nplay != 2)
+        {
+            return &AeolusSynthesizer::fillInterleavedBuffer;
+        }
+        switch(channelCount)
+        {
+            case 1: return selectStreamFiller<1>(framesCount);
+            case 2: return selectStreamFiller<2>(framesCount);
+            default: return &AeolusSynthesizer::fillInterleavedBuffer;
+        }
+    }
 
+    template<int Channels, int Frames>
+    void AeolusSynthesizer::fillWholePeriods(float *audioData, int32_t framesCount, int32_t channelCount) {
+        if(_periodBuffer.available() != 0)
+        {
+            // Frames left over from a burst of another size, served by the general case until used up
+            fillInterleavedBuffer(audioData, framesCount, channelCount);
+            return;
+        }
+        auto start=std::chrono::steady_clock::now();
+        for(int p=0; p<Frames/PERIOD; p++)
+        {
+            nextPeriod();
+            _outputStage.processStereo<Channels>(_periodBuffer.readPointer(0), _periodBuffer.readPointer(1),
+                                                 audioData + p*PERIOD*Channels, PERIOD);
+            _periodBuffer.consume(PERIOD);
+        }
+        recordCallbackTime(start, Frames);
+    }
 
-        unsigned long start=ITC_ctrl::delay ()/1000;
-        if((_fsize!=framesCount) | (_nplay != channelCount))
+    void AeolusSynthesizer::nextPeriod() {
+        if(_renderAhead.serving())
         {
+            // Render-ahead mode: only copy the next period from the synthesis thread. On underrun,
+            // a period of silence keeps the stream going.
+            float* channels[max_output_channels];
+            for(int i=0; i<max_output_channels; i++) channels[i]=_periodBuffer.channel(i);
+            if(!_renderAhead.read(channels))
+            {
+                for(int i=0; i<max_output_channels; i++) memset(channels[i], 0, PERIOD*sizeof(float));
+            }
+            _periodBuffer.markRendered();
+        } else {
+            renderPeriod();
+        }
+    }
+
+    void AeolusSynthesizer::recordCallbackTime(std::chrono::steady_clock::time_point start, int32_t framesCount) {
+        // No logging here, we are on the audio thread: the timing goes to the lock-free
+        // statistics, which are read through getCallbackStatistics
+        auto duration=std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now()-start).count();
+        uint64_t deadline=(uint64_t) framesCount*1000000000ull/_fsamp;
+        _callbackStats.record((uint64_t) duration, framesCount, deadline);
+    }
+
+    void AeolusSynthesizer::fillInterleavedBuffer(float *audioData, int32_t framesCount,
+                                                  int32_t channelCount) {
+
+
+        if((framesCount ==0) | (channelCount ==0)) return;
+
 
-            if((_fsize*_nplay) != 0)
+        auto start=std::chrono::steady_clock::now();
+
+        const float* planar[max_output_channels];
+        int32_t framesDone=0;
+        while(framesDone < framesCount)
+        {
+            if(_periodBuffer.available()==0)
+            {
+                nextPeriod();
+            }
+            int32_t n=framesCount-framesDone;
+            if(n > _periodBuffer.available())
             {
-                // This is not good, output buffer is allocated but has the wrong size
-                // deallocate previously allocated buffer
-                for (int i = 0; i < _nplay; i++) delete[] _outbuf [i];
+                n=_periodBuffer.available();
+            }
 
+            for(int i=0; i<_nplay; i++) {
+                planar[i]=_periodBuffer.readPointer(i);
             }
-            // We need to allocate new memory for holding the audio output
+            _outputStage.process(planar, _nplay, audioData + framesDone*channelCount, channelCount, n);
 
-            _nplay=channelCount;
-            _fsize=framesCount;
-            allocateOutputBuffer();
+            _periodBuffer.consume(n);
+            framesDone+=n;
         }
 
 
 
-        proc_queue (_qnote);
-        proc_queue (_qcomm);
-        proc_keys1 ();
-        proc_keys2 ();
+        //proc_mesg();
+        recordCallbackTime(start, framesCount);
+
+    }
 
-        proc_synth(_fsize);
+    void AeolusSynthesizer::renderPeriod() {
+        // The synthesis thread points the engine elsewhere in render-ahead mode
+        for (int i = 0; i < _nplay; i++) _outbuf [i] = _periodBuffer.channel(i);
+        synthesizePeriod();
+        _periodBuffer.markRendered();
+    }
 
+    void AeolusSynthesizer::renderAheadPeriod(void *context, float *const *channels) {
+        auto *synth = static_cast<AeolusSynthesizer *>(context);
+        for (int i = 0; i < synth->_nplay; i++) synth->_outbuf [i] = channels [i];
+        synth->synthesizePeriod();
+    }
 
-        for(int i=0; i<_nplay; i++) {
-            for (int j = 0; j < _fsize; j++) {
+    void AeolusSynthesizer::setRenderAhead(int periods) {
+        _renderAhead.setLookAhead(periods);
+    }
 
-                audioData[j] = _outbuf[i][j];
+    int AeolusSynthesizer::getRenderAhead() {
+        return _renderAhead.lookAhead();
+    }
+
+    int AeolusSynthesizer::getRenderAheadLatencyFrames() {
+        return _renderAhead.bufferedPeriods()*PERIOD;
+    }
+
+    uint64_t AeolusSynthesizer::getRenderAheadUnderruns() {
+        return _renderAhead.underruns();
+    }
+
+    void AeolusSynthesizer::synthesizePeriod() {
+        // Decaying tails must not fall into the slow path of denormal floats
+        AeolusKernels::FlushDenormals flush(_flushDenormals.load(std::memory_order_relaxed));
+        // The release time of the polyphony ceilings runs on in idle periods as well
+        _polyphonyLimiter.periodRendered();
+        // Input seen at the start of the period; while idle, nothing else can make the engine sound
+        bool pendingNotes=_qnote->read_avail() > 0;
+        bool pendingCommands=_qcomm->read_avail() > 0;
+        uint64_t messages=_engineMessages.load(std::memory_order_acquire);
+        bool activity=pendingNotes || pendingCommands || messages != _keysEngineMessages || controlsChanged() ||
+                      _sampledRanks.active();
+        if(_idleDetector.idle())
+        {
+            if(!activity && _idleDetector.isEnabled())
+            {
+                for (int i = 0; i < _nplay; i++) memset(_outbuf [i], 0, PERIOD*sizeof(float));
+                // Nothing buffered is audible any more, the engine output can be passed through again
+                _varispeed.reset();
+                _registrationStager.periodRendered();
+                _idleDetector.idlePeriod();
+                return;
             }
+            _idleDetector.wake();
         }
 
+        // Also timed while the governor is off, until the tier is back to full quality
+        bool governing=_budgetGovernor.isEnabled() || _appliedTier != AeolusBudgetGovernor::FULL;
+        auto start=governing ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+        bool profiling=_renderProfiler.isEnabled();
+        if(profiling) _renderProfiler.beginPeriod();
+
+        // Key and rank state only changes through the queues and the rank messages, so without
+        // either, there is nothing to propagate. A queue is only processed when seen non-empty here,
+        // such that no entry can be drained without the keys being updated.
+        bool incremental=_incrementalKeys.load(std::memory_order_relaxed);
+        bool notes=!incremental || pendingNotes;
+        bool commands=!incremental || pendingCommands;
+        if(notes) proc_queue (_qnote);
+        if(profiling) _renderProfiler.endStage(AeolusRenderProfiler::NOTE_QUEUE);
+        if(commands) proc_queue (_qcomm);
+        if(profiling) _renderProfiler.endStage(AeolusRenderProfiler::COMMAND_QUEUE);
+        if(notes || commands || messages != _keysEngineMessages)
+        {
+            _keysEngineMessages=messages;
+            proc_keys1 ();
+            proc_keys2 ();
+        } else {
+            _skippedKeyUpdates.store(_skippedKeyUpdates.load(std::memory_order_relaxed)+1,
+                                     std::memory_order_relaxed);
+        }
+        if(profiling) _renderProfiler.endStage(AeolusRenderProfiler::KEYS);
 
+        // One engine period, or from time to time none or two while the pitch is offset
+        uint64_t sourcePeriods=_varispeed.sourcePeriods();
+        _varispeed.process(_outbuf, _nplay, renderEnginePeriod, this);
+        uint64_t enginePeriods=_varispeed.sourcePeriods()-sourcePeriods;
+        if(profiling)
+        {
+            _renderProfiler.endStage(AeolusRenderProfiler::SYNTH);
+            // Each record is one engine period
+            if(enginePeriods == 1) _renderProfiler.endPeriod();
+        }
+        if(_sampledRanks.rankCount() > 0)
+        {
+            // On top of the engine output, which the engine overwrites
+            float gains[AeolusSampledRanks::maxDivisions]{};
+            for(int d=0; d<_ndivis && d<AeolusSampledRanks::maxDivisions; d++)
+            {
+                gains[d]=getVolumeForDivision(d)*_audiopar [VOLUME]._val;
+            }
+            _sampledRanks.render(gains, _varispeed.ratio(), _outbuf [0], _nplay == 2 ? _outbuf [1] : nullptr);
+        }
+        if(_nplay == 2)
+        {
+            float wet=_appliedTier >= AeolusBudgetGovernor::NO_REVERB ? 0.0f : _convolutionWet.load(std::memory_order_relaxed);
+            _convolutionReverb.process(_outbuf [0], _outbuf [1], wet);
+        }
+        _registrationStager.periodRendered();
+        _idleDetector.rendered(_outbuf, _nplay, PERIOD, activity);
+        if(governing)
+        {
+            auto duration=std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now()-start).count();
+            // The governor expects one engine period per update: while the pitch is offset, the time of
+            // the engine periods rendered is averaged, and scaled to the engine periods rendered per
+            // output period on average, rather than seen as spikes and gaps
+            if(enginePeriods > 0)
+            {
+                _enginePeriodNanoseconds=(uint64_t) duration/enginePeriods;
+            }
+            applyQualityTier(_budgetGovernor.update((uint64_t) (_enginePeriodNanoseconds*_varispeed.ratio())));
+        }
+    }
 
-        //proc_mesg();
-        unsigned long stop=ITC_ctrl::delay ()/1000;
-        unsigned long delta_t=stop-start;
-        if(delta_t>5) {
-            __android_log_print(android_LogPriority::ANDROID_LOG_INFO,
-                                "AeolusSynthesizer",
-                                "fill Audio Buffer long execution time: %d ms",(int)-delta_t);
+    const float *const *AeolusSynthesizer::renderEnginePeriod(void *context) {
+        auto *synth = static_cast<AeolusSynthesizer *>(context);
+        bool sections=synth->_definitionDivisions == synth->_ndivis && !synth->_bform && synth->_nplay == 2;
+        if(sections && synth->_parallelRendering.load(std::memory_order_acquire) &&
+           synth->_parallelWorthwhile.load(std::memory_order_relaxed))
+        {
+            synth->synthesizePeriodSections(true);
+        } else if(sections && (synth->_divisionActivity.isEnabled() ||
+                               synth->_sectionRendering.load(std::memory_order_relaxed))) {
+            synth->synthesizePeriodSections(false);
+        } else {
+            synth->proc_synth(PERIOD);
         }
+        return synth->_outbuf;
+    }
 
+    void AeolusSynthesizer::applyQualityTier(AeolusBudgetGovernor::Tier tier) {
+        if(tier != _appliedTier)
+        {
+            _divisionActivity.limitRelease(tier >= AeolusBudgetGovernor::SHORT_RELEASE ?
+                                           (int) (budget_release_seconds*_fsamp/PERIOD) : -1);
+            if(tier < AeolusBudgetGovernor::NO_TREMULANT && _governorTremulants != 0)
+            {
+                // Only those the model still has on, the player may have turned some off meanwhile
+                unsigned restore=_governorTremulants & _tremulantsActivated.load(std::memory_order_relaxed);
+                for(int d=0; d<_ndivis; d++)
+                {
+                    if(restore & (1u << d)) _divisp [d]->trem_on ();
+                }
+                _governorTremulants=0;
+            }
+            _appliedTier=tier;
+        }
+        if(_appliedTier >= AeolusBudgetGovernor::NO_TREMULANT)
+        {
+            // Checked every period, as the model may turn tremulants on meanwhile. The engine fades
+            // the modulation out at its next zero crossing.
+            for(int d=0; d<_ndivis; d++)
+            {
+                if(tremulantIsOn(d))
+                {
+                    _divisp [d]->trem_off ();
+                    _governorTremulants|=1u << d;
+                }
+            }
+        }
     }
 
-    void AeolusSynthesizer::allocateOutputBuffer() {
-        if((_fsize>0) & (_nplay >0)) {
-            for (int i = 0; i < _nplay; i++) {
-                _outbuf[i] = new float[_fsize];
+    void AeolusSynthesizer::synthesizePeriodSections(bool parallel) {
+        float W [PERIOD];
+        float X [PERIOD];
+        float Y [PERIOD];
+        float Z [PERIOD];
+        float R [PERIOD];
 
+        // With zero frames, proc_synth only applies changes of reverb size and time
+        proc_synth(0);
+
+        memset (W, 0, PERIOD * sizeof (float));
+        memset (X, 0, PERIOD * sizeof (float));
+        memset (Y, 0, PERIOD * sizeof (float));
+        memset (Z, 0, PERIOD * sizeof (float));
+        memset (R, 0, PERIOD * sizeof (float));
+
+        _divisionActivity.beginPeriod();
+        if(parallel)
+        {
+            _renderWorkers->run(processSectionDivisions, this, _nasect);
+        } else {
+            for (int j = 0; j < _nasect; j++) processSectionDivisions(this, j);
+        }
+
+        for (int j = 0; j < _nasect; j++) _asectp [j]->process (_audiopar [VOLUME]._val, W, X, Y, R);
+        processReverb(W, X, Y, Z, R);
+
+        AeolusKernels::active().mixStereo(W, X, Y, _pposit, _outbuf [0], _outbuf [1], PERIOD);
+    }
+
+    void AeolusSynthesizer::processReverb(float *W, float *X, float *Y, float *Z, float *R) {
+        // The convolution reverb replaces the built-in one
+        float target=_appliedTier >= AeolusBudgetGovernor::NO_REVERB || _convolutionReverb.active() ? 0.0f : 1.0f;
+        if(_reverbWet == target)
+        {
+            if(target > 0.0f) _reverb.process (PERIOD, _audiopar [VOLUME]._val, R, W, X, Y, Z);
+            return;
+        }
+        // Fading: the reverb adds its output to W, X and Y, which is scaled by the moving wet gain
+        float dryW [PERIOD];
+        float dryX [PERIOD];
+        float dryY [PERIOD];
+        memcpy (dryW, W, PERIOD * sizeof (float));
+        memcpy (dryX, X, PERIOD * sizeof (float));
+        memcpy (dryY, Y, PERIOD * sizeof (float));
+        _reverb.process (PERIOD, _audiopar [VOLUME]._val, R, W, X, Y, Z);
+        float step=(target > _reverbWet ? 1.0f : -1.0f)/(reverb_fade_periods*PERIOD);
+        const AeolusKernels &kernels=AeolusKernels::active();
+        kernels.crossfade(dryW, W, _reverbWet, step, PERIOD);
+        kernels.crossfade(dryX, X, _reverbWet, step, PERIOD);
+        kernels.crossfade(dryY, Y, _reverbWet, step, PERIOD);
+        _reverbWet=std::min(1.0f, std::max(0.0f, _reverbWet+PERIOD*step));
+    }
+
+    void AeolusSynthesizer::processSectionDivisions(void *context, int section) {
+        auto *synth = static_cast<AeolusSynthesizer *>(context);
+        // Also on the render workers, which have their own floating point mode
+        AeolusKernels::FlushDenormals flush(synth->_flushDenormals.load(std::memory_order_relaxed));
+        for (int j = 0; j < synth->_ndivis; j++)
+        {
+            if (synth->_divisionSection [j] != section) continue;
+            if (!synth->_divisionActivity.shouldProcess(j, synth->getVolumeForDivision(j) == 0.0f)) continue;
+            uint64_t start=AeolusRenderProfiler::readCycleCounter();
+            synth->_divisp [j]->process ();
+            synth->_divisionActivity.recordProcessed(j, AeolusRenderProfiler::readCycleCounter()-start);
+        }
+    }
+
+    int AeolusSynthesizer::readDivisionSections() {
+        std::string path = std::string(_stopsPath) + "/" + instrument_directory + "/definition";
+        std::ifstream definition(path);
+        if(!definition)
+        {
+            aeolusLog(LogLevel::WARN, "AeolusSynthesizer", "Cannot read %s", path.c_str());
+            return -1;
+        }
+        // Division lines read "/divis/new <label> <audio section, from 1> <pressure>"
+        int n_divisions=0;
+        std::string line;
+        while(std::getline(definition, line))
+        {
+            std::istringstream words(line);
+            std::string command, label;
+            int section=0;
+            if(!(words >> command) || command != "/divis/new") continue;
+            if(!(words >> label >> section) || section < 1 || section > NASECT || n_divisions >= NDIVIS) return -1;
+            _divisionSection[n_divisions++]=section-1;
+        }
+        return n_divisions;
+    }
+
+    void AeolusSynthesizer::setParallelRendering(bool enabled, int workers) {
+        if(enabled)
+        {
+            if(_renderWorkers == nullptr)
+            {
+                _renderWorkers=std::make_unique<AeolusRenderWorkerPool>(workers);
             }
+            _parallelRendering.store(true, std::memory_order_release);
+        } else {
+            _parallelRendering.store(false, std::memory_order_release);
+        }
+    }
+
+    bool AeolusSynthesizer::isParallelRendering() {
+        return _parallelRendering.load();
+    }
+
+    uint64_t AeolusSynthesizer::getLateParallelPeriods() {
+        return _renderWorkers != nullptr ? _renderWorkers->lateRuns() : 0;
+    }
+
+    void AeolusSynthesizer::setIncrementalKeyUpdate(bool enabled) {
+        _incrementalKeys.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool AeolusSynthesizer::isIncrementalKeyUpdate() {
+        return _incrementalKeys.load(std::memory_order_relaxed);
+    }
+
+    uint64_t AeolusSynthesizer::getSkippedKeyUpdates() {
+        return _skippedKeyUpdates.load(std::memory_order_relaxed);
+    }
+
+    void AeolusSynthesizer::setDivisionCulling(bool enabled) {
+        _divisionActivity.setEnabled(enabled);
+    }
+
+    bool AeolusSynthesizer::isDivisionCulling() {
+        return _divisionActivity.isEnabled();
+    }
+
+    void AeolusSynthesizer::setSectionRendering(bool enabled) {
+        _sectionRendering.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool AeolusSynthesizer::isSectionRendering() {
+        return _sectionRendering.load(std::memory_order_relaxed);
+    }
+
+    AeolusDivisionActivity::DivisionStatistics AeolusSynthesizer::getDivisionActivity(int division_id) {
+        return _divisionActivity.statistics(division_id);
+    }
+
+    void AeolusSynthesizer::resetDivisionActivity() {
+        _divisionActivity.requestReset();
+    }
+
+    std::string AeolusSynthesizer::getDivisionActivitySummary() {
+        double ticksPerSecond=AeolusRenderProfiler::counterTicksPerSecond();
+        double ticksPerPeriod=ticksPerSecond*PERIOD/_fsamp;
+        char line[256];
+        std::string summary;
+        for(int d=0; d<get_n_divisions() && d<AeolusDivisionActivity::maxDivisions; d++)
+        {
+            AeolusDivisionActivity::DivisionStatistics s=_divisionActivity.statistics(d);
+            uint64_t periods=s.processedPeriods+s.culledPeriods;
+            double mean=s.processedPeriods > 0 ? (double) s.ticks/(double) s.processedPeriods : 0.0;
+            snprintf(line, sizeof(line),
+                     "%-12s %s, culled %5.1f%% of %llu periods, %.2f us per processed period (%.2f%%), worst %.2f us\n",
+                     getLabelForDivision(d), s.culled ? "idle  " : "active",
+                     periods > 0 ? 100.0*(double) s.culledPeriods/(double) periods : 0.0,
+                     (unsigned long long) periods,
+                     1e6*mean/ticksPerSecond, 100.0*mean/ticksPerPeriod,
+                     1e6*(double) s.worstTicks/ticksPerSecond);
+            summary += line;
+        }
+        return summary;
+    }
+
+    void AeolusSynthesizer::refreshDivisionActivity() {
+        unsigned tremulants=0;
+        unsigned coupled=0;
+        for(int d=0; d<get_n_divisions(); d++)
+        {
+            unsigned long stops=getStopActivationBitmask(d);
+            if(d < AeolusRenderProfiler::maxDivisions) _appliedStopMasks[d]=stops;
+            _divisionActivity.setStopsActive(d, stops != 0 ||
+                                                _directRanks[d].load(std::memory_order_relaxed) != 0);
+            // One rank per stop: mixtures of several ranks in one stop are rare
+            _polyphonyLimiter.setPipesPerKey(d, __builtin_popcountl(stops));
+            _sampledRanks.setStops(d, stops);
+            if(d < 32 && tremulantIsActivated(d)) tremulants|=1u << d;
+            for(int c=0; c<get_n_couplers_for_division(d); c++)
+            {
+                // The source keyboard of a coupler is not known here, assume it reaches the
+                // division from every note
+                if(d < 32 && getCouplerActivated(d, c)) coupled|=1u << d;
+            }
+        }
+        _tremulantsActivated.store(tremulants, std::memory_order_relaxed);
+        _polyphonyLimiter.setCoupledDivisions(coupled);
+        _sampledRanks.setCoupledDivisions(coupled);
+        publishAppliedRegistration();
+    }
+
+    void AeolusSynthesizer::setBudgetGovernor(bool enabled) {
+        _budgetGovernor.setEnabled(enabled);
+    }
+
+    bool AeolusSynthesizer::isBudgetGovernor() {
+        return _budgetGovernor.isEnabled();
+    }
+
+    void AeolusSynthesizer::setBudgetThresholds(float degradeLoad, float recoverLoad) {
+        _budgetGovernor.setThresholds(degradeLoad, recoverLoad);
+    }
+
+    void AeolusSynthesizer::setQualityTierAllowed(int tier, bool allowed) {
+        _budgetGovernor.setTierAllowed((AeolusBudgetGovernor::Tier) tier, allowed);
+    }
 
+    int AeolusSynthesizer::getQualityTier() {
+        return _budgetGovernor.tier();
+    }
+
+    AeolusBudgetGovernor::Statistics AeolusSynthesizer::getBudgetGovernorStatistics() {
+        return _budgetGovernor.statistics();
+    }
+
+    std::string AeolusSynthesizer::getBudgetGovernorSummary() {
+        AeolusBudgetGovernor::Statistics s=_budgetGovernor.statistics();
+        char line[256];
+        snprintf(line, sizeof(line), "Tier %s, load %.1f%%, lowest tier %s, %llu steps down, %llu steps up\n",
+                 AeolusBudgetGovernor::tierName(s.tier), 100.0*s.load, AeolusBudgetGovernor::tierName(s.worstTier),
+                 (unsigned long long) s.degradations, (unsigned long long) s.recoveries);
+        std::string summary=line;
+        if(s.lastTransitionPeriod > 0)
+        {
+            snprintf(line, sizeof(line), "Last step from %s to %s at %.2f s\n",
+                     AeolusBudgetGovernor::tierName(s.lastFrom), AeolusBudgetGovernor::tierName(s.lastTo),
+                     (double) s.lastTransitionPeriod*PERIOD/_fsamp);
+            summary+=line;
         }
+        for(int t=0; t<AeolusBudgetGovernor::n_tiers; t++)
+        {
+            snprintf(line, sizeof(line), "%-14s %.2f s\n", AeolusBudgetGovernor::tierName((AeolusBudgetGovernor::Tier) t),
+                     (double) s.periods[t]*PERIOD/_fsamp);
+            summary+=line;
+        }
+        return summary;
+    }
+
+    void AeolusSynthesizer::onStopsUpdated(void *context) {
+        auto *synth=static_cast<AeolusSynthesizer *>(context);
+        // Also notified when the instrument is ready, before the interface leaves the initialization phase
+        if(synth->_ui->isInitializing()) synth->_memoryWarmer->recordLoadedMappings();
+        synth->refreshDivisionActivity();
+    }
+
+    void AeolusSynthesizer::setStopWarmUp(bool enabled) {
+        _memoryWarmer->setEnabled(enabled);
+    }
+
+    bool AeolusSynthesizer::isStopWarmUp() {
+        return _memoryWarmer->isEnabled();
+    }
+
+    void AeolusSynthesizer::setWavetableLocking(bool locking) {
+        _memoryWarmer->setLocking(locking);
+    }
+
+    AeolusMemoryWarmer::Statistics AeolusSynthesizer::getStopWarmUpStatistics() {
+        return _memoryWarmer->statistics();
+    }
+
+    std::string AeolusSynthesizer::getStopWarmUpSummary() {
+        AeolusMemoryWarmer::Statistics s=_memoryWarmer->statistics();
+        char line[256];
+        snprintf(line, sizeof(line),
+                 "%.1f MB instrument memory, %llu warm-ups (%llu out of time), %llu of %llu pages read back in "
+                 "(%llu minor, %llu major faults), last %.2f ms, %.1f MB locked, %llu lock failures\n",
+                 (double) s.instrumentBytes/(1024.0*1024.0), (unsigned long long) s.warmUps,
+                 (unsigned long long) s.truncatedWarmUps, (unsigned long long) s.pagesFaultedIn,
+                 (unsigned long long) s.pagesScanned, (unsigned long long) s.minorFaults,
+                 (unsigned long long) s.majorFaults, 1e-3*(double) s.lastWarmUpMicroseconds,
+                 (double) s.bytesLocked/(1024.0*1024.0), (unsigned long long) s.lockFailures);
+        return line;
+    }
+
+    void AeolusSynthesizer::setRegistrationChangesPerPeriod(int changes) {
+        _registrationStager.setChangesPerPeriod(changes);
+    }
+
+    int AeolusSynthesizer::getRegistrationChangesPerPeriod() {
+        return _registrationStager.changesPerPeriod();
+    }
+
+    AeolusRegistrationStager::Statistics AeolusSynthesizer::getRegistrationStagingStatistics() {
+        return _registrationStager.statistics();
+    }
+
+    void AeolusSynthesizer::deliverStopChange(void *context, const AeolusMemoryWarmer::StopChange &change) {
+        auto *synth=static_cast<AeolusSynthesizer *>(context);
+        int theStopIndex = synth->getIfelmIndexForStop(change.division, change.stop);
+        if(theStopIndex<0)
+        {
+            return;
+        }
+        // Only actual changes count against the limit per period, setStopActivationBitmask also
+        // requests the stops that are already in the right state
+        if(synth->getStopActivated(change.division, change.stop) != change.activate)
+        {
+            synth->_registrationStager.acquire();
+        }
+        synth->send_event (TO_MODEL, new M_ifc_ifelm ( change.activate ? MT_IFC_ELSET : MT_IFC_ELCLR,
+                                                      change.division, theStopIndex));
     }
 
     void AeolusSynthesizer::noteon(int chan, int key, int vel) {
@@ -241,7 +849,15 @@ namespace Aeolussynthesizer {
         E.note.channel=chan;
         E.note.velocity=vel;
 
-
+        // Steal first, such that the engine never sees more than the ceiling
+        if(vel > 0)
+        {
+            _polyphonyLimiter.noteOn(chan, key, get_midi_map_entry(chan) & 15);
+            _sampledRanks.noteOn(key, get_midi_map_entry(chan) & 15);
+        } else {
+            _polyphonyLimiter.noteOff(chan, key);
+            _sampledRanks.noteOff(key, get_midi_map_entry(chan) & 15);
+        }
         _midiInterface->proc_midi_event(E);
     }
 
@@ -254,16 +870,262 @@ namespace Aeolussynthesizer {
 
 
 
-
+        _polyphonyLimiter.noteOff(chan, key);
+        _sampledRanks.noteOff(key, get_midi_map_entry(chan) & 15);
         _midiInterface->proc_midi_event(E);
 
     }
 
+    void AeolusSynthesizer::releaseStolenNote(void *context, int channel, int key) {
+        Imidi::MidiEvent E{};
+        E.type=SND_SEQ_EVENT_NOTEOFF;
+        E.note.note=key;
+        E.note.channel=channel;
+        E.note.velocity=0;
+        static_cast<AeolusSynthesizer *>(context)->_midiInterface->proc_midi_event(E);
+    }
+
+    void AeolusSynthesizer::setPolyphonyCeiling(int pipes) {
+        _polyphonyLimiter.setCeiling(pipes);
+    }
+
+    int AeolusSynthesizer::getPolyphonyCeiling() {
+        return _polyphonyLimiter.ceiling();
+    }
+
+    void AeolusSynthesizer::setDivisionPolyphonyCeiling(int division_id, int pipes) {
+        _polyphonyLimiter.setDivisionCeiling(division_id, pipes);
+    }
+
+    uint64_t AeolusSynthesizer::getPipeSteals() {
+        return _polyphonyLimiter.steals();
+    }
+
+    uint64_t AeolusSynthesizer::getReleaseSteals() {
+        return _polyphonyLimiter.releaseSteals();
+    }
+
+    int AeolusSynthesizer::getEstimatedSoundingPipes() {
+        return _polyphonyLimiter.soundingPipes();
+    }
+
+    bool AeolusSynthesizer::controlsChanged() {
+        bool changed=false;
+        for(int d=0; d<_ndivis; d++)
+        {
+            float gain=getVolumeForDivision(d);
+            if(gain != _renderedGains[d])
+            {
+                _renderedGains[d]=gain;
+                changed=true;
+            }
+            // The tremulant modulation keeps its phase only while rendered
+            if(tremulantIsOn(d)) changed=true;
+        }
+        return changed;
+    }
+
+    bool AeolusSynthesizer::setConvolutionReverb(const std::string &name) {
+        if(name.empty())
+        {
+            _convolutionReverb.setImpulseResponse(nullptr, 0, 1, _fsamp);
+            _impulseResponse.clear();
+            return true;
+        }
+        std::string file=name;
+        if(file.size() < 4 || strcasecmp(file.c_str()+file.size()-4, ".wav") != 0) file+=".wav";
+        std::string path=std::string(_stopsPath) + "/" + impulse_directory + "/" + file;
+        WavFileData wav;
+        std::string error;
+        if(!wav.read(path, error))
+        {
+            aeolusLog(LogLevel::WARN, "AeolusSynthesizer", "%s", error.c_str());
+            _convolutionReverb.setImpulseResponse(nullptr, 0, 1, _fsamp);
+            _impulseResponse.clear();
+            return false;
+        }
+        _convolutionReverb.setImpulseResponse(wav.samples.data(), (int) wav.frames(), wav.channels, wav.samplingRate);
+        _impulseResponse=file;
+        return true;
+    }
+
+    std::vector<std::string> AeolusSynthesizer::getImpulseResponses() {
+        std::vector<std::string> names;
+        std::string path=std::string(_stopsPath) + "/" + impulse_directory;
+        DIR *directory=opendir(path.c_str());
+        if(directory == nullptr) return names;
+        while(dirent *entry=readdir(directory))
+        {
+            size_t length=strlen(entry->d_name);
+            if(length > 4 && strcasecmp(entry->d_name+length-4, ".wav") == 0) names.emplace_back(entry->d_name);
+        }
+        closedir(directory);
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+
+    void AeolusSynthesizer::setConvolutionReverbWet(float wet) {
+        _convolutionWet.store(wet < 0.0f ? 0.0f : wet, std::memory_order_relaxed);
+    }
+
+    float AeolusSynthesizer::getConvolutionReverbWet() {
+        return _convolutionWet.load(std::memory_order_relaxed);
+    }
+
+    void AeolusSynthesizer::setConvolutionTailInBackground(bool background) {
+        _convolutionReverb.setTailInBackground(background);
+    }
+
+    AeolusConvolutionReverb::Statistics AeolusSynthesizer::getConvolutionReverbStatistics() {
+        return _convolutionReverb.statistics();
+    }
+
+    std::string AeolusSynthesizer::getConvolutionReverbSummary() {
+        AeolusConvolutionReverb::Statistics s=_convolutionReverb.statistics();
+        if(s.impulseFrames == 0) return "Convolution reverb off\n";
+        double audioSeconds=(double) s.periods*PERIOD/_fsamp;
+        double perSecond=audioSeconds > 0 ? 1e-6*(s.headNanoseconds+s.tailNanoseconds)/audioSeconds : 0.0;
+        char line[512];
+        snprintf(line, sizeof(line), "%s, %.2f s, %s; %.2f ms per second of audio (%.2f%% CPU), tail %s, "
+                                     "%llu of %llu tail blocks late, worst tail block %.1f us of %.1f us\n",
+                 _impulseResponse.c_str(), (double) s.impulseFrames/_fsamp, s.impulseChannels == 1 ? "mono" : "stereo",
+                 perSecond, perSecond/10.0, s.tailInBackground ? "in background" : "on the audio thread",
+                 (unsigned long long) s.lateTailBlocks, (unsigned long long) s.tailBlocks,
+                 1e-3*s.worstTailNanoseconds, 1e6*convolution_tail_block_frames/_fsamp);
+        return line;
+    }
+
+    AeolusSampledRanks::Statistics AeolusSynthesizer::getSampledRankStatistics() {
+        return _sampledRanks.statistics();
+    }
+
+    std::string AeolusSynthesizer::getSampledRankSummary() {
+        AeolusSampledRanks::Statistics s=_sampledRanks.statistics();
+        if(s.ranks == 0) return "No recorded ranks\n";
+        char line[512];
+        snprintf(line, sizeof(line), "%d recorded ranks, %d recordings, %.1f MB mapped, %.1f MB locked%s "
+                                     "(%llu refused); %d voices (peak %d), %llu pipes started, %llu dropped; "
+                                     "%llu pages streamed, %llu underruns, %llu releases without recording\n",
+                 s.ranks, s.recordings, s.bytesMapped/1048576.0, s.bytesLocked/1048576.0,
+                 s.attacksResident ? "" : " so far", (unsigned long long) s.lockFailures, s.voices, s.peakVoices,
+                 (unsigned long long) s.notesStarted, (unsigned long long) s.notesDropped,
+                 (unsigned long long) s.pagesStreamed, (unsigned long long) s.underruns,
+                 (unsigned long long) s.releaseUnderruns);
+        std::string summary=line;
+        for(int r=0; r<_sampledRanks.rankCount(); r++)
+        {
+            summary+="  "+_sampledRanks.rankSummary(r)+"\n";
+        }
+        return summary;
+    }
+
+    void AeolusSynthesizer::setSampledRankStreamingInBackground(bool background) {
+        _sampledRanks.setStreamingInBackground(background);
+    }
+
+    void AeolusSynthesizer::setFineTune(float cents) {
+        cents=std::min((float) pitch_offset_max_cents, std::max((float) -pitch_offset_max_cents, cents));
+        _fineTuneCents.store(cents, std::memory_order_relaxed);
+        updatePitch();
+    }
+
+    float AeolusSynthesizer::getFineTune() {
+        return _fineTuneCents.load(std::memory_order_relaxed);
+    }
+
+    void AeolusSynthesizer::pitchBend(int chan, int value) {
+        if(chan != _pitchBendChannel.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+        value=std::min(16383, std::max(0, value));
+        _pitchBend.store((value-8192)/8192.0f, std::memory_order_relaxed);
+        updatePitch();
+    }
+
+    void AeolusSynthesizer::setPitchBendChannel(int chan) {
+        chan=std::min(15, std::max(0, chan));
+        if(chan != _pitchBendChannel.exchange(chan, std::memory_order_relaxed))
+        {
+            _pitchBend.store(0.0f, std::memory_order_relaxed);
+            updatePitch();
+        }
+    }
+
+    int AeolusSynthesizer::getPitchBendChannel() {
+        return _pitchBendChannel.load(std::memory_order_relaxed);
+    }
+
+    void AeolusSynthesizer::setPitchBendRange(float cents) {
+        cents=std::min((float) pitch_offset_max_cents, std::max(0.0f, cents));
+        _pitchBendRange.store(cents, std::memory_order_relaxed);
+        updatePitch();
+    }
+
+    float AeolusSynthesizer::getPitchBendRange() {
+        return _pitchBendRange.load(std::memory_order_relaxed);
+    }
+
+    float AeolusSynthesizer::getPitchOffset() {
+        return (float) (1200.0*log2(_varispeed.ratio()));
+    }
+
+    bool AeolusSynthesizer::isPitchOffsetLimited() {
+        return _pitchOffsetLimited.load(std::memory_order_relaxed);
+    }
+
+    void AeolusSynthesizer::updatePitch() {
+        float cents=_fineTuneCents.load(std::memory_order_relaxed)+
+                    _pitchBend.load(std::memory_order_relaxed)*_pitchBendRange.load(std::memory_order_relaxed);
+        bool limited=fabsf(cents) > pitch_offset_max_cents;
+        if(limited)
+        {
+            cents=cents > 0.0f ? pitch_offset_max_cents : -pitch_offset_max_cents;
+        }
+        if(limited != _pitchOffsetLimited.exchange(limited, std::memory_order_relaxed) && limited)
+        {
+            aeolusLog(LogLevel::WARN, "AeolusSynthesizer", "Fine tuning and pitch bend limited to %d cents",
+                      pitch_offset_max_cents);
+        }
+        _varispeed.setRatio(pow(2.0, cents/1200.0));
+    }
+
+    void AeolusSynthesizer::setFlushDenormals(bool enabled) {
+        _flushDenormals.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool AeolusSynthesizer::isFlushDenormals() {
+        return _flushDenormals.load(std::memory_order_relaxed);
+    }
+
+    void AeolusSynthesizer::setIdleDetection(bool enabled) {
+        _idleDetector.setEnabled(enabled);
+    }
+
+    bool AeolusSynthesizer::isIdleDetection() {
+        return _idleDetector.isEnabled();
+    }
+
+    AeolusIdleDetector::Statistics AeolusSynthesizer::getIdleStatistics() {
+        return _idleDetector.statistics();
+    }
+
+    std::string AeolusSynthesizer::getIdleSummary() {
+        AeolusIdleDetector::Statistics s=_idleDetector.statistics();
+        uint64_t total=s.renderedPeriods+s.idlePeriods;
+        char line[256];
+        snprintf(line, sizeof(line), "%s, %llu of %llu periods idle (%.1f%%, %.2f s), %llu wake ups\n",
+                 s.idle ? "Idle" : "Rendering", (unsigned long long) s.idlePeriods, (unsigned long long) total,
+                 total > 0 ? 100.0*s.idlePeriods/total : 0.0, (double) s.idlePeriods*PERIOD/_fsamp,
+                 (unsigned long long) s.wakeUps);
+        return line;
+    }
+
     void AeolusSynthesizer::activateRank(int division_id, int rank_id) {
         int bit_mask=255;
         if( division_id >= _ndivis)
         {
-            __android_log_print(android_LogPriority::ANDROID_LOG_WARN,
+            aeolusLog(LogLevel::WARN,
                                 "AeolusSynthesizer", "Division %d does not exist",division_id);
             return;
         }
@@ -276,7 +1138,9 @@ namespace Aeolussynthesizer {
 
            _qnote->write_commit (1);
 
-
+           // The model does not know of the rank, keep the division from being culled here
+           _directRanks[division_id].fetch_or(1ull << (rank_id & 63), std::memory_order_relaxed);
+           _divisionActivity.setStopsActive(division_id, true);
 
         }
 
@@ -287,7 +1151,7 @@ namespace Aeolussynthesizer {
         int bit_mask=0;
         if( division_id >= _ndivis)
         {
-            __android_log_print(android_LogPriority::ANDROID_LOG_WARN,
+            aeolusLog(LogLevel::WARN,
                                 "AeolusSynthesizer", "Division %d does not exist",division_id);
             return;
         }
@@ -300,6 +1164,14 @@ namespace Aeolussynthesizer {
 
             _qnote->write_commit (1);
 
+            // Culling resumes once neither direct ranks nor stops are left
+            uint64_t rank=1ull << (rank_id & 63);
+            uint64_t remaining=_directRanks[division_id].fetch_and(~rank, std::memory_order_relaxed) & ~rank;
+            if(remaining == 0 && getStopActivationBitmask(division_id) == 0)
+            {
+                _divisionActivity.setStopsActive(division_id, false);
+            }
+
 
 
         }
@@ -309,14 +1181,31 @@ namespace Aeolussynthesizer {
         _running=true;
         while(_running)
         {
+            // The rank messages counted so far are queued, and proc_mesg handles all queued messages
+            uint64_t queued=_rankMessagesQueued.load(std::memory_order_acquire);
             proc_mesg ();
+            if(queued != _engineMessages.load(std::memory_order_relaxed))
+            {
+                _engineMessages.store(queued, std::memory_order_release);
+            }
+        }
+    }
+
+    int AeolusSynthesizer::put_event(unsigned int evid, ITC_mesg *M) {
+        unsigned long type=M != nullptr ? M->type() : 0;
+        int result=AeolusAudio::put_event(evid, M);
+        // Counted after queuing, such that thr_main never takes a count for a message it has not seen
+        if(type == MT_NEW_DIVIS || type == MT_LOAD_RANK || type == MT_CALC_RANK)
+        {
+            _rankMessagesQueued.fetch_add(1, std::memory_order_release);
         }
+        return result;
     }
 
     bool AeolusSynthesizer::isInitializing() {
         if (_ui == nullptr)
         {
-            __android_log_print(android_LogPriority::ANDROID_LOG_WARN,
+            aeolusLog(LogLevel::WARN,
                                 "AeolusSynthesizer::isInitializing", "UI not initialized yet");
             return true;
         }
@@ -371,6 +1260,10 @@ namespace Aeolussynthesizer {
     }
 
     void AeolusSynthesizer::activateStop(int division_id, int stop_id) {
+        requestStopState(division_id, stop_id, true);
+    }
+
+    void AeolusSynthesizer::requestStopState(int division_id, int stop_id, bool activate) {
         int theStopIndex = getIfelmIndexForStop(division_id, stop_id);
 
 
@@ -380,9 +1273,16 @@ namespace Aeolussynthesizer {
         }
 
 
-        send_event (TO_MODEL, new M_ifc_ifelm ( MT_IFC_ELSET, division_id, theStopIndex));
-
-
+        if(_memoryWarmer != nullptr)
+        {
+            // Delivered in order by the warm-up thread, after warm-up and staging as configured
+            _memoryWarmer->submit({division_id, stop_id, activate});
+        } else {
+            send_event (TO_MODEL, new M_ifc_ifelm ( activate ? MT_IFC_ELSET : MT_IFC_ELCLR, division_id, theStopIndex));
+        }
+        // Wake the division up right away rather than when the user interface hears of it, deactivation
+        // takes effect through the user interface notification once the model has applied it
+        if(activate) _divisionActivity.setStopsActive(division_id, true);
 
     }
 
@@ -454,19 +1354,7 @@ namespace Aeolussynthesizer {
     }
 
     void AeolusSynthesizer::deactivateStop(int division_id, int stop_id) {
-        int theStopIndex = getIfelmIndexForStop(division_id, stop_id);
-
-
-        if(theStopIndex<0)
-        {
-            return;
-        }
-
-
-        send_event (TO_MODEL, new M_ifc_ifelm ( MT_IFC_ELCLR, division_id, theStopIndex));
-
-
-
+        requestStopState(division_id, stop_id, false);
     }
 
 
@@ -515,6 +1403,73 @@ namespace Aeolussynthesizer {
 
     }
 
+    bool AeolusSynthesizer::tremulantIsActivated(int division_id) {
+        int theTremulantIndex = getIfelmIndexForTremulant(division_id);
+        if(theTremulantIndex<0)
+        {
+            return false;
+        }
+        Group* division_group = model->getGroupWithLabel(getLabelForDivision(division_id));
+        if(division_group==nullptr)
+        {
+            return false;
+        }
+        return division_group->_ifelms[theTremulantIndex]._state > 0;
+    }
+
+    int AeolusSynthesizer::get_n_couplers_for_division(int division_index) {
+        Group* division_group = model->getGroupWithLabel(getLabelForDivision(division_index));
+        if(division_group==nullptr)
+        {
+            return 0;
+        }
+        int n_couplers=0;
+        for(int i=0; i<division_group->_nifelm; i++)
+        {
+            if(division_group->_ifelms[i]._type==Ifelm::COUPLER) n_couplers++;
+        }
+        return n_couplers;
+    }
+
+    void AeolusSynthesizer::activateCoupler(int division_id, int coupler_id) {
+        int theCouplerIndex = getAbsoluteInterfaceElementIndex(division_id, coupler_id, Ifelm::COUPLER);
+        if(theCouplerIndex<0)
+        {
+            return;
+        }
+        send_event (TO_MODEL, new M_ifc_ifelm ( MT_IFC_ELSET, division_id, theCouplerIndex));
+    }
+
+    void AeolusSynthesizer::deactivateCoupler(int division_id, int coupler_id) {
+        int theCouplerIndex = getAbsoluteInterfaceElementIndex(division_id, coupler_id, Ifelm::COUPLER);
+        if(theCouplerIndex<0)
+        {
+            return;
+        }
+        send_event (TO_MODEL, new M_ifc_ifelm ( MT_IFC_ELCLR, division_id, theCouplerIndex));
+    }
+
+    bool AeolusSynthesizer::getCouplerActivated(int division_id, int coupler_id) {
+        int theCouplerIndex = getAbsoluteInterfaceElementIndex(division_id, coupler_id, Ifelm::COUPLER);
+        if(theCouplerIndex<0)
+        {
+            return false;
+        }
+        Group* division_group = model->getGroupWithLabel(getLabelForDivision(division_id));
+        if(division_group==nullptr)
+        {
+            return false;
+        }
+        return division_group->_ifelms[theCouplerIndex]._state > 0;
+    }
+
+    void AeolusSynthesizer::setReverbAmount(float amount) {
+        for(int j=0; j<_nasect; j++)
+        {
+            send_event (TO_MODEL, new M_ifc_aupar (-1, j, Asection::REVERB, amount));
+        }
+    }
+
     int AeolusSynthesizer::get_n_tunings() {
         return model->get_n_tunings();
     }
@@ -553,9 +1508,9 @@ namespace Aeolussynthesizer {
         for(int i=0; i<division_group->_nifelm; i++)
         {
             if(division_group->_ifelms[i]._type==Ifelm::DIVRANK){
-                if(division_group->_ifelms[i]._state>0)
+                if(division_group->_ifelms[i]._state>0 && n_stops < stop_mask_bits)
                 {
-                    bitmask |= (1 << n_stops);
+                    bitmask |= (1ul << n_stops);
                 }
                 n_stops++;
             }
@@ -573,12 +1528,8 @@ namespace Aeolussynthesizer {
         for(int i=0; i<division_group->_nifelm; i++)
         {
             if(division_group->_ifelms[i]._type==Ifelm::DIVRANK){
-                if((stop_states_for_division & (1 << n_stops)) !=0)
-                {
-                    activateStop(division_index,n_stops);
-                } else {
-                    deactivateStop(division_index,n_stops);
-                }
+                if(n_stops >= stop_mask_bits) break;
+                requestStopState(division_index,n_stops,(stop_states_for_division & (1ul << n_stops)) !=0);
                 n_stops++;
             }
         }
@@ -586,6 +1537,103 @@ namespace Aeolussynthesizer {
 
 
 
+    AeolusCallbackStats::Snapshot AeolusSynthesizer::getCallbackStatistics() const {
+        return _callbackStats.snapshot();
+    }
+
+    void AeolusSynthesizer::resetCallbackStatistics() {
+        _callbackStats.requestReset();
+    }
+
+    void AeolusSynthesizer::setRenderProfiling(bool enabled) {
+        // The registration is published by the model's stop notifications, whether recording or not
+        _renderProfiler.setEnabled(enabled);
+    }
+
+    bool AeolusSynthesizer::isRenderProfiling() {
+        return _renderProfiler.isEnabled();
+    }
+
+    void AeolusSynthesizer::publishAppliedRegistration() {
+        int n_divisions=get_n_divisions();
+        if(n_divisions > AeolusRenderProfiler::maxDivisions)
+        {
+            n_divisions=AeolusRenderProfiler::maxDivisions;
+        }
+        _renderProfiler.setRegistration(_appliedStopMasks, n_divisions);
+
+        // Parallel rendering pays off with stops active in at least two audio sections
+        int active_stops=0;
+        unsigned int active_sections=0;
+        for(int i=0; i<n_divisions && i<_definitionDivisions; i++)
+        {
+            int n=__builtin_popcountll(_appliedStopMasks[i]);
+            active_stops+=n;
+            if(n>0) active_sections|=1u<<_divisionSection[i];
+        }
+        _parallelWorthwhile.store(active_stops >= parallel_min_stops && __builtin_popcount(active_sections) >= 2);
+    }
+
+    std::string AeolusSynthesizer::getRenderProfileSummary() {
+        std::vector<AeolusRenderProfiler::RegistrationProfile> registrations;
+        std::vector<AeolusRenderProfiler::StopCost> stopCosts;
+        uint64_t periods=_renderProfiler.summarize(registrations, stopCosts);
+
+        double ticksPerSecond=AeolusRenderProfiler::counterTicksPerSecond();
+        double ticksPerPeriod=ticksPerSecond*PERIOD/_fsamp;
+        char line[256];
+        std::string summary;
+
+        snprintf(line, sizeof(line),
+                 "Render profile: %llu periods of %d frames, %.0f counter ticks per period\n",
+                 (unsigned long long) periods, PERIOD, ticksPerPeriod);
+        summary += line;
+
+        for(const auto& r: registrations)
+        {
+            snprintf(line, sizeof(line),
+                     "Registration (%llu periods): synth %.0f ticks (%.1f%%, max %.1f%%), keys %.0f, note queue %.0f, command queue %.0f\n",
+                     (unsigned long long) r.periods,
+                     r.meanTicks[AeolusRenderProfiler::SYNTH],
+                     100.0*r.meanTicks[AeolusRenderProfiler::SYNTH]/ticksPerPeriod,
+                     100.0*r.maxSynthTicks/ticksPerPeriod,
+                     r.meanTicks[AeolusRenderProfiler::KEYS],
+                     r.meanTicks[AeolusRenderProfiler::NOTE_QUEUE],
+                     r.meanTicks[AeolusRenderProfiler::COMMAND_QUEUE]);
+            summary += line;
+            for(int d=0; d<r.ndivisions; d++)
+            {
+                if(r.stopMasks[d]==0) continue;
+                summary += "    ";
+                summary += getLabelForDivision(d);
+                summary += ":";
+                for(int i=0; i<64; i++)
+                {
+                    if((r.stopMasks[d] >> i) & 1)
+                    {
+                        summary += " [";
+                        summary += getLabelForStop(d, i);
+                        summary += "]";
+                    }
+                }
+                summary += "\n";
+            }
+        }
+
+        if(!stopCosts.empty())
+        {
+            summary += "Stop cost, from registrations differing by one stop:\n";
+        }
+        for(const auto& c: stopCosts)
+        {
+            snprintf(line, sizeof(line), "    %s / %s: %+.0f ticks (%+.1f%%), %d comparison(s)\n",
+                     getLabelForDivision(c.division), getLabelForStop(c.division, c.stop),
+                     c.meanTicks, 100.0*c.meanTicks/ticksPerPeriod, c.comparisons);
+            summary += line;
+        }
+        return summary;
+    }
+
 
 }
 
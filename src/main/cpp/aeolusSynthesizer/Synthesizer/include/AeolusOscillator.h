@@ -29,7 +29,6 @@
 #include "../../../aeolus/source/slave.h"
 #include "../../../aeolus/source/iface.h"
 #include "../../AeolusSignalProcessing/AeolusAudioProcessingDelegate.h"
-#include <android/log.h>
 
 namespace Aeolussynthesizer {
     /**
@@ -72,9 +71,9 @@ namespace Aeolussynthesizer {
        * syntheszier frame work with the ranks and audio effects is invoked to provide the necessary audio data.
        *
        * @param audioData Pointer to the start of the audio data buffer, preallocated by oboe, of length
-       *                  framesCount*channelCount and with an intended blockwise structure float[channelCount][framesCount]
+       *                  framesCount*channelCount and with interleaved structure float[framesCount][channelCount]
        * @param framesCount Number of samples to be supplied in each channel
-       * @param channelCount Number of channels, e.g., number of blocks. Mono=1, Stereo=2
+       * @param channelCount Number of channels per frame. Mono=1, Stereo=2
        */
         void onAudioReady(float* audioData, int32_t framesCount, oboe::ChannelCount channelCount) override;
 
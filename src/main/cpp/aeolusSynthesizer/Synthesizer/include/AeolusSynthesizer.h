@@ -23,15 +23,101 @@
 #ifndef MIDI_SYNTH_AEOLUSSYNTHESIZER_H
 #define MIDI_SYNTH_AEOLUSSYNTHESIZER_H
 
+#include <chrono>
+#include <string>
 #include <vector>
 #include "../../../SynthesizerBase/include/Synthesizer.h"
 #include "AeolusOscillator.h"
 #include "../../../aeolus/source/iface.h"
 #include "../../../aeolus/source/audio.h"
 #include "../../../aeolus/source/imidi.h"
+#include "../../AeolusSignalProcessing/AeolusPeriodBuffer.h"
+#include "../../AeolusSignalProcessing/AeolusOutputStage.h"
+#include "../../AeolusSignalProcessing/AeolusCallbackStats.h"
+#include "../../AeolusSignalProcessing/AeolusRenderProfiler.h"
+#include "../../AeolusSignalProcessing/AeolusRenderWorkerPool.h"
+#include "../../AeolusSignalProcessing/AeolusRenderAhead.h"
+#include "../../AeolusSignalProcessing/AeolusDivisionActivity.h"
+#include "../../AeolusSignalProcessing/AeolusKernels.h"
+#include "../../AeolusSignalProcessing/AeolusRegistrationStager.h"
+#include "../../AeolusSignalProcessing/AeolusBudgetGovernor.h"
+#include "../../AeolusSignalProcessing/AeolusPolyphonyLimiter.h"
+#include "../../AeolusSignalProcessing/AeolusIdleDetector.h"
+#include "../../AeolusSignalProcessing/AeolusConvolutionReverb.h"
+#include "../../AeolusSignalProcessing/AeolusVarispeed.h"
+#include "../../Platform/AeolusMemoryWarmer.h"
+#include "../../Platform/AeolusSampledRanks.h"
 
 #define max_rank_in_stops 5
 
+#define max_output_channels 2
+
+// Stops per division that fit in a stop activation bitmask, further stops are left out of the bitmask
+#define stop_mask_bits ((int) (8*sizeof(unsigned long)))
+
+// Minimum number of active stops for parallel rendering to be worth the synchronization
+#define parallel_min_stops 4
+
+// A division without active stops is culled once the release tails of its pipes have decayed
+#define idle_division_release_seconds 2.0
+
+// A division at zero gain is culled after this number of periods, by which the engine's gain ramp
+// of at most 5% per period has come down by more than 100 dB (0.95^230 < 1e-5)
+#define zero_gain_fade_periods 230
+
+// Stop changes passed to the model per engine period at most, larger registration changes are
+// spread over several periods such that the pipes they start do not all render their attack at once
+#define registration_changes_per_period 4
+
+// Time for which a released note is counted against the polyphony ceilings, as its pipes fade out
+#define polyphony_release_seconds 0.5
+
+// Time the render load has to stay low before the budget governor raises the quality by one tier
+#define budget_recover_hold_seconds 1.0
+
+// In the SHORT_RELEASE quality tier, divisions without active stops are culled after this time
+#define budget_release_seconds 0.3
+
+// The reverb is faded out or in over this number of periods when the quality tier changes
+#define reverb_fade_periods 16
+
+// Peak output level below which the instrument counts as silent, -100 dBFS
+#define idle_silence_threshold 1e-5f
+
+// Time the instrument has to stay silent without input before rendering is suspended
+#define idle_hold_seconds 0.5
+
+// Block size of the convolution reverb tail; the background thread has this long to convolve a block
+#define convolution_tail_block_frames 1024
+
+// Recorded ranks: the attack of each recording, at least this long, is kept in memory
+#define sampled_attack_seconds 0.3
+
+// Recorded ranks are read into memory this far ahead of the playing position by the streaming thread
+#define sampled_lookahead_seconds 0.5
+
+// Pipes of recorded ranks without release recording fade out over this time, others crossfade into it
+#define sampled_release_seconds 0.08
+
+// Pipes of recorded ranks sounding at once at most
+#define sampled_voices 256
+
+// Largest pitch offset of fine tuning and pitch bend together, up or down, in cents
+#define pitch_offset_max_cents 400
+
+// Pitch bend range by default, up or down, in cents
+#define pitch_bend_range_cents 200
+
+// MIDI channel (0-15) whose pitch bend is applied by default, see setPitchBendChannel
+#define pitch_bend_channel 0
+
+// Once the pitch offset is back to 0, the output is read at most this far off pitch, up or down, in
+// cents, until it is aligned with the engine periods again
+#define varispeed_drain_cents 5
+
+// Burst size of the default (null) audio output in headless builds, similar to common device bursts
+#define headless_frames_per_burst 192
+
 
 
 namespace Aeolussynthesizer {
@@ -51,9 +137,13 @@ namespace Aeolussynthesizer {
          * @param qcomm Interthread communication queue. This is globally instantiated in AeolusSynth_jni_functions.cpp
          * @param qmidi Midi command queue. This is globally instantiated in AeolusSynth_jni_functions.cpp
          * @param stopsPath Path to the stop definition (ae0) files
+         * @param withAudioOutput If true (default), audio is played through oboe, or in headless builds
+         *                        (AEOLUS_HEADLESS) through a real-time paced NullAudioSink. If false, no audio
+         *                        player is created and play() and stop() do nothing; audio is then obtained by
+         *                        calling fillAudioBuffer directly, e.g. for offline rendering to a file.
          */
         AeolusSynthesizer( Lfq_u32 *qnote, Lfq_u32 *qcomm,Lfq_u8* qmidi,
-                                   const char *stopsPath);
+                                   const char *stopsPath, bool withAudioOutput=true);
 
 
         ~AeolusSynthesizer() override;
@@ -87,6 +177,14 @@ namespace Aeolussynthesizer {
          */
         virtual void useDefaultOscillator();
 
+        /**
+         * Replace the audio output, e.g. by a WavFileAudioSink in headless builds. Playback is stopped
+         * first; call play() to start the new player.
+         * @param audioPlayer The new audio player, already connected to getAudioSource() or the default
+         *                    oscillator, or nullptr for no audio output
+         */
+        void setAudioPlayer(std::unique_ptr<synthesizerBase::AudioPlayer> audioPlayer);
+
         /**
          * Set the path to the stops (ae0 files)
          * @param stopsPath The new stops path
@@ -106,14 +204,13 @@ namespace Aeolussynthesizer {
      * by AeolusOscillator, and ultimately this function ). Audio data is obtained through Aeolus audio synthesis
      * algorithm.<br />
      *
-     * audioData represents a pre-reserved float array of length framesCount*channelCount, with a block
-     * structure with channelCount blocks of each block consisting of framesCount consecutive floats. I.e.
-     * This can for example be achieved with an array of the structure float[channelCount][framesCount]. Oboe
+     * audioData represents a pre-reserved float array of length framesCount*channelCount, with
+     * interleaved frames, i.e. the structure float[framesCount][channelCount]. Oboe
      * expects that the values provided be in the interval -1.0 to +1.0
      * @param audioData Pointer to the start of the audio data buffer, preallocated by oboe, of length
-     *                  framesCount*channelCount and with an intended blockwise structure float[channelCount][framesCount]
+     *                  framesCount*channelCount and with interleaved structure float[framesCount][channelCount]
      * @param framesCount Number of samples to be supplied in each channel
-     * @param channelCount Number of channels, e.g., number of blocks. Mono=1, Stereo=2
+     * @param channelCount Number of channels per frame. Mono=1, Stereo=2
      */
         void fillAudioBuffer(float *audioData, int32_t framesCount,
                                      oboe::ChannelCount channelCount) override;
@@ -135,7 +232,180 @@ namespace Aeolussynthesizer {
 
         void noteoff(int chan, int key, int vel);
 
+        /**
+         * @brief Set a ceiling on the number of pipes sounding for held and releasing keys
+         *
+         * Each note sounds one pipe per active stop in the divisions its MIDI channel is routed to, and
+         * in the divisions with an active coupler, while held and for polyphony_release_seconds after its
+         * release. When a new note would take this number beyond the ceiling, releasing notes are stolen
+         * first, then the oldest held notes are released (see AeolusPolyphonyLimiter), so that the render
+         * cost stays bounded whatever is played.
+         * @param pipes Maximum number of pipes, 0 for no limit (the default)
+         */
+        void setPolyphonyCeiling(int pipes);
+
+        /**
+         * Ceiling on the number of pipes sounding for held and releasing keys
+         * @return The ceiling, 0 for no limit, see setPolyphonyCeiling
+         */
+        int getPolyphonyCeiling();
+
+        /**
+         * Set a ceiling on the number of pipes sounding for held and releasing keys in a single division, as
+         * setPolyphonyCeiling does for the whole instrument
+         * @param division_id The index of the division
+         * @param pipes Maximum number of pipes, 0 for no limit (the default)
+         */
+        void setDivisionPolyphonyCeiling(int division_id, int pipes);
+
+        /**
+         * Number of held notes released to stay within the polyphony ceilings, since construction
+         * @return The number of notes stolen
+         */
+        uint64_t getPipeSteals();
+
+        /**
+         * Number of releasing notes no longer counted to stay within the polyphony ceilings, since construction
+         * @return The number of releases stolen
+         */
+        uint64_t getReleaseSteals();
+
+        /**
+         * Estimated number of pipes sounding for held and releasing keys, as counted against the polyphony ceilings
+         * @return The number of pipes
+         */
+        int getEstimatedSoundingPipes();
+
+        /**
+         * @brief Convolve the output with a measured impulse response, as an alternative room model
+         *
+         * The impulse response is read from a WAV file (16, 24 or 32 bit integer or float, mono or
+         * stereo) in the impulses directory of the stops root, next to the stops tree, and convolved with
+         * the stereo output (see AeolusConvolutionReverb). While it is on, the built-in reverb is faded
+         * out when rendering by audio section (the default, see setDivisionCulling); otherwise, turn it
+         * down with setReverbAmount. Loading happens on the calling thread. Like the built-in reverb,
+         * the convolution is faded out in the NO_REVERB quality tier (see setBudgetGovernor).
+         * @param name File name in the impulses directory, ".wav" may be left out; empty to turn the
+         * convolution off
+         * @return False if the file cannot be read, in which case the convolution is off
+         */
+        bool setConvolutionReverb(const std::string &name);
+
+        /**
+         * Impulse responses available for setConvolutionReverb
+         * @return Names of the WAV files of the impulses directory, sorted
+         */
+        std::vector<std::string> getImpulseResponses();
+
+        /**
+         * Set the level of the convolved signal, added to the dry output
+         * @param wet Linear gain, 0.5 by default
+         */
+        void setConvolutionReverbWet(float wet);
+
+        /**
+         * Level of the convolved signal
+         * @return Linear gain, see setConvolutionReverbWet
+         */
+        float getConvolutionReverbWet();
+
+        /**
+         * Convolve the tail of the impulse response on a background thread (the default), or on the
+         * audio thread, for offline rendering independent of thread scheduling. Takes effect with the
+         * next setConvolutionReverb.
+         * @param background True for a background thread
+         */
+        void setConvolutionTailInBackground(bool background);
+
+        /**
+         * Counters of the convolution reverb
+         * @return Copy of the counters
+         */
+        AeolusConvolutionReverb::Statistics getConvolutionReverbStatistics();
+
+        /**
+         * Human readable summary of the convolution reverb, for logging
+         * @return The impulse response in use, the processing time per second of audio and the number
+         * of tail blocks delivered late
+         */
+        std::string getConvolutionReverbSummary();
+
+        /**
+         * @brief Counters of the recorded ranks
+         *
+         * Recorded ranks are listed in the file "sampled" of the instrument directory, next to the
+         * definition, each bound to a stop of the definition, and loaded with the instrument (see
+         * AeolusSampledRanks). They sound with their stop, for the keys played through noteon on the
+         * divisions the MIDI channel is routed to, at the gain of the division. Their pipes are played
+         * from memory-mapped recordings and mixed into the output ahead of the convolution reverb,
+         * bypassing the audio sections and the built-in reverb of the engine.
+         * @return Copy of the counters, including the streaming underruns
+         */
+        AeolusSampledRanks::Statistics getSampledRankStatistics();
+
+        /**
+         * Human readable summary of the recorded ranks, for logging
+         * @return Memory mapped and locked, voices, and streaming underruns, overall and per rank
+         */
+        std::string getSampledRankSummary();
+
+        /**
+         * Stream the recorded ranks on a background thread (the default), or on the audio thread, for
+         * offline rendering independent of thread scheduling, see AeolusSampledRanks::setStreamingInBackground
+         * @param background True for a background thread
+         */
+        void setSampledRankStreamingInBackground(bool background);
+
+        /**
+         * @brief Flush denormal floats to zero while rendering
+         *
+         * The release tails of the pipes and the reverb decay into denormal numbers, which some CPUs
+         * process many times slower than normal ones. When on (the default), the engine periods are
+         * rendered with denormals flushed to zero, on the audio thread and on the render workers (see
+         * AeolusKernels::FlushDenormals). The difference in the output is below 1e-37.
+         * @param enabled True to flush denormals to zero
+         */
+        void setFlushDenormals(bool enabled);
+
+        /**
+         * Are denormals flushed to zero while rendering?
+         * @return True if on, see setFlushDenormals
+         */
+        bool isFlushDenormals();
+
+        /**
+         * @brief Suspend rendering while the instrument is silent
+         *
+         * When nothing has been played and the output, including the release tails and the reverb, has
+         * stayed below -100 dBFS for idle_hold_seconds, the engine periods are no longer rendered and the
+         * output is zero (see AeolusIdleDetector). Rendering resumes in the period in which a note, a
+         * command, a rank message, a division gain change or a tremulant comes in. On by default.
+         * @param enabled True to suspend rendering when silent
+         */
+        void setIdleDetection(bool enabled);
+
+        /**
+         * Is rendering suspended when silent?
+         * @return True if on, see setIdleDetection
+         */
+        bool isIdleDetection();
+
+        /**
+         * Periods rendered and skipped while silent, since construction
+         * @return Copy of the counters
+         */
+        AeolusIdleDetector::Statistics getIdleStatistics();
+
+        /**
+         * Human readable summary of the idle periods, for logging
+         * @return One line with the idle fraction and the number of wake ups
+         */
+        std::string getIdleSummary();
+
         /** Direct activation of a rank for all keyboard input.
+         *
+         * The division is kept from being culled (see setDivisionCulling) until the rank is stopped again
+         * with stopRank.
          * @param division_id The division within which the rank resides
          * @param rank_id The id of the rank to activate within the division
          */
@@ -207,6 +477,79 @@ namespace Aeolussynthesizer {
          * @param base_frequency The new base frequency (default, 440Hz)
          */
         void retune(int temperament,float base_frequency);
+
+        /**
+         * @brief Offset the pitch of the whole instrument slightly, without recomputing the wavetables
+         *
+         * Unlike retune, which recalculates the wavetables of every rank, the offset takes effect over the
+         * next engine period: the master output of the engine is played at a different rate (see
+         * AeolusVarispeed), rendering engine periods slightly more or less often than output periods, and
+         * the recorded ranks change the playback rate of their pipes. As the whole engine output is
+         * resampled, everything in it changes speed with the pitch: tremulants, the engine's reverb and
+         * the release of the pipes; the convolution reverb, applied afterwards, does not. While the pitch
+         * is offset, the output lags the engine by up to one period and loses a little of its highest
+         * frequencies to the interpolation; once the offset is back to 0, the output is brought back in
+         * line with the engine periods (varispeed_drain_cents) and passed through unchanged again.<br />
+         * The offset adds to the pitch bend; where the sum exceeds pitch_offset_max_cents, it is limited
+         * to it, see isPitchOffsetLimited. Meant for small offsets, e.g. following the A of an ensemble
+         * (1200*log2(ensemble/organ frequency) cents); temperament changes stay with retune.
+         * @param cents Pitch offset in cents, 0 for none, limited to pitch_offset_max_cents up or down
+         */
+        void setFineTune(float cents);
+
+        /**
+         * Pitch offset set with setFineTune
+         * @return Offset in cents
+         */
+        float getFineTune();
+
+        /**
+         * Apply a MIDI pitch bend, the same way as setFineTune. The instrument has a single pitch, so a
+         * bend retunes all divisions; to keep one keyboard from bending the others' pitch, only bends on
+         * the channel set with setPitchBendChannel are applied, and bends on other channels are ignored.
+         * @param chan MIDI channel
+         * @param value 14 bit pitch bend value, 8192 for none
+         */
+        void pitchBend(int chan, int value);
+
+        /**
+         * Set the MIDI channel whose pitch bend is applied, pitch_bend_channel by default. A bend in
+         * effect is reset, since it came from the previous channel.
+         * @param chan MIDI channel (0-15)
+         */
+        void setPitchBendChannel(int chan);
+
+        /**
+         * MIDI channel whose pitch bend is applied
+         * @return MIDI channel (0-15)
+         */
+        int getPitchBendChannel();
+
+        /**
+         * Set the pitch offset of a full pitch bend
+         * @param cents Range up or down, in cents, pitch_bend_range_cents by default, limited to
+         * pitch_offset_max_cents
+         */
+        void setPitchBendRange(float cents);
+
+        /**
+         * Pitch offset of a full pitch bend
+         * @return Range up or down, in cents
+         */
+        float getPitchBendRange();
+
+        /**
+         * Pitch offset in effect, of fine tuning and pitch bend together
+         * @return Offset in cents
+         */
+        float getPitchOffset();
+
+        /**
+         * Does the sum of fine tuning and pitch bend exceed pitch_offset_max_cents, such that the pitch
+         * offset in effect (getPitchOffset) is limited to it?
+         * @return True while limited
+         */
+        bool isPitchOffsetLimited();
         /**
          * @brief Get the number of stops configured in the user inteface for a given division.
          *
@@ -264,6 +607,20 @@ namespace Aeolussynthesizer {
          * - And finally, through jni, various functions are invoked from the main Android app
          */
         void thr_main () override;
+
+        using AeolusAudio::put_event;
+
+        /**
+         * @brief Engine message for thr_main, from the model or the slave
+         *
+         * Queues the message as usual. New divisions and rank loads or recalculations (also when
+         * retuning) change the state that the key propagation acts on, and are counted in
+         * _rankMessagesQueued once queued.
+         * @param evid Event (message queue) number
+         * @param M The message
+         * @return As for any event destination
+         */
+        int put_event (unsigned int evid, ITC_mesg *M) override;
         /**
          * For stops representing mixtures of ranks, the maximum number of ranks that can be mixed in
          * a single stop.
@@ -299,6 +656,61 @@ namespace Aeolussynthesizer {
 
         void deactivateTremulantForDivision(int division_id);
 
+        /**
+         * @brief Is the tremulant of this division presently on?
+         *
+         * This reflects the state of the interface element in the model, i.e. it changes once the model
+         * has processed a request from activateTremulantForDivision or deactivateTremulantForDivision, whereas
+         * tremulantIsOn reflects the audio engine, which follows once it has processed its command queue.
+         * @param division_id The index of the division
+         * @return True if the tremulant is on, false if it is off or the division has no tremulant
+         */
+        bool tremulantIsActivated(int division_id);
+
+        /**
+         * @brief Get the number of couplers of a division
+         *
+         * Couplers make the keys of one keyboard also play the stops of another division; they are
+         * interface elements of type COUPLER in the division's group.
+         * @param division_index The index of the division
+         * @return The number of couplers, 0 if the division does not exist
+         */
+        int get_n_couplers_for_division(int division_index);
+
+        /**
+         * @brief Turn on a coupler
+         * @param division_id The index of the division
+         * @param coupler_id The index of the coupler within the division (0 to get_n_couplers_for_division-1)
+         */
+        void activateCoupler(int division_id, int coupler_id);
+
+        /**
+         * @brief Turn off a coupler
+         * @param division_id The index of the division
+         * @param coupler_id The index of the coupler within the division (0 to get_n_couplers_for_division-1)
+         */
+        void deactivateCoupler(int division_id, int coupler_id);
+
+        /**
+         * @brief Is this coupler on?
+         *
+         * As for getStopActivated, this is the state of the interface element in the model.
+         * @param division_id The index of the division
+         * @param coupler_id The index of the coupler within the division
+         * @return True if the coupler is on
+         */
+        bool getCouplerActivated(int division_id, int coupler_id);
+
+        /**
+         * @brief Set the reverb send of all audio sections
+         *
+         * This sets the REVERB parameter of each audio section through the model, as the reverb control
+         * of the Aeolus user interface does. With 0, the sections no longer feed the reverb, but the reverb
+         * itself keeps running.
+         * @param amount Reverb send, 0 to 1
+         */
+        void setReverbAmount(float amount);
+
         /**
          * @brief Are we presently performing a retuning operation?
          *
@@ -323,20 +735,627 @@ namespace Aeolussynthesizer {
 
         void setStopActivationBitmask(int division_index,unsigned long stop_states_for_division);
 
+        /**
+         * @brief Get the timing statistics of the audio callback
+         *
+         * The statistics are collected by the audio thread without locking or logging, and can be read
+         * at any time from any thread. While the pitch is offset (see setFineTune), a callback renders one
+         * engine period more or one less from time to time, which shows in the spread of the durations.
+         * @return Copy of the current statistics
+         * @see AeolusCallbackStats
+         */
+        AeolusCallbackStats::Snapshot getCallbackStatistics() const;
+
+        /**
+         * Clear the timing statistics of the audio callback. The statistics are cleared by the audio
+         * thread at its next callback.
+         */
+        void resetCallbackStatistics();
+
+        /**
+         * @brief Turn the render profiler on or off
+         *
+         * When on, the time spent in each stage of rendering (note and command queue processing, key
+         * logic, synthesis of the divisions, sections and reverb) is recorded for every engine period,
+         * along with the registration in effect. Off by default.
+         * @param enabled True to record
+         * @see AeolusRenderProfiler
+         */
+        void setRenderProfiling(bool enabled);
+
+        /**
+         * Is the render profiler on?
+         * @return True if recording
+         */
+        bool isRenderProfiling();
+
+        /**
+         * @brief Human-readable summary of the render profile
+         *
+         * Lists the registrations recorded, from the most to the least expensive, with the time spent
+         * per stage and the active stops, followed by the estimated cost of individual stops. Times
+         * are given in counter ticks and as fraction of the duration of an engine period.
+         * @return The summary, as multi-line text
+         */
+        std::string getRenderProfileSummary();
+
+        /**
+         * @brief Turn parallel rendering of the divisions on or off
+         *
+         * When on, the divisions of each engine period are rendered on a pool of worker threads, one
+         * audio section per job, while the audio sections, the reverb and the final mix remain on the
+         * audio thread. Divisions feeding the same audio section (as per the instrument definition) are
+         * rendered by the same job in their usual order, so the result is identical to serial rendering.<br />
+         * Periods are still rendered serially while fewer than two audio sections have active stops, or
+         * fewer than parallel_min_stops stops are active, as well as for Ambisonics (B-format) output or
+         * if the instrument definition cannot be read.<br />
+         * A worker preempted while rendering a section holds up the period until it resumes, which can
+         * make the period miss its deadline; after such a late period, rendering is serial for a while,
+         * see getLateParallelPeriods. Off by default.
+         * @param enabled True to render in parallel
+         * @param workers Number of worker threads, 0 for one less than the number of cores
+         */
+        void setParallelRendering(bool enabled, int workers=0);
+
+        /**
+         * Is parallel rendering on?
+         * @return True if on, see setParallelRendering
+         */
+        bool isParallelRendering();
+
+        /**
+         * Number of parallel periods in which the audio thread had to wait for a preempted worker, after
+         * each of which the periods are rendered serially for a while, see AeolusRenderWorkerPool. The
+         * wait lasts until the worker completes, so a late period may take longer than an engine period.
+         * @return Number of late parallel periods since parallel rendering was first turned on
+         */
+        uint64_t getLateParallelPeriods();
+
+        /**
+         * @brief Only propagate key and rank state in periods with input
+         *
+         * The engine's key propagation (proc_keys1 and proc_keys2) goes through all keys and ranks of
+         * all divisions, but only ever acts on entries flagged as changed by the note and command queues,
+         * or by the engine messages that load or recalculate ranks (see put_event). When on (the default),
+         * the queues are only processed when not empty, and the key propagation only runs in periods where
+         * a queue was processed or such a rank message was handled, so that periods without input cost
+         * nothing on the control path.
+         * @param enabled True to skip the key propagation in periods without input
+         */
+        void setIncrementalKeyUpdate(bool enabled);
+
+        /**
+         * Is the key propagation skipped in periods without input?
+         * @return True if on, see setIncrementalKeyUpdate
+         */
+        bool isIncrementalKeyUpdate();
+
+        /**
+         * Number of periods in which the key propagation was skipped, since construction
+         * @return The number of periods
+         */
+        uint64_t getSkippedKeyUpdates();
+
+        /**
+         * @brief Render ahead of the audio callback on a dedicated synthesis thread
+         *
+         * With a look-ahead of n periods, a real-time synthesis thread keeps n engine periods rendered
+         * in advance, and the audio callback only copies them out. This adds n*PERIOD frames of latency
+         * and makes the output immune to scheduling delays of the callback up to that amount. Can be
+         * changed at any time while playing; 0 (default) renders in the callback.
+         * @param periods Look-ahead in engine periods, 0 to AeolusRenderAhead::maxLookAhead
+         * @see AeolusRenderAhead
+         */
+        void setRenderAhead(int periods);
+
+        /**
+         * Current look-ahead
+         * @return Look-ahead in engine periods, 0 when rendering in the callback
+         */
+        int getRenderAhead();
+
+        /**
+         * Latency currently added by render-ahead mode
+         * @return Number of frames rendered ahead of the callback at this moment
+         */
+        int getRenderAheadLatencyFrames();
+
+        /**
+         * Number of periods the callback found nothing rendered ahead, and output silence instead
+         * @return Underrun count since construction
+         */
+        uint64_t getRenderAheadUnderruns();
+
+        /**
+         * @brief Skip the rendering of idle divisions
+         *
+         * When on (the default), divisions without active stops are no longer processed once the
+         * release tails of their pipes have decayed (idle_division_release_seconds); ranks turned on
+         * with activateRank count as active stops. Neither are
+         * divisions whose gain has been set to zero with setVolumeForDivision, once their output
+         * has faded out (zero_gain_fade_periods). An idle division thus costs no render time. This
+         * needs the audio sections of the divisions from the instrument definition, as for parallel
+         * rendering; if the definition cannot be read, all divisions are always processed.
+         * @param enabled True to cull idle divisions
+         * @see AeolusDivisionActivity
+         */
+        void setDivisionCulling(bool enabled);
+
+        /**
+         * Is the culling of idle divisions on?
+         * @return True if on, see setDivisionCulling
+         */
+        bool isDivisionCulling();
+
+        /**
+         * @brief Render section by section even without division culling or parallel rendering
+         *
+         * Without culling and parallel rendering, periods go through the engine's own proc_synth. When
+         * on, they go through the section by section rendering instead, which processes every division
+         * in that case and is expected to give the same output. Meant to check the latter against
+         * proc_synth (see aeolus_golden); off by default.
+         * @param enabled True to render section by section
+         */
+        void setSectionRendering(bool enabled);
+
+        /**
+         * Is section by section rendering forced?
+         * @return True if on, see setSectionRendering
+         */
+        bool isSectionRendering();
+
+        /**
+         * @brief Turn the CPU budget governor on or off
+         *
+         * When on, the render time of each engine period is compared with its duration. When the moving
+         * average of this load exceeds the degrade threshold, the quality is lowered by one tier (see
+         * AeolusBudgetGovernor::Tier): release tails of divisions without stops cut after
+         * budget_release_seconds, then the reverb faded out, then the tremulants turned off. Once the
+         * load has stayed below the recover threshold for budget_recover_hold_seconds, the quality is
+         * raised again by one tier. Cutting the release tails needs division culling, and the reverb
+         * can only be left out when the divisions are rendered section by section (see
+         * setDivisionCulling); otherwise these tiers make no difference. Off by default.
+         * @param enabled True to govern
+         */
+        void setBudgetGovernor(bool enabled);
+
+        /**
+         * Is the CPU budget governor on?
+         * @return True if on, see setBudgetGovernor
+         */
+        bool isBudgetGovernor();
+
+        /**
+         * Set the load thresholds of the budget governor, as fractions of the period duration
+         * @param degradeLoad Load above which the quality is lowered, 0.8 by default
+         * @param recoverLoad Load below which the quality is raised again, 0.5 by default
+         */
+        void setBudgetThresholds(float degradeLoad, float recoverLoad);
+
+        /**
+         * Let the budget governor use a quality tier, or have it skip the tier
+         * @param tier The tier, see AeolusBudgetGovernor::Tier
+         * @param allowed False to skip the tier
+         */
+        void setQualityTierAllowed(int tier, bool allowed);
+
+        /**
+         * Quality tier in effect
+         * @return The tier, see AeolusBudgetGovernor::Tier, 0 for full quality
+         */
+        int getQualityTier();
+
+        /**
+         * State and counters of the budget governor
+         * @return Copy of the statistics since construction
+         */
+        AeolusBudgetGovernor::Statistics getBudgetGovernorStatistics();
+
+        /**
+         * @brief Human-readable summary of the budget governor
+         *
+         * The current tier and load, the steps taken, and the time spent in each tier.
+         * @return The summary, as multi-line text
+         */
+        std::string getBudgetGovernorSummary();
+
+        /**
+         * Render activity of a division: periods processed and culled, and render time
+         * @param division_id Index of the division
+         * @return Copy of the statistics since construction or the last reset
+         */
+        AeolusDivisionActivity::DivisionStatistics getDivisionActivity(int division_id);
+
+        /**
+         * Clear the division activity statistics, effective at the next engine period
+         */
+        void resetDivisionActivity();
+
+        /**
+         * @brief Human-readable summary of the division activity
+         *
+         * One line per division, with the share of periods culled, and the mean and worst render time
+         * per processed period, also as fraction of the duration of an engine period.
+         * @return The summary, as multi-line text
+         */
+        std::string getDivisionActivitySummary();
+
+        /**
+         * @brief Turn the memory warm-up before stop activations on or off
+         *
+         * Stop changes are passed to the model by a background thread. When on, this thread first reads back
+         * into RAM the instrument memory the system has reclaimed since, so that the newly activated ranks
+         * do not take page faults in the audio callback. The instrument memory is the memory mapped while
+         * the instrument loaded, and a warm-up stops after AeolusMemoryWarmer::warmUpBudgetMicroseconds.
+         * Stop changes are delivered in the order requested either way; with warm-up on, activations reach
+         * the model up to that long later. Off by default.
+         * @param enabled True to warm up before activations
+         * @see AeolusMemoryWarmer
+         */
+        void setStopWarmUp(bool enabled);
+
+        /**
+         * Is the memory warm-up before stop activations on?
+         * @return True if on, see setStopWarmUp
+         */
+        bool isStopWarmUp();
+
+        /**
+         * @brief Keep the large instrument memory blocks locked in RAM
+         *
+         * Takes effect at the next warm-up that completes in time, i.e. a stop activation with warm-up on.
+         * Only the memory mapped while the instrument loaded is locked. The system may
+         * refuse to lock more than a small amount of memory per process; refusals are counted in the
+         * statistics. Turning locking off unlocks right away.
+         * @param locking True to lock
+         */
+        void setWavetableLocking(bool locking);
+
+        /**
+         * Activity counters of the memory warm-up
+         * @return Copy of the counters since construction
+         */
+        AeolusMemoryWarmer::Statistics getStopWarmUpStatistics();
+
+        /**
+         * Human-readable summary of the memory warm-up counters
+         * @return The summary, as a single line
+         */
+        std::string getStopWarmUpSummary();
+
+        /**
+         * @brief Limit the number of stop changes passed to the model per engine period
+         *
+         * Drawing many stops at once starts all their pipes for the keys held in the same period, which
+         * can take several times as long to render as the steady state. With a limit, larger registration
+         * changes are spread over as many periods as needed, e.g. a tutti of 40 stops over 10 periods
+         * (about 13 ms at 48 kHz) with the default of registration_changes_per_period. Changes keep their
+         * order. If no audio is being rendered, the changes go through after a short wait.
+         * @param changes Maximum number of stop changes per period, 0 for no limit
+         * @see AeolusRegistrationStager
+         */
+        void setRegistrationChangesPerPeriod(int changes);
+
+        /**
+         * Maximum number of stop changes per period
+         * @return The limit, 0 for no limit, see setRegistrationChangesPerPeriod
+         */
+        int getRegistrationChangesPerPeriod();
+
+        /**
+         * Counters of the staging of registration changes
+         * @return Copy of the counters since construction
+         */
+        AeolusRegistrationStager::Statistics getRegistrationStagingStatistics();
+
 
     protected:
 
 
-        /** @brief Allocate output buffer for audio processing
+        /** @brief Render one engine period into the period buffer
          *
-         * For audio output, the Aeolus synthesizer fills its own audio buffer, in which the
-         * output audio signal is stored. Once audio synthesis complete, the audio amplitude values
-         * are copied to the oboe audio buffer to drive the audio system in fillAudioBuffer<br />
-         * This approach permits to have the various collaborating audio synthesis classes (divisions,
-         * audio sections, ranks, ...) having fixed, preconfigured buffer pointers, with transfer
-         * to the variable oboe buffer pointer only once synthesis is complete.
+         * Processes the pending note and command queues, the key state, and finally the Aeolus
+         * audio synthesis for exactly PERIOD frames. The engine renders into the _outbuf channel
+         * pointers, which point into _periodBuffer; once done, the rendered period is made available
+         * for handing out to oboe in fillAudioBuffer.
          */
-         void allocateOutputBuffer();
+         void renderPeriod();
+
+         /**
+          * @brief Render one engine period into the buffers _outbuf points to
+          *
+          * The engine part of renderPeriod, also used by the synthesis thread in render-ahead mode:
+          * queue and key processing, then synthesis, with the optional profiling. Synthesis goes through
+          * synthesizePeriodSections whenever the division layout is known, and proc_synth otherwise.
+          */
+         void synthesizePeriod();
+
+         /**
+          * Render-ahead callback on the synthesis thread: render one period into the ring slot
+          * @param context The AeolusSynthesizer
+          * @param channels Planar storage of the ring slot
+          */
+         static void renderAheadPeriod(void *context, float *const *channels);
+         /** @brief Rendered audio waiting to be handed out to oboe
+          *
+          * Storage for the engine output (_outbuf points here), allocated once during construction.
+          * The engine always renders whole periods of PERIOD frames, while oboe may ask for any number
+          * of frames per callback; the frames rendered but not yet requested remain in this buffer
+          * until the next callback. This keeps the heap out of the audio callback even if the oboe burst
+          * size changes while playing.
+          */
+         AeolusPeriodBuffer _periodBuffer;
+         /**
+          * Synthesis thread and period ring for render-ahead mode, see setRenderAhead
+          */
+         AeolusRenderAhead _renderAhead;
+         /**
+          * Interleaving, master gain (see setVolume) and sample format conversion from the planar
+          * engine output to the oboe buffer
+          */
+         AeolusOutputStage _outputStage;
+         /**
+          * Timing statistics of the audio callback, written by the audio thread in fillAudioBuffer
+          */
+         AeolusCallbackStats _callbackStats;
+         /**
+          * Optional per-stage timing of the engine periods, see setRenderProfiling
+          */
+         AeolusRenderProfiler _renderProfiler;
+         /**
+          * Culling of idle divisions and render time per division, see setDivisionCulling
+          */
+         AeolusDivisionActivity _divisionActivity;
+         /**
+          * Limit of stop changes per period, see setRegistrationChangesPerPeriod
+          */
+         AeolusRegistrationStager _registrationStager;
+         /**
+          * Quality tiers by render load, see setBudgetGovernor
+          */
+         AeolusBudgetGovernor _budgetGovernor;
+         /**
+          * Polyphony ceiling on the notes played through noteon, see setPolyphonyCeiling
+          */
+         AeolusPolyphonyLimiter _polyphonyLimiter;
+         /**
+          * Suspension of rendering while silent, see setIdleDetection
+          */
+         AeolusIdleDetector _idleDetector;
+         /**
+          * Convolution with an impulse response, see setConvolutionReverb
+          */
+         AeolusConvolutionReverb _convolutionReverb;
+         /** Level of the convolved signal, see setConvolutionReverbWet */
+         std::atomic<float> _convolutionWet{0.5f};
+         /** Name of the impulse response in use, empty if none */
+         std::string _impulseResponse;
+         /**
+          * Ranks of recorded pipes, see getSampledRankStatistics
+          */
+         AeolusSampledRanks _sampledRanks;
+         /**
+          * Playback rate of the engine output, for fine tuning and pitch bend, see setFineTune
+          */
+         AeolusVarispeed _varispeed;
+         /** Pitch offset in cents, see setFineTune */
+         std::atomic<float> _fineTuneCents{0.0f};
+         /** Last pitch bend, from -1 to 1 */
+         std::atomic<float> _pitchBend{0.0f};
+         /** Pitch offset of a full bend in cents, see setPitchBendRange */
+         std::atomic<float> _pitchBendRange{pitch_bend_range_cents};
+         /** MIDI channel whose pitch bend is applied, see setPitchBendChannel */
+         std::atomic<int> _pitchBendChannel{pitch_bend_channel};
+
+         /** Is the sum of fine tuning and pitch bend beyond pitch_offset_max_cents? */
+         std::atomic<bool> _pitchOffsetLimited{false};
+         /** Pass the fine tuning and pitch bend to _varispeed, limited to pitch_offset_max_cents */
+         void updatePitch();
+
+         /**
+          * Varispeed source: render one engine period into _outbuf, by audio section when possible
+          * @param context The AeolusSynthesizer
+          * @return _outbuf
+          */
+         static const float *const *renderEnginePeriod(void *context);
+         /** Denormals flushed to zero while rendering, see setFlushDenormals */
+         std::atomic<bool> _flushDenormals{true};
+         /** Division gains at the last rendered period, audio side, see controlsChanged */
+         float _renderedGains[NDIVIS]{};
+
+         /**
+          * Audio side: has anything changed, outside the queues and engine messages, that the engine
+          * would act on? Checks the division gains against _renderedGains, which it updates, and the
+          * tremulants, whose modulation runs on without input.
+          * @return True if the next period has to be rendered
+          */
+         bool controlsChanged();
+
+         /**
+          * Polyphony limiter callback: release a stolen note
+          * @param context The AeolusSynthesizer
+          * @param channel MIDI channel of the note
+          * @param key MIDI key of the note
+          */
+         static void releaseStolenNote(void *context, int channel, int key);
+
+         /** Quality tier in effect, audio side */
+         AeolusBudgetGovernor::Tier _appliedTier = AeolusBudgetGovernor::FULL;
+         /** Render time per engine period, of the last period that rendered any, audio side */
+         uint64_t _enginePeriodNanoseconds = 0;
+         /** Gain of the reverb output, faded between 0 and 1 on quality tier changes, audio side */
+         float _reverbWet = 1.0f;
+         /** Divisions whose tremulant the governor has turned off, audio side */
+         unsigned _governorTremulants = 0;
+         /** Divisions whose tremulant is on in the model, updated with the user interface */
+         std::atomic<unsigned> _tremulantsActivated{0};
+
+         /**
+          * Put a quality tier into effect, audio side
+          * @param tier The tier decided by _budgetGovernor
+          */
+         void applyQualityTier(AeolusBudgetGovernor::Tier tier);
+
+         /**
+          * Reverb stage of synthesizePeriodSections: process the reverb, fade it, or leave it out,
+          * depending on the quality tier
+          */
+         void processReverb(float *W, float *X, float *Y, float *Z, float *R);
+         /**
+          * Stop activation bitmasks per division as applied by the model, updated by refreshDivisionActivity.
+          * Used to tag the render profile with the registration.
+          */
+         uint64_t _appliedStopMasks[AeolusRenderProfiler::maxDivisions]{};
+
+         /**
+          * Ranks turned on with activateRank, one bit per rank and division. These bypass the model, so
+          * the stop masks do not show them; a division with such ranks counts as having active stops.
+          */
+         std::atomic<uint64_t> _directRanks[NDIVIS]{};
+
+         /**
+          * Send the stop activation or deactivation to the model through _memoryWarmer
+          * @param division_id ID of the division in which the stop is found
+          * @param stop_id ID of the stop within the division
+          * @param activate True to activate, false to deactivate
+          */
+         void requestStopState(int division_id, int stop_id, bool activate);
+
+         /**
+          * Memory warm-up thread, delivering the stop changes to the model, see setStopWarmUp
+          */
+         std::unique_ptr<AeolusMemoryWarmer> _memoryWarmer = nullptr;
+
+         /**
+          * Memory warm-up callback: send a stop change to the model, within the limit of _registrationStager
+          * @param context The AeolusSynthesizer
+          * @param change The stop change
+          */
+         static void deliverStopChange(void *context, const AeolusMemoryWarmer::StopChange &change);
+
+         /**
+          * Pass the registration in _appliedStopMasks to the render profiler. User interface thread only.
+          */
+         void publishAppliedRegistration();
+
+         /**
+          * Pass the stop state of all divisions, as found in the model and _directRanks, to _divisionActivity and
+          * _polyphonyLimiter, note the tremulant state in _tremulantsActivated and publish the
+          * registration through publishAppliedRegistration
+          */
+         void refreshDivisionActivity();
+
+         /**
+          * User interface listener: interface elements have changed
+          * @param context The AeolusSynthesizer
+          */
+         static void onStopsUpdated(void *context);
+
+         /**
+          * Read the audio section of each division from the instrument definition, into _divisionSection
+          * @return The number of divisions found, or -1 if the definition cannot be read
+          */
+         int readDivisionSections();
+
+         /**
+          * @brief Render the divisions section by section, followed by sections, reverb and mix
+          *
+          * Replaces proc_synth(PERIOD), following its steps for one period and stereo output. The
+          * divisions are rendered one audio section at a time, skipping idle divisions, either on the
+          * worker pool or on the calling thread.
+          * @param parallel True to render the sections on the worker pool
+          */
+         void synthesizePeriodSections(bool parallel);
+
+         /**
+          * Worker pool job: process the divisions feeding one audio section, except the idle ones
+          * @param context The AeolusSynthesizer
+          * @param section Index of the audio section
+          */
+         static void processSectionDivisions(void *context, int section);
+
+         /** Worker threads for parallel rendering, created when first turned on */
+         std::unique_ptr<AeolusRenderWorkerPool> _renderWorkers = nullptr;
+         /** Key propagation only in periods with input, see setIncrementalKeyUpdate */
+         std::atomic<bool> _incrementalKeys{true};
+         /** Number of rank messages queued for thr_main, see put_event */
+         std::atomic<uint64_t> _rankMessagesQueued{0};
+         /** Number of rank messages handled by thr_main, written by that thread */
+         std::atomic<uint64_t> _engineMessages{0};
+         /** Value of _engineMessages at the last key propagation, audio side only */
+         uint64_t _keysEngineMessages = ~0ull;
+         /** Periods without key propagation, written by the audio side */
+         std::atomic<uint64_t> _skippedKeyUpdates{0};
+         /** Parallel rendering requested, see setParallelRendering */
+         std::atomic<bool> _parallelRendering{false};
+         /** Section by section rendering without culling, see setSectionRendering */
+         std::atomic<bool> _sectionRendering{false};
+         /** The registration is heavy enough for parallel rendering, updated with _appliedStopMasks */
+         std::atomic<bool> _parallelWorthwhile{false};
+         /** Number of divisions in the instrument definition, -1 if unknown */
+         int _definitionDivisions = -1;
+         /** Audio section of each division, as per the instrument definition */
+         int _divisionSection[NDIVIS]{};
+
+         /**
+          * @brief Implementation of fillAudioBuffer
+          *
+          * Renders engine periods as needed and hands the rendered frames to oboe through _outputStage
+          * @param audioData Interleaved oboe buffer of framesCount*channelCount samples
+          * @param framesCount Number of frames to be supplied
+          * @param channelCount Number of channels per frame
+          */
+         void fillInterleavedBuffer(float *audioData, int32_t framesCount, int32_t channelCount);
+
+         /** Implementation of fillAudioBuffer for a given stream configuration */
+         using StreamFiller = void (AeolusSynthesizer::*)(float *audioData, int32_t framesCount, int32_t channelCount);
+
+         /**
+          * Stream configuration seen in the last callback, and the implementation selected for it, audio
+          * side only. The implementation is selected at the first callback and whenever the burst size or
+          * channel count change, see selectStreamFiller.
+          */
+         struct StreamConfiguration {
+             int32_t framesCount = -1;
+             int32_t channelCount = -1;
+             StreamFiller fill = nullptr;
+         } _stream;
+
+         /**
+          * @brief Choose the implementation of fillAudioBuffer for a stream configuration
+          *
+          * Stereo engine output to mono or stereo streams with bursts of 64, 128, 192 or 256 frames (whole
+          * engine periods) goes to a fillWholePeriods specialization, anything else to fillInterleavedBuffer.
+          * @param framesCount Burst size
+          * @param channelCount Channels of the stream
+          * @return The implementation
+          */
+         StreamFiller selectStreamFiller(int32_t framesCount, int32_t channelCount);
+
+         /** selectStreamFiller for a given channel count */
+         template<int Channels>
+         StreamFiller selectStreamFiller(int32_t framesCount);
+
+         /** fillWholePeriods for Frames if these are whole periods, fillInterleavedBuffer otherwise */
+         template<int Channels, int Frames>
+         static StreamFiller wholePeriodFiller();
+
+         /**
+          * @brief fillInterleavedBuffer for stereo engine output, Channels output channels and bursts of
+          * Frames frames, a multiple of PERIOD
+          *
+          * Renders Frames/PERIOD periods and hands each one out in full, without the bookkeeping of
+          * partial periods. If frames are left over from bursts of another size, these are served by
+          * fillInterleavedBuffer first.
+          */
+         template<int Channels, int Frames>
+         void fillWholePeriods(float *audioData, int32_t framesCount, int32_t channelCount);
+
+         /** Make the next period available in _periodBuffer, from the synthesis thread or rendered here */
+         void nextPeriod();
+
+         /** Record the duration of an audio callback that started at start in _callbackStats */
+         void recordCallbackTime(std::chrono::steady_clock::time_point start, int32_t framesCount);
          /** @brief Default oscillator for running Aeolus
           *
           * The default oscillator is configured during AeolusSynthesizer object construction and routes
@@ -388,6 +1407,7 @@ namespace Aeolussynthesizer {
         const char* stop_directory; // individual stops, for registers
         const char* instrument_directory; // Instrument overall construction
         const char* wave_directory; //  directory to store pre-calculated wave tables
+        const char* impulse_directory; // impulse responses for the convolution reverb
 
         bool isPlaying=false; // is the oboe audio generation running?
 
@@ -15,7 +15,6 @@
 //  You should have received a copy of the GNU General Public License
 //  along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
-#include <jni.h>
 #include "android_aeolus_user_interface.h"
 
 
@@ -32,6 +31,7 @@ void android_aeolus_user_interface::handle_ifc_ready() {
     {
         if (_init)
         {
+            notifyStopsListener();
             AndroidAeolusUserInterfaceOnLoadComplete();
             tIO.handleOutputFromTI("Aeolus is ready");
 
@@ -47,22 +47,34 @@ void android_aeolus_user_interface::handle_ifc_ready() {
 
 void android_aeolus_user_interface::handle_ifc_grclr(M_ifc_ifelm *M) {
     Tiface::handle_ifc_grclr( M);
+    notifyStopsListener();
     AndroidAeolusUserInterfaceonStopsUpdated();
 }
 
 void android_aeolus_user_interface::handle_ifc_elclr(M_ifc_ifelm *M) {
     Tiface::handle_ifc_elclr( M);
+    notifyStopsListener();
     AndroidAeolusUserInterfaceonStopsUpdated();
 }
 
 void android_aeolus_user_interface::handle_ifc_elset(M_ifc_ifelm *M) {
     Tiface::handle_ifc_elset(M);
+    notifyStopsListener();
     AndroidAeolusUserInterfaceonStopsUpdated();
 
 }
 
 
 
+void android_aeolus_user_interface::setStopsListener(StopsListener listener, void *context) {
+    _stopsListener = listener;
+    _stopsListenerContext = context;
+}
+
+void android_aeolus_user_interface::notifyStopsListener() {
+    if (_stopsListener != nullptr) _stopsListener(_stopsListenerContext);
+}
+
 void android_aeolus_user_interface::handle_ifc_retuning_done() {
     Tiface::handle_ifc_retuning_done();
     AndroidAeolusUserInterfaceonRetuned();
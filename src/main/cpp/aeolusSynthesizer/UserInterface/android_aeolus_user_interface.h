@@ -30,6 +30,18 @@
  */
 class android_aeolus_user_interface : public  Tiface  {
 
+public:
+    /** Native listener for changes of the interface element states, see setStopsListener */
+    typedef void (*StopsListener)(void *context);
+    /**
+     * Register a native listener, called on the user interface thread whenever interface elements
+     * (stops, couplers, tremulants) are set or cleared, whatever the origin of the change. To be set
+     * before the user interface thread is started.
+     * @param listener The function to call, nullptr for none
+     * @param context Passed to the listener
+     */
+    void setStopsListener(StopsListener listener, void *context);
+
 protected:
     /**
      * Initialize the user interface core data with the incoming message
@@ -61,6 +73,12 @@ protected:
      */
     void handle_ifc_retuning_done() override;
 
+private:
+    /** Call the native listener, if any */
+    void notifyStopsListener();
+
+    StopsListener _stopsListener = nullptr;
+    void *_stopsListenerContext = nullptr;
 
 
 };
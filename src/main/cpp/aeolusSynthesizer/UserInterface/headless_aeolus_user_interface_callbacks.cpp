@@ -0,0 +1,37 @@
+// ----------------------------------------------------------------------------
+//
+//  Copyright (C) 2025 Mathis and Thomas Braschler <thomas.braschler@gmail.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// Headless counterpart of android_aeolus_user_interface_jni.cpp: without Java layer to notify, the
+// user interface notifications are only logged.
+
+#include "android_aeolus_user_interface_jni.h"
+#include "../Platform/AeolusLog.h"
+
+void AndroidAeolusUserInterfaceOnLoadComplete() {
+    Aeolussynthesizer::aeolusLog(Aeolussynthesizer::LogLevel::DEBUG,
+                                 "headless_aeolus_user_interface", "Load complete");
+}
+
+void AndroidAeolusUserInterfaceonStopsUpdated() {
+    Aeolussynthesizer::aeolusLog(Aeolussynthesizer::LogLevel::DEBUG,
+                                 "headless_aeolus_user_interface", "Stops updated");
+}
+
+void AndroidAeolusUserInterfaceonRetuned() {
+    Aeolussynthesizer::aeolusLog(Aeolussynthesizer::LogLevel::DEBUG,
+                                 "headless_aeolus_user_interface", "Retuned");
+}
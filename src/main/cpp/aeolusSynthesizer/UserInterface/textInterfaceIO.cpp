@@ -15,10 +15,10 @@
 //  You should have received a copy of the GNU General Public License
 //  along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
-#include <android/log.h>
 #include "textInterfaceIO.h"
+#include "../Platform/AeolusLog.h"
 
 void textInterfaceIO::handleOutputFromTI(const char *message) {
-    __android_log_print(android_LogPriority::ANDROID_LOG_INFO,
+    Aeolussynthesizer::aeolusLog(Aeolussynthesizer::LogLevel::INFO,
                         "TextInterface", "%s", message);
 }
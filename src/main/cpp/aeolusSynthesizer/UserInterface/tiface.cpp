@@ -36,6 +36,7 @@
 #include <cstdio>
 #include <cctype>
 #include "tiface.h"
+#include "../Platform/AeolusLog.h"
 
 /**
  * @class Reader
@@ -253,7 +254,7 @@ void Tiface::handle_ifc_ready ()
  */
 void Tiface::handle_ifc_init (M_ifc_init *M)
 {
-    __android_log_print(android_LogPriority::ANDROID_LOG_INFO,
+    Aeolussynthesizer::aeolusLog(Aeolussynthesizer::LogLevel::INFO,
                         "Tiface", "Marker 1");
     if (_initdata) _initdata ->recover ();
     _initdata = M_ifc_init::createCopy(M);
@@ -318,7 +319,7 @@ void Tiface::handle_ifc_elset (M_ifc_ifelm *M)
  */
 void Tiface::handle_ifc_elatt (M_ifc_ifelm *M)
 {
-    __android_log_print(android_LogPriority::ANDROID_LOG_INFO,
+    Aeolussynthesizer::aeolusLog(Aeolussynthesizer::LogLevel::INFO,
                         "Tiface", "Rewrite label %s",_initdata->_groupd [M->_group]._ifelmd [M->_ifelm]._label);
 
     rewrite_label (_initdata->_groupd [M->_group]._ifelmd [M->_ifelm]._label);
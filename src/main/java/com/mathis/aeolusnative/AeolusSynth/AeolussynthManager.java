@@ -318,4 +318,326 @@ public class AeolussynthManager {
     public static native long getActiveStopsForDivision(int divisionIndex);
 
     public static native void setActiveStopsForDivision(int divisionIndex, long stopStatesForDivision);
+
+    /** Index of the number of audio callbacks in the array returned by getCallbackStatistics */
+    public static final int CALLBACK_STATS_CALLBACKS = 0;
+    /** Index of the number of frames rendered in the array returned by getCallbackStatistics */
+    public static final int CALLBACK_STATS_FRAMES_RENDERED = 1;
+    /** Index of the number of deadline misses in the array returned by getCallbackStatistics */
+    public static final int CALLBACK_STATS_DEADLINE_MISSES = 2;
+    /** Index of the longest callback duration (ns) in the array returned by getCallbackStatistics */
+    public static final int CALLBACK_STATS_WORST_NANOSECONDS = 3;
+    /** Index of the summed callback duration (ns) in the array returned by getCallbackStatistics */
+    public static final int CALLBACK_STATS_TOTAL_NANOSECONDS = 4;
+    /** Index of the first histogram bucket in the array returned by getCallbackStatistics */
+    public static final int CALLBACK_STATS_HISTOGRAM = 5;
+
+    /**
+     * Get the timing statistics of the audio callback.
+     * <br /><br />
+     * The statistics are collected by the audio thread without locking or logging, so they can be
+     * queried from the field without disturbing audio. A deadline miss is a callback that took longer
+     * than the duration of the audio it delivered.
+     * <br /><br />
+     * The array contains, at the positions given by the CALLBACK_STATS_ constants, the number of
+     * callbacks, the number of frames rendered, the number of deadline misses, the longest and the summed
+     * callback durations in nanoseconds, followed by the callback duration histogram. Histogram bucket 0
+     * counts callbacks shorter than 16 microseconds, bucket k those shorter than 16*2^k microseconds
+     * (and longer than the bound of bucket k-1); the last bucket also counts all longer callbacks.
+     *
+     * @return Statistics since start or since the last resetCallbackStatistics call
+     */
+    public static native long[] getCallbackStatistics();
+
+    /**
+     * Clear the timing statistics of the audio callback. The statistics are cleared at the next
+     * audio callback.
+     */
+    public static native void resetCallbackStatistics();
+
+    /**
+     * Turn the render profiler on or off. When on, the time spent in the stages of the audio
+     * rendering (queue processing, key logic, synthesis by the divisions, sections and reverb) is
+     * recorded for each block of audio, along with the registration (set of active stops) in effect.
+     * Off by default; leave it off unless profiling.
+     *
+     * @param enabled True to record
+     */
+    public static native void setRenderProfiling(boolean enabled);
+
+    /**
+     * Summary of the render profile recorded since setRenderProfiling(true): the registrations
+     * played, from the most to the least expensive, with the time per stage, followed by the
+     * estimated cost of individual stops.
+     *
+     * @return Multi-line human-readable summary
+     */
+    public static native String getRenderProfileSummary();
+
+    /**
+     * Turn parallel rendering on or off. When on, the divisions are rendered on worker threads
+     * running on the other cores, which helps with large registrations spread over several
+     * divisions. Light registrations are still rendered on the audio thread. A worker thread that
+     * the system preempts holds up the period until it resumes, which can cause a glitch; rendering
+     * then stays on the audio thread for a while. Off by default.
+     *
+     * @param enabled True to render in parallel
+     */
+    public static native void setParallelRendering(boolean enabled);
+
+    /**
+     * @return True if parallel rendering is on
+     */
+    public static native boolean isParallelRendering();
+
+    /**
+     * Render ahead of the audio callback on a dedicated synthesis thread. The callback then only
+     * copies out periods rendered in advance, which makes the output robust against scheduling
+     * hiccups, at the cost of periods * 64 frames of added latency. 0 (default) renders in the
+     * audio callback.
+     *
+     * @param periods Number of engine periods of 64 frames to render ahead, 0 to 32
+     */
+    public static native void setRenderAhead(int periods);
+
+    /**
+     * @return Current render-ahead in engine periods, 0 if rendering in the audio callback
+     */
+    public static native int getRenderAhead();
+
+    /**
+     * @return Number of frames currently rendered ahead of the audio callback, i.e. the added latency
+     */
+    public static native int getRenderAheadLatencyFrames();
+
+    /**
+     * @return Number of periods the audio callback had to replace by silence because nothing was
+     * rendered ahead
+     */
+    public static native long getRenderAheadUnderruns();
+
+    /**
+     * Turn the culling of idle divisions on or off. When on (the default), divisions without
+     * active stops, or with their volume set to zero, are no longer rendered once their sound has
+     * died away, so that unused manuals cost no processing time.
+     *
+     * @param enabled True to skip idle divisions
+     */
+    public static native void setDivisionCulling(boolean enabled);
+
+    /**
+     * @return True if idle divisions are skipped
+     */
+    public static native boolean isDivisionCulling();
+
+    /**
+     * Summary of the render activity per division: whether the division is idle, the share of
+     * periods it was skipped, and the time spent rendering it.
+     *
+     * @return Multi-line human-readable summary
+     */
+    public static native String getDivisionActivitySummary();
+
+    /**
+     * Turn the memory warm-up before stop activations on or off. When on, the instrument memory
+     * the system has paged out is read back in before a newly activated stop sounds, so that its
+     * first notes do not glitch. Activations are held back by at most 20 ms for this. Off by
+     * default.
+     *
+     * @param enabled True to warm up before activations
+     */
+    public static native void setStopWarmUp(boolean enabled);
+
+    /**
+     * @return True if the memory warm-up before stop activations is on
+     */
+    public static native boolean isStopWarmUp();
+
+    /**
+     * Keep the large instrument memory blocks locked in RAM, from the next stop activation with
+     * warm-up on. The system may refuse this beyond a small amount of memory.
+     *
+     * @param locking True to lock
+     */
+    public static native void setWavetableLocking(boolean locking);
+
+    /**
+     * Counters of the memory warm-up: size of the instrument memory, warm-ups run and those cut
+     * short, pages read back in, page faults taken, and memory locked.
+     *
+     * @return Single-line human-readable summary
+     */
+    public static native String getStopWarmUpSummary();
+
+    /**
+     * Limit the number of stop changes passed on per engine period. Larger registration changes,
+     * such as a whole division or a tutti at once, are spread over several periods, so that the
+     * pipes they start do not all load the same audio callback.
+     *
+     * @param changes Maximum number of stop changes per period, 0 for no limit
+     */
+    public static native void setRegistrationChangesPerPeriod(int changes);
+
+    /**
+     * @return Maximum number of stop changes per period, 0 for no limit
+     */
+    public static native int getRegistrationChangesPerPeriod();
+
+    /**
+     * Skip the propagation of key and rank state in engine periods without notes or commands
+     * (the default), such that idle periods cost nothing on the control path.
+     *
+     * @param enabled True to skip the propagation in periods without input
+     */
+    public static native void setIncrementalKeyUpdate(boolean enabled);
+
+    /**
+     * @return True if the key propagation is skipped in periods without input
+     */
+    public static native boolean isIncrementalKeyUpdate();
+
+    /**
+     * Turn the CPU budget governor on or off (off by default). When on, the synthesizer lowers
+     * its quality step by step when rendering comes close to the audio deadline: shorter release
+     * tails, then no reverb, then no tremulants, and returns to full quality once the load has
+     * stayed low for a while.
+     *
+     * @param enabled True to govern
+     */
+    public static native void setBudgetGovernor(boolean enabled);
+
+    /**
+     * @return True if the CPU budget governor is on
+     */
+    public static native boolean isBudgetGovernor();
+
+    /**
+     * @return Quality tier in effect, 0 for full quality, up to 3 for no tremulants
+     */
+    public static native int getQualityTier();
+
+    /**
+     * Summary of the CPU budget governor: current tier and load, steps taken, and time spent in
+     * each tier.
+     *
+     * @return Multi-line human-readable summary
+     */
+    public static native String getBudgetGovernorSummary();
+
+    /**
+     * Set a ceiling on the number of pipes sounding for held and releasing keys. Beyond it,
+     * releasing notes are no longer counted, then the oldest held notes are released, to make room
+     * for new ones, which bounds the processing time whatever is played.
+     *
+     * @param pipes Maximum number of pipes, 0 for no limit (the default)
+     */
+    public static native void setPolyphonyCeiling(int pipes);
+
+    /**
+     * @return Ceiling on the number of pipes sounding for held and releasing keys, 0 for no limit
+     */
+    public static native int getPolyphonyCeiling();
+
+    /**
+     * @return Number of notes released so far to stay within the polyphony ceiling
+     */
+    public static native long getPipeSteals();
+
+    /**
+     * Suspend rendering while the instrument is silent, and resume as soon as anything is played.
+     * On by default.
+     *
+     * @param enabled True to suspend rendering when silent
+     */
+    public static native void setIdleDetection(boolean enabled);
+
+    /**
+     * @return True if rendering is suspended while the instrument is silent
+     */
+    public static native boolean isIdleDetection();
+
+    /**
+     * @return Summary of the periods skipped while silent, for logging
+     */
+    public static native String getIdleSummary();
+
+    /**
+     * Convolve the output with a measured impulse response, read from a WAV file in the impulses
+     * directory of the stops root. The built-in reverb is faded out meanwhile.
+     *
+     * @param name File name of the impulse response, empty to turn the convolution off
+     * @return False if the file cannot be read
+     */
+    public static native boolean setConvolutionReverb(String name);
+
+    /**
+     * @return File names of the impulse responses available for setConvolutionReverb
+     */
+    public static native String[] getImpulseResponses();
+
+    /**
+     * @param wet Linear gain of the convolved signal, added to the dry output (0.5 by default)
+     */
+    public static native void setConvolutionReverbWet(float wet);
+
+    /**
+     * @return Summary of the convolution reverb and its processing time, for logging
+     */
+    public static native String getConvolutionReverbSummary();
+
+    /**
+     * Recorded ranks are listed in the file "sampled" of the instrument directory, each bound to a
+     * stop of the definition, and played from memory-mapped WAV files.
+     *
+     * @return Summary of the recorded ranks and their streaming underruns, for logging
+     */
+    public static native String getSampledRankSummary();
+
+    /**
+     * Offset the pitch of the whole instrument slightly, e.g. to follow the A of an ensemble. Takes
+     * effect within one audio period, without recalculating the wavetables as retune does. The whole
+     * engine output is played at a different rate, so the tremulants and the release of the pipes
+     * change speed with the pitch. Together with the pitch bend, the offset is limited to 400 cents
+     * up or down, see isPitchOffsetLimited.
+     *
+     * @param cents Pitch offset in cents, 0 for none
+     */
+    public static native void setFineTune(float cents);
+
+    /**
+     * @return Pitch offset set with setFineTune, in cents
+     */
+    public static native float getFineTune();
+
+    /**
+     * Apply a MIDI pitch bend to the whole instrument, as setFineTune. Only bends on the channel set
+     * with setPitchBendChannel are applied, bends on other channels are ignored
+     *
+     * @param channel MIDI channel
+     * @param value 14 bit pitch bend value, 8192 for none
+     */
+    public static native void setPitchBend(int channel, int value);
+
+    /**
+     * @param cents Pitch offset of a full pitch bend, up or down (200 cents by default)
+     */
+    public static native void setPitchBendRange(float cents);
+
+    /**
+     * @return True while the sum of fine tuning and pitch bend exceeds 400 cents, up or down, and
+     * the pitch offset is limited to it
+     */
+    public static native boolean isPitchOffsetLimited();
+
+    /**
+     * Set the MIDI channel whose pitch bend is applied (channel 0 by default); a bend in effect is reset
+     *
+     * @param channel MIDI channel (0-15)
+     */
+    public static native void setPitchBendChannel(int channel);
+
+    /**
+     * @return MIDI channel whose pitch bend is applied
+     */
+    public static native int getPitchBendChannel();
 }